@@ -0,0 +1,134 @@
+// Cost of drawing the world at each zoom, headless on a 480x480 screen with
+// 25% walls: tile by tile as before chunk images (a rect and two lines per
+// wall through TransformedView), and as MMOClient's DrawWorld does, from
+// chunk images or past the largest of them tile by tile, with the memory
+// the images take.
+
+#define OLC_PGE_APPLICATION
+#define OLC_PGE_HEADLESS
+#include "../include/olcPixelGameEngine.h"
+#define OLC_PGEX_TRANSFORMEDVIEW
+#include "../include/olcPGEX_TransformedView.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "../MMOClient/MMOChunkRenderCache.h"
+
+constexpr int32_t nScreen = 480;
+
+class BenchChunkDraw : public olc::PixelGameEngine {
+ public:
+  bool OnUserCreate() override { return true; }
+  bool OnUserUpdate(float) override { return false; }
+
+  World world;
+  olc::TileTransformedView tv;
+  ChunkRenderCache cache;
+  JobSystem jobs;
+  std::vector<ChunkRenderCache::sVisible> vVisible;
+
+  void DrawTiles() {
+    olc::vi2d vTL = tv.GetTopLeftTile(), vBR = tv.GetBottomRightTile();
+    olc::vi2d vTile;
+    for (vTile.y = vTL.y; vTile.y < vBR.y; vTile.y++)
+      for (vTile.x = vTL.x; vTile.x < vBR.x; vTile.x++)
+        if (world.GetTile(vTile.x, vTile.y) == Tile_Wall) {
+          tv.DrawRect(vTile, {1.0f, 1.0f}, olc::WHITE);
+          tv.DrawLine(vTile, vTile + olc::vf2d(1.0f, 1.0f), olc::WHITE);
+          tv.DrawLine(vTile + olc::vf2d(0.0f, 1.0f),
+                      vTile + olc::vf2d(1.0f, 0.0f), olc::WHITE);
+        }
+  }
+
+  // MMOClient::DrawWorld.
+  void DrawChunks() {
+    olc::vi2d vTL = tv.GetTopLeftTile(), vBR = tv.GetBottomRightTile();
+    float fPixelsPerTile = tv.GetWorldScale().x;
+    int32_t nShift = ChunkRenderCache::BucketShift(fPixelsPerTile);
+    int32_t nScale =
+        std::max(1, int32_t(fPixelsPerTile / std::ldexp(1.0f, nShift) + 0.5f));
+    olc::vi2d vScreen = {ScreenWidth(), ScreenHeight()};
+
+    vVisible.clear();
+    for (int32_t cy = TileToChunk(vTL.y); cy <= TileToChunk(vBR.y - 1); cy++)
+      for (int32_t cx = TileToChunk(vTL.x); cx <= TileToChunk(vBR.x - 1);
+           cx++)
+        if (const Chunk* chunk = world.FindResidentChunk(cx, cy))
+          vVisible.push_back({ChunkKey(cx, cy), chunk, nullptr});
+
+    if (ChunkRenderCache::DrawsTiles(fPixelsPerTile)) {
+      int32_t nTile = int32_t(fPixelsPerTile + 0.5f);
+      for (const auto& visible : vVisible) {
+        int32_t cx = int32_t(visible.nKey >> 32);
+        int32_t cy = int32_t(uint32_t(visible.nKey));
+        cache.DrawTiles(*this, visible,
+                        tv.WorldToScreen({float(cx * nChunkSize),
+                                          float(cy * nChunkSize)}),
+                        nTile);
+      }
+      cache.EndFrame();
+      return;
+    }
+
+    cache.Prepare(vVisible, nShift, jobs);
+    for (const auto& visible : vVisible) {
+      int32_t cx = int32_t(visible.nKey >> 32);
+      int32_t cy = int32_t(uint32_t(visible.nKey));
+      olc::vi2d vOrigin = tv.WorldToScreen(
+          {float(cx * nChunkSize), float(cy * nChunkSize)});
+      olc::Sprite* sprite = cache.Get(visible, nShift);
+      olc::vi2d vFrom = (-vOrigin / nScale).max({0, 0});
+      olc::vi2d vTo =
+          ((vScreen - vOrigin + olc::vi2d(nScale - 1, nScale - 1)) / nScale)
+              .min({sprite->width, sprite->height});
+      if (vTo.x <= vFrom.x || vTo.y <= vFrom.y) continue;
+      DrawPartialSprite(vOrigin + vFrom * nScale, sprite, vFrom, vTo - vFrom,
+                        nScale);
+    }
+    cache.EndFrame();
+  }
+
+  template <typename F>
+  double FrameTime(F&& fDraw) {
+    Clear(olc::BLACK);
+    fDraw();
+    int nFrames = 0;
+    auto tpStart = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed{};
+    while (nFrames < 5 || elapsed.count() < 200.0) {
+      Clear(olc::BLACK);
+      fDraw();
+      nFrames++;
+      elapsed = std::chrono::steady_clock::now() - tpStart;
+    }
+    return elapsed.count() / nFrames;
+  }
+};
+
+int main() {
+  BenchChunkDraw bench;
+  if (!bench.Construct(nScreen, nScreen, 1, 1)) return 1;
+  olc::Sprite target(nScreen, nScreen);
+  bench.SetDrawTarget(&target);
+  bench.tv = olc::TileTransformedView({nScreen, nScreen}, {8, 8});
+
+  std::mt19937 rng(1);
+  for (int32_t y = -600; y < 600; y++)
+    for (int32_t x = -600; x < 600; x++)
+      if (rng() % 4 == 0) bench.world.SetTile(x, y, Tile_Wall);
+
+  std::printf("%8s %10s %10s %10s\n", "px/tile", "per-tile", "cached",
+              "cache KB");
+  for (float fZoom : {64.0f, 32.0f, 16.0f, 8.0f, 4.0f, 1.0f, 0.5f}) {
+    bench.tv.SetWorldScale({fZoom, fZoom});
+    bench.tv.SetWorldOffset({-3.3f, -7.7f});
+    double fTiles = bench.FrameTime([&]() { bench.DrawTiles(); });
+    double fCached = bench.FrameTime([&]() { bench.DrawChunks(); });
+    std::printf("%8.1f %10.3f %10.3f %10zu\n", fZoom, fTiles, fCached,
+                bench.cache.MemoryUsage() / 1024);
+  }
+  std::printf("times in ms per frame\n");
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Cost of queueing 50k decals a frame and flushing them to the renderer,
+// headless, and the heap allocations it makes. A quarter each are plain,
+// partial, rotated and filled rect decals. The headless renderer drops what
+// it is given, so this is the engine's own per-decal cost.
+
+#define OLC_PGE_APPLICATION
+#define OLC_PGE_HEADLESS
+#include "../include/olcPixelGameEngine.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> nAllocations{0};
+
+void* operator new(size_t nSize) {
+  nAllocations++;
+  if (void* p = std::malloc(nSize)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+using Clock = std::chrono::steady_clock;
+
+class BenchDecals : public olc::PixelGameEngine {
+ public:
+  bool OnUserCreate() override {
+    renderable.Create(16, 16);
+    return true;
+  }
+
+  bool OnUserUpdate(float) override {
+    auto tp0 = Clock::now();
+    size_t nAllocationsBefore = nAllocations;
+    for (int i = 0; i < nDecals; i++) {
+      olc::vf2d vPos = {float(i % 300), float((i / 300) % 200)};
+      switch (i % 4) {
+        case 0:
+          DrawDecal(vPos, renderable.Decal());
+          break;
+        case 1:
+          DrawPartialDecal(vPos, renderable.Decal(), {2, 2}, {8, 8});
+          break;
+        case 2:
+          DrawRotatedDecal(vPos, renderable.Decal(), i * 0.01f, {8, 8});
+          break;
+        case 3:
+          FillRectDecal(vPos, {4, 4}, olc::RED);
+          break;
+      }
+    }
+    auto tp1 = Clock::now();
+    adv_FlushLayerDecals(0);
+    auto tp2 = Clock::now();
+
+    // The first frames grow the queues to size.
+    if (nFrame++ >= 5) {
+      fQueue = std::min(fQueue, Millis(tp0, tp1));
+      fTotal = std::min(fTotal, Millis(tp0, tp2));
+      nFrameAllocations = nAllocations - nAllocationsBefore;
+    }
+    return nFrame < 60;
+  }
+
+  static constexpr int nDecals = 50000;
+  int nFrame = 0;
+  double fQueue = 1e9, fTotal = 1e9;
+  size_t nFrameAllocations = 0;
+
+ private:
+  static double Millis(Clock::time_point tp0, Clock::time_point tp1) {
+    return std::chrono::duration<double, std::milli>(tp1 - tp0).count();
+  }
+
+  olc::Renderable renderable;
+};
+
+int main() {
+  BenchDecals bench;
+  if (!bench.Construct(320, 240, 1, 1)) return 1;
+  bench.Start();
+  std::printf("%d decals: queue %.2f ms, queue + flush %.2f ms, "
+              "%zu allocations per frame\n",
+              BenchDecals::nDecals, bench.fQueue, bench.fTotal,
+              bench.nFrameAllocations);
+  return 0;
+}
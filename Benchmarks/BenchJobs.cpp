@@ -0,0 +1,76 @@
+// Server tick work on the job system at 1 to 8 threads, and what waiting
+// costs.
+//
+// The tick is entity integration over a parallel-for, as in the game
+// server. The wait cost is the CPU time the main thread uses while it waits
+// for a job that is running on a worker. A waiter that spins takes that
+// time from the workers doing the real work.
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "../MMOServer/MMOEntities.h"
+#include "../MMOServer/MMOJobs.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double ThreadCpuMillis() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main() {
+  constexpr size_t nEntities = 1000000;
+  constexpr size_t nGrain = 16384;
+  EntityStore entities;
+  for (size_t n = 0; n < nEntities; n++) {
+    entities.Create();
+    entities.vVelX.back() = float(n % 7) - 3.0f;
+    entities.vVelY.back() = float(n % 5) - 2.0f;
+  }
+
+  std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  std::printf("%8s %14s %16s %16s\n", "threads", "integrate 1M",
+              "wait, wall ms", "wait, CPU ms");
+  for (size_t nThreads : {1, 2, 4, 8}) {
+    JobSystem jobs(nThreads - 1);
+
+    constexpr int nTicks = 50;
+    uint64_t nNow = 0;
+    auto tp0 = Clock::now();
+    for (int t = 0; t < nTicks; t++) {
+      nNow += 50000;
+      jobs.ParallelFor(0, entities.Size(), nGrain,
+                       [&](size_t nBegin, size_t nEnd) {
+                         entities.Integrate(nNow, nBegin, nEnd);
+                       });
+    }
+    double fTick =
+        std::chrono::duration<double, std::milli>(Clock::now() - tp0).count() /
+        nTicks;
+
+    // A 20ms job, given time to be taken by a worker before we wait on it.
+    double fWall = 0.0, fCpu = 0.0;
+    if (nThreads > 1) {
+      auto job = jobs.Run([]() {
+        auto tpEnd = Clock::now() + std::chrono::milliseconds(20);
+        while (Clock::now() < tpEnd) {
+        }
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      double fCpu0 = ThreadCpuMillis();
+      auto tpWait = Clock::now();
+      jobs.Wait(job);
+      fWall = std::chrono::duration<double, std::milli>(Clock::now() - tpWait)
+                  .count();
+      fCpu = ThreadCpuMillis() - fCpu0;
+    }
+    std::printf("%8zu %11.2f ms %16.2f %16.2f\n", nThreads, fTick, fWall,
+                fCpu);
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Cost of keeping the light up to date: lighting an area from scratch, and
+// the incremental floods for single tile edits and for a tick's worth of
+// them, with the light bytes each sends. Incremental results are checked
+// against lighting the same world from scratch.
+//
+// The area is 8 x 8 chunks of floor with random walls and a lamp every 6
+// tiles.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../MMOServer/MMOLighting.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int32_t nChunks = 8;
+constexpr int32_t nSide = nChunks * nChunkSize;
+
+static double Micros(Clock::time_point tp0, Clock::time_point tp1) {
+  return std::chrono::duration<double, std::micro>(tp1 - tp0).count();
+}
+
+static void LightAll(LightEngine& light, const World& world) {
+  for (int32_t cy = 0; cy < nChunks; cy++)
+    for (int32_t cx = 0; cx < nChunks; cx++) light.OnChunkLoaded(cx, cy);
+  light.Update(world);
+}
+
+static bool SameLight(LightEngine& a, LightEngine& b) {
+  for (int32_t y = 0; y < nSide; y++)
+    for (int32_t x = 0; x < nSide; x++)
+      if (a.Level(x, y) != b.Level(x, y)) return false;
+  return true;
+}
+
+// Bytes of light messages the queued changes turn into.
+static size_t SendChanges(LightEngine& light) {
+  size_t nBytes = 0;
+  light.ConsumeChanges([&](const sLightDataHeader& header,
+                           const std::vector<uint8_t>& vBody) {
+    nBytes += sizeof(header) + vBody.size();
+  });
+  return nBytes;
+}
+
+int main() {
+  World world;
+  std::mt19937 rng(1);
+  for (int32_t y = 0; y < nSide; y++)
+    for (int32_t x = 0; x < nSide; x++) {
+      Tile tile = Tile_Floor;
+      if (x % 6 == 3 && y % 6 == 3)
+        tile = Tile_Lamp;
+      else if (rng() % 8 == 0)
+        tile = Tile_Wall;
+      world.SetTile(x, y, tile);
+    }
+
+  LightEngine light;
+  auto tp0 = Clock::now();
+  LightAll(light, world);
+  auto tp1 = Clock::now();
+  SendChanges(light);
+  std::printf("light %d chunks from scratch: %.2f ms\n", nChunks * nChunks,
+              Micros(tp0, tp1) / 1000.0);
+
+  // Edits toggle a wall or a lamp somewhere away from the area's edge.
+  std::uniform_int_distribution<int32_t> pos(8, nSide - 9);
+  auto Edit = [&]() {
+    int32_t x = pos(rng), y = pos(rng);
+    Tile tile = world.GetTile(x, y);
+    Tile next = rng() % 2 ? (tile == Tile_Wall ? Tile_Floor : Tile_Wall)
+                          : (tile == Tile_Lamp ? Tile_Floor : Tile_Lamp);
+    world.SetTile(x, y, next);
+    light.OnTileChanged(x, y);
+  };
+
+  constexpr int nEdits = 2000;
+  double fEdit = 0.0;
+  size_t nBytes = 0;
+  uint64_t nVisited = light.nVisited;
+  for (int n = 0; n < nEdits; n++) {
+    Edit();
+    tp0 = Clock::now();
+    light.Update(world);
+    fEdit += Micros(tp0, Clock::now());
+    nBytes += SendChanges(light);
+  }
+  std::printf(
+      "single edit: %.2f us, %.0f tiles visited, %.0f bytes sent each\n",
+      fEdit / nEdits, double(light.nVisited - nVisited) / nEdits,
+      double(nBytes) / nEdits);
+
+  constexpr int nTicks = 50, nEditsPerTick = 64;
+  double fTick = 0.0;
+  nBytes = 0;
+  for (int t = 0; t < nTicks; t++) {
+    for (int n = 0; n < nEditsPerTick; n++) Edit();
+    tp0 = Clock::now();
+    light.Update(world);
+    fTick += Micros(tp0, Clock::now());
+    nBytes += SendChanges(light);
+  }
+  std::printf("%d edits in one tick: %.1f us, %.0f bytes sent\n",
+              nEditsPerTick, fTick / nTicks, double(nBytes) / nTicks);
+
+  LightEngine fresh;
+  LightAll(fresh, world);
+  bool bSame = SameLight(light, fresh);
+  std::printf("incremental light %s a recompute\n",
+              bSame ? "matches" : "DIFFERS from");
+  return bSame ? 0 : 1;
+}
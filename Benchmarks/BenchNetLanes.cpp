@@ -0,0 +1,128 @@
+// Echo latency while a bulk transfer saturates the connection.
+//
+// The server sends 8 x 8MB on the bulk lane while the client sends a
+// timestamp every 2ms that the server echoes back through its update loop.
+// Run once with the echo on the high lane and once on the bulk lane, which
+// behaves like the old single FIFO:
+//
+//   BenchNetLanes high
+//   BenchNetLanes bulk
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../NetCommon/olc_net.h"
+
+enum class BenchMsg : uint32_t { Echo, Bulk, Go };
+
+constexpr uint16_t nPort = 60101;
+constexpr int nBulkMessages = 8;
+constexpr size_t nBulkSize = 8 << 20;
+
+class BenchServer : public olc::net::server_interface<BenchMsg> {
+ public:
+  BenchServer(olc::net::priority echoLane)
+      : olc::net::server_interface<BenchMsg>(nPort), echoLane(echoLane) {
+    for (int i = 0; i < nBulkMessages; i++) {
+      olc::net::message<BenchMsg> msg;
+      msg.header.id = BenchMsg::Bulk;
+      msg.body.assign(nBulkSize, 1);
+      vBulk.push_back(std::move(msg));
+    }
+  }
+
+ protected:
+  bool OnClientConnect(
+      std::shared_ptr<olc::net::connection<BenchMsg>>) override {
+    return true;
+  }
+
+  void OnMessage(std::shared_ptr<olc::net::connection<BenchMsg>> client,
+                 olc::net::message<BenchMsg>& msg) override {
+    if (msg.header.id == BenchMsg::Go) {
+      for (auto& bulk : vBulk)
+        client->Send(std::move(bulk), olc::net::priority::bulk);
+    } else if (msg.header.id == BenchMsg::Echo) {
+      client->Send(msg, echoLane);
+    }
+  }
+
+ private:
+  olc::net::priority echoLane;
+  std::vector<olc::net::message<BenchMsg>> vBulk;
+};
+
+class BenchClient : public olc::net::client_interface<BenchMsg> {
+ public:
+  BenchClient() { SetMaxMessageSize(BenchMsg::Bulk, nBulkSize); }
+};
+
+int main(int argc, char* argv[]) {
+  bool bHigh = argc < 2 || std::strcmp(argv[1], "bulk") != 0;
+  olc::net::priority echoLane =
+      bHigh ? olc::net::priority::high : olc::net::priority::bulk;
+
+  BenchServer server(echoLane);
+  server.Start();
+  // The server is never stopped; the process exits from under it.
+  std::thread([&server]() {
+    while (true) server.Update(-1, true);
+  }).detach();
+
+  BenchClient client;
+  client.Connect("127.0.0.1", nPort);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  olc::net::message<BenchMsg> go;
+  go.header.id = BenchMsg::Go;
+  client.Send(go);
+
+  // Echoes stop with the transfer, but the ones still queued behind it are
+  // waited for, as they are the slowest.
+  std::vector<double> vLatency;
+  int nBulk = 0;
+  size_t nEchoes = 0;
+  int64_t nStart = olc::net::SteadyMicroseconds();
+  int64_t nTransfer = 0;
+  int64_t nLastEcho = 0;
+  while ((nBulk < nBulkMessages || vLatency.size() < nEchoes) &&
+         client.isConnected()) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    int64_t nNow = olc::net::SteadyMicroseconds();
+    if (nBulk < nBulkMessages && nNow - nLastEcho > 2000) {
+      olc::net::message<BenchMsg> echo;
+      echo.header.id = BenchMsg::Echo;
+      echo << nNow;
+      client.Send(std::move(echo), olc::net::priority::high);
+      nLastEcho = nNow;
+      nEchoes++;
+    }
+
+    while (!client.Incoming().empty()) {
+      auto msg = client.Incoming().pop_front().msg;
+      if (msg.header.id == BenchMsg::Bulk) {
+        if (++nBulk == nBulkMessages)
+          nTransfer = olc::net::SteadyMicroseconds() - nStart;
+      } else {
+        int64_t nSent = 0;
+        msg >> nSent;
+        vLatency.push_back((olc::net::SteadyMicroseconds() - nSent) / 1000.0);
+      }
+    }
+  }
+
+  std::sort(vLatency.begin(), vLatency.end());
+  if (vLatency.empty()) vLatency.push_back(0.0);
+  std::printf(
+      "echo on %s lane: %dMB in %.1fms, %zu echoes, median %.2fms, p99 "
+      "%.2fms, max %.2fms\n",
+      bHigh ? "high" : "bulk", int(nBulkMessages * (nBulkSize >> 20)),
+      nTransfer / 1000.0,
+      vLatency.size(), vLatency[vLatency.size() / 2],
+      vLatency[vLatency.size() * 99 / 100], vLatency.back());
+  std::fflush(stdout);
+  std::_Exit(0);
+}
@@ -0,0 +1,146 @@
+// Cost of a path search with Pathfinder against plain A* over every tile,
+// and how much a tile change throws away.
+//
+// The world is 512 x 512 tiles of 16 x 16 rooms joined by doors, with 12% of
+// the remaining floor walled off at random. Paths are checked for being
+// walkable, and their length is compared to the plain A* one, which is
+// optimal.
+
+#include <chrono>
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../MMOServer/MMOPathfinding.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int32_t nSide = 512;
+constexpr int nQueries = 500;
+
+static double MillisPerPath(Clock::time_point tp0, Clock::time_point tp1) {
+  return std::chrono::duration<double, std::milli>(tp1 - tp0).count() /
+         nQueries;
+}
+
+// Outside the map is wall, so neither search wanders off it.
+static bool Open(World& world, int32_t x, int32_t y) {
+  return x >= 0 && y >= 0 && x < nSide && y < nSide && !world.IsSolid(x, y);
+}
+
+// Length in steps of the shortest path, -1 if there is none.
+static int32_t PlainAStar(World& world, sTilePos start, sTilePos goal) {
+  using Item = std::pair<int32_t, int32_t>;  // f, tile index
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> qOpen;
+  std::vector<int32_t> vCost(nSide * nSide, -1);
+  auto H = [&](int32_t x, int32_t y) {
+    return std::abs(x - goal.x) + std::abs(y - goal.y);
+  };
+  vCost[start.y * nSide + start.x] = 0;
+  qOpen.push({H(start.x, start.y), start.y * nSide + start.x});
+  while (!qOpen.empty()) {
+    auto [f, n] = qOpen.top();
+    qOpen.pop();
+    int32_t x = n % nSide, y = n / nSide;
+    if (f - H(x, y) > vCost[n]) continue;
+    if (x == goal.x && y == goal.y) return vCost[n];
+    const int32_t dx[] = {1, -1, 0, 0}, dy[] = {0, 0, 1, -1};
+    for (int d = 0; d < 4; d++) {
+      int32_t nx = x + dx[d], ny = y + dy[d];
+      if (!Open(world, nx, ny)) continue;
+      int32_t m = ny * nSide + nx;
+      if (vCost[m] >= 0 && vCost[m] <= vCost[n] + 1) continue;
+      vCost[m] = vCost[n] + 1;
+      qOpen.push({vCost[m] + H(nx, ny), m});
+    }
+  }
+  return -1;
+}
+
+static bool Walkable(World& world, const std::vector<sTilePos>& vPath) {
+  for (size_t i = 0; i < vPath.size(); i++) {
+    if (!Open(world, vPath[i].x, vPath[i].y)) return false;
+    if (i > 0 && std::abs(vPath[i].x - vPath[i - 1].x) +
+                         std::abs(vPath[i].y - vPath[i - 1].y) !=
+                     1)
+      return false;
+  }
+  return true;
+}
+
+int main() {
+  World world;
+  std::mt19937 rng(1);
+  for (int32_t y = -nChunkSize; y < nSide + nChunkSize; y++)
+    for (int32_t x = -nChunkSize; x < nSide + nChunkSize; x++) {
+      bool bInside = x >= 0 && y >= 0 && x < nSide && y < nSide;
+      bool bRoomWall = x % 16 == 0 || y % 16 == 0;
+      bool bDoor = (x % 16 == 8) != (y % 16 == 8);
+      bool bWall = !bInside || (bRoomWall && !bDoor) ||
+                   (!bRoomWall && rng() % 100 < 12);
+      if (bWall) world.SetTile(x, y, Tile_Wall);
+    }
+
+  auto RandomQueries = [&]() {
+    std::vector<std::pair<sTilePos, sTilePos>> vQueries;
+    while (vQueries.size() < nQueries) {
+      sTilePos a{int32_t(rng() % nSide), int32_t(rng() % nSide)};
+      sTilePos b{int32_t(rng() % nSide), int32_t(rng() % nSide)};
+      if (Open(world, a.x, a.y) && Open(world, b.x, b.y))
+        vQueries.push_back({a, b});
+    }
+    return vQueries;
+  };
+  auto vCold = RandomQueries(), vWarm = RandomQueries();
+
+  auto tp0 = Clock::now();
+  std::vector<int32_t> vOptimal;
+  for (auto& [a, b] : vWarm) vOptimal.push_back(PlainAStar(world, a, b));
+  auto tp1 = Clock::now();
+  std::printf("plain grid A*      %7.3f ms/path\n", MillisPerPath(tp0, tp1));
+
+  Pathfinder pathfinder;
+  pathfinder.nMaxExpansions = 1 << 20;
+  std::vector<sTilePos> vPath;
+  tp0 = Clock::now();
+  for (auto& [a, b] : vCold) pathfinder.FindPath(world, a, b, vPath);
+  tp1 = Clock::now();
+  std::printf("HPA*, cold         %7.3f ms/path (%zu cluster builds)\n",
+              MillisPerPath(tp0, tp1), pathfinder.nClusterBuilds);
+
+  // New endpoints over clusters that are already built.
+  size_t nBad = 0, nSteps = 0, nOptimalSteps = 0;
+  tp0 = Clock::now();
+  for (int q = 0; q < nQueries; q++) {
+    auto [a, b] = vWarm[q];
+    bool bFound = pathfinder.FindPath(world, a, b, vPath);
+    if (bFound != (vOptimal[q] >= 0)) nBad++;
+    if (!bFound) continue;
+    if (!Walkable(world, vPath) || vPath.front() != a || vPath.back() != b)
+      nBad++;
+    nSteps += vPath.size() - 1;
+    nOptimalSteps += size_t(vOptimal[q]);
+  }
+  tp1 = Clock::now();
+  std::printf("HPA*, warm graph   %7.3f ms/path\n", MillisPerPath(tp0, tp1));
+
+  tp0 = Clock::now();
+  for (auto& [a, b] : vWarm) pathfinder.FindPath(world, a, b, vPath);
+  tp1 = Clock::now();
+  std::printf("cached             %7.3f ms/path\n", MillisPerPath(tp0, tp1));
+  std::printf("%zu bad paths, mean length %.3fx optimal\n", nBad,
+              double(nSteps) / double(nOptimalSteps));
+
+  // A door in the middle of the map closes.
+  size_t nBuildsBefore = pathfinder.nClusterBuilds;
+  size_t nSearchesBefore = pathfinder.nSearches;
+  world.SetTile(256 + 8, 256, Tile_Wall);
+  for (auto& [a, b] : vWarm) pathfinder.FindPath(world, a, b, vPath);
+  std::printf("one tile changed: %zu clusters rebuilt, %zu of %d paths "
+              "searched again\n",
+              pathfinder.nClusterBuilds - nBuildsBefore,
+              pathfinder.nSearches - nSearchesBefore, nQueries);
+  return nBad ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+// Cost of keeping the spatial hash up to date and of querying it, at 1k, 10k
+// and 100k entities, and of checking player moves against the tile world.
+//
+// Entities are spread at a constant density of one per 16 tiles, so query
+// results stay the same size as the world grows. Every query is checked
+// against a brute force scan over all positions.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../MMOServer/MMOSpatial.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double Micros(Clock::time_point tp0, Clock::time_point tp1) {
+  return std::chrono::duration<double, std::micro>(tp1 - tp0).count();
+}
+
+static void BenchEntities(size_t nEntities) {
+  EntityStore entities;
+  SpatialHash spatial;
+  float fSide = std::sqrt(float(nEntities) * 16.0f);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> pos(0.0f, fSide), step(-0.5f, 0.5f);
+  for (size_t n = 0; n < nEntities; n++) {
+    entities.Create();
+    entities.vPosX.back() = pos(rng);
+    entities.vPosY.back() = pos(rng);
+    spatial.Insert(entities.vID.back(), entities.vPosX.back(),
+                   entities.vPosY.back());
+  }
+
+  // One server tick: every entity moves a little and the index follows.
+  constexpr int nTicks = 20;
+  double fMove = 0.0;
+  for (int t = 0; t < nTicks; t++) {
+    for (size_t i = 0; i < entities.Size(); i++) {
+      entities.vPosX[i] += step(rng);
+      entities.vPosY[i] += step(rng);
+    }
+    auto tp0 = Clock::now();
+    for (size_t i = 0; i < entities.Size(); i++)
+      spatial.Move(entities.vID[i], entities.vPosX[i], entities.vPosY[i]);
+    fMove += Micros(tp0, Clock::now());
+  }
+
+  constexpr int nQueries = 1000;
+  std::vector<float> vX(nQueries), vY(nQueries);
+  for (int q = 0; q < nQueries; q++) {
+    vX[q] = pos(rng);
+    vY[q] = pos(rng);
+  }
+  std::vector<EntityID> vFound(nEntities);
+  size_t nFound = 0, nExpected = 0;
+
+  auto tp0 = Clock::now();
+  for (int q = 0; q < nQueries; q++)
+    nFound += spatial.QueryAABB(vX[q] - 8.0f, vY[q] - 8.0f, vX[q] + 8.0f,
+                                vY[q] + 8.0f, vFound.data(), vFound.size());
+  auto tp1 = Clock::now();
+  for (int q = 0; q < nQueries; q++)
+    nFound += spatial.QueryRadius(vX[q], vY[q], 8.0f, vFound.data(),
+                                  vFound.size());
+  auto tp2 = Clock::now();
+  for (int q = 0; q < nQueries; q++)
+    for (size_t i = 0; i < entities.Size(); i++) {
+      float x = entities.vPosX[i], y = entities.vPosY[i];
+      float dx = x - vX[q], dy = y - vY[q];
+      nExpected += x >= vX[q] - 8.0f && x < vX[q] + 8.0f &&
+                   y >= vY[q] - 8.0f && y < vY[q] + 8.0f;
+      nExpected += dx * dx + dy * dy <= 64.0f;
+    }
+  auto tp3 = Clock::now();
+
+  std::printf(
+      "%7zu entities: move all %8.1f us/tick, AABB 16x16 %5.2f us, "
+      "radius 8 %5.2f us, brute force %6.1f us%s\n",
+      nEntities, fMove / nTicks, Micros(tp0, tp1) / nQueries,
+      Micros(tp1, tp2) / nQueries, Micros(tp2, tp3) / nQueries,
+      nFound == nExpected ? "" : " MISMATCH");
+}
+
+// Player updates are swept through the world so fast moves cannot pass
+// through walls. Cost per update by move length, over 25% walls.
+static void BenchMoves() {
+  World world;
+  std::mt19937 rng(2);
+  for (int32_t y = 0; y < 256; y++)
+    for (int32_t x = 0; x < 256; x++)
+      if (rng() % 4 == 0) world.SetTile(x, y, Tile_Wall);
+
+  std::uniform_real_distribution<float> pos(64.0f, 192.0f), dir(-1.0f, 1.0f);
+  for (float fLength : {0.25f, 1.0f, 4.0f, 32.0f}) {
+    constexpr int nMoves = 100000;
+    int nBlocked = 0;
+    auto tp0 = Clock::now();
+    for (int m = 0; m < nMoves; m++) {
+      float x = pos(rng), y = pos(rng);
+      nBlocked += SweepHitsSolid(world, x, y, x + dir(rng) * fLength,
+                                 y + dir(rng) * fLength);
+    }
+    std::printf("move up to %5.2f tiles: %6.3f us per update, %4.1f%% "
+                "blocked\n",
+                fLength, Micros(tp0, Clock::now()) / nMoves,
+                100.0 * nBlocked / nMoves);
+  }
+}
+
+int main() {
+  for (size_t nEntities : {1000, 10000, 100000}) BenchEntities(nEntities);
+  BenchMoves();
+  return 0;
+}
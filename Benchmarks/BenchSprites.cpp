@@ -0,0 +1,90 @@
+// Sprites drawn per second, headless onto a 1920x1080 target, for each pixel
+// mode with and without scaling and flipping. 32x32 sprites are drawn over
+// a 480x480 area so the target stays in cache, as in a game's play field.
+// The sprite has opaque, clear and half transparent pixels.
+
+#define OLC_PGE_APPLICATION
+#define OLC_PGE_HEADLESS
+#include "../include/olcPixelGameEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+class BenchSprites : public olc::PixelGameEngine {
+ public:
+  bool OnUserCreate() override { return true; }
+  bool OnUserUpdate(float) override { return false; }
+};
+
+// Calls per second of fDraw(n), the best of a few runs since other load
+// on the machine only ever slows them down.
+template <typename F>
+static double CallsPerSecond(F&& fDraw) {
+  double fBest = 0.0;
+  int n = 0;
+  for (int nRun = 0; nRun < 5; nRun++) {
+    int nCalls = 0;
+    auto tpStart = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (nCalls < 1000 || elapsed.count() < 0.05) {
+      for (int i = 0; i < 100; i++, nCalls++) fDraw(n++);
+      elapsed = std::chrono::steady_clock::now() - tpStart;
+    }
+    fBest = std::max(fBest, nCalls / elapsed.count());
+  }
+  return fBest;
+}
+
+static void Randomize(olc::Sprite& sprite, std::mt19937& rng) {
+  for (int32_t y = 0; y < sprite.height; y++)
+    for (int32_t x = 0; x < sprite.width; x++) {
+      uint32_t n = rng() | 0xFF000000;
+      if (rng() % 4 == 0) n &= 0x00FFFFFF;
+      if (rng() % 4 == 0) n = (n & 0x00FFFFFF) | 0x80000000;
+      sprite.SetPixel(x, y, olc::Pixel(n));
+    }
+}
+
+int main() {
+  BenchSprites bench;
+  if (!bench.Construct(320, 240, 1, 1)) return 1;
+  olc::Sprite target(1920, 1080);
+  bench.SetDrawTarget(&target);
+
+  std::mt19937 rng(3);
+  olc::Sprite sprite(32, 32), big(256, 256);
+  Randomize(sprite, rng);
+  Randomize(big, rng);
+
+  struct sMode {
+    const char* sName;
+    olc::Pixel::Mode mode;
+  };
+  const sMode vModes[] = {{"NORMAL", olc::Pixel::NORMAL},
+                          {"MASK", olc::Pixel::MASK},
+                          {"ALPHA", olc::Pixel::ALPHA}};
+  std::printf("M sprites/s   %10s %10s %10s %10s\n", "x1", "x1 flip", "x2",
+              "x2 flip");
+  for (const sMode& mode : vModes) {
+    bench.SetPixelMode(mode.mode);
+    std::printf("%-13s", mode.sName);
+    for (uint32_t nScale : {1u, 2u})
+      for (uint8_t nFlip : {olc::Sprite::NONE, olc::Sprite::HORIZ}) {
+        double fRate = CallsPerSecond([&](int n) {
+          bench.DrawSprite((n * 37) % 448, (n * 101) % 448, &sprite, nScale,
+                           nFlip);
+        });
+        std::printf(" %10.2f", fRate / 1e6);
+      }
+    std::printf("\n");
+  }
+
+  bench.SetPixelMode(olc::Pixel::NORMAL);
+  double fRate = CallsPerSecond([&](int n) {
+    bench.DrawPartialSprite(n % 100 - 50, 0, &big, 0, 0, 256, 256, 4);
+  });
+  std::printf("DrawPartialSprite 256x256 at x4, partly clipped: %.0f MPix/s\n",
+              fRate * 1024.0 * 1024.0 / 1e6);
+  return 0;
+}
@@ -0,0 +1,108 @@
+// Textured triangles filled per second by FillTexturedTriangles, headless on
+// a 1920x1080 target. A scene is 10k random triangles over a 256x256
+// texture, drawn at 1, 2, 4 and 8 raster threads. Frames must be the same
+// at every thread count.
+
+#define OLC_PGE_APPLICATION
+#define OLC_PGE_HEADLESS
+#include "../include/olcPixelGameEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr int32_t nWidth = 1920, nHeight = 1080;
+constexpr size_t nTriangles = 10000;
+
+class BenchTriangles : public olc::PixelGameEngine {
+ public:
+  bool OnUserCreate() override { return true; }
+  bool OnUserUpdate(float) override { return false; }
+};
+
+// Triangles about fSize pixels across, scattered over the screen and a
+// little beyond.
+static std::vector<olc::TexturedVertex> MakeScene(float fSize, bool bTint) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<olc::TexturedVertex> vVertices;
+  for (size_t n = 0; n < nTriangles; n++) {
+    float cx = unit(rng) * (nWidth + 80) - 40;
+    float cy = unit(rng) * (nHeight + 80) - 40;
+    for (int k = 0; k < 3; k++) {
+      olc::TexturedVertex vertex;
+      vertex.pos = {cx + (unit(rng) - 0.5f) * fSize,
+                    cy + (unit(rng) - 0.5f) * fSize};
+      vertex.uv = {unit(rng), unit(rng)};
+      if (bTint) vertex.col = olc::Pixel(rng() | 0xFF000000);
+      vVertices.push_back(vertex);
+    }
+  }
+  return vVertices;
+}
+
+// Milliseconds per frame, the best of a few.
+template <typename F>
+static double FrameMillis(F&& fDraw) {
+  fDraw();
+  double fBest = 1e9;
+  for (int n = 0; n < 5; n++) {
+    auto tpStart = std::chrono::steady_clock::now();
+    fDraw();
+    fBest = std::min(fBest, std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - tpStart)
+                                .count());
+  }
+  return fBest;
+}
+
+int main() {
+  BenchTriangles bench;
+  if (!bench.Construct(320, 240, 1, 1)) return 1;
+  olc::Sprite target(nWidth, nHeight);
+  bench.SetDrawTarget(&target);
+  const size_t nTarget = size_t(nWidth) * nHeight;
+
+  std::mt19937 rng(3);
+  olc::Sprite texture(256, 256);
+  for (int32_t y = 0; y < texture.height; y++)
+    for (int32_t x = 0; x < texture.width; x++)
+      texture.SetPixel(x, y, olc::Pixel(rng() | 0xFF000000));
+
+  std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  std::printf("%-26s %8s %8s %8s %8s   (M triangles/s)\n", "10k triangles",
+              "1", "2", "4", "8");
+  bool bSame = true;
+  for (float fSize : {40.0f, 200.0f})
+    for (bool bTint : {false, true})
+      for (bool bFilter : {false, true}) {
+        auto vVertices = MakeScene(fSize, bTint);
+        char sName[64];
+        std::snprintf(sName, sizeof(sName), "~%.0fpx%s%s", fSize,
+                      bTint ? ", tinted" : "", bFilter ? ", bilinear" : "");
+        std::printf("%-26s", sName);
+
+        std::vector<olc::Pixel> vReference;
+        for (uint32_t nThreads : {1u, 2u, 4u, 8u}) {
+          bench.SetRasterThreads(nThreads);
+          double fMillis = FrameMillis([&]() {
+            bench.Clear(olc::BLACK);
+            bench.FillTexturedTriangles(vVertices, &texture,
+                                        olc::DecalStructure::LIST, bFilter);
+          });
+          std::printf(" %8.2f", nTriangles / fMillis / 1e3);
+
+          std::vector<olc::Pixel> vFrame(target.GetData(),
+                                         target.GetData() + nTarget);
+          if (vReference.empty())
+            vReference = std::move(vFrame);
+          else
+            bSame &= vFrame == vReference;
+        }
+        std::printf("\n");
+      }
+  std::printf("frames at every thread count %s\n",
+              bSame ? "match" : "DIFFER");
+  return bSame ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// Chunks generated per second, with the plain and the AVX2 noise kernels
+// and over 1 to 8 threads, and a check that every way gives the same
+// chunks.
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../MMOServer/MMOWorldGen.h"
+
+using Clock = std::chrono::steady_clock;
+using Coords = std::vector<std::pair<int32_t, int32_t>>;
+
+static double ChunksPerSecond(const WorldGenerator& generator,
+                              const Coords& vCoords, JobSystem& jobs) {
+  generator.GenerateMany(vCoords, jobs);
+  auto tp0 = Clock::now();
+  constexpr int nRuns = 3;
+  for (int n = 0; n < nRuns; n++) generator.GenerateMany(vCoords, jobs);
+  double fSeconds = std::chrono::duration<double>(Clock::now() - tp0).count();
+  return nRuns * vCoords.size() / fSeconds;
+}
+
+static bool SameChunks(const std::vector<std::unique_ptr<Chunk>>& vA,
+                       const std::vector<std::unique_ptr<Chunk>>& vB) {
+  for (size_t i = 0; i < vA.size(); i++)
+    for (int32_t ly = 0; ly < nChunkSize; ly++)
+      for (int32_t lx = 0; lx < nChunkSize; lx++)
+        if (vA[i]->Get(lx, ly) != vB[i]->Get(lx, ly)) return false;
+  return true;
+}
+
+int main() {
+  Coords vCoords;
+  for (int32_t cy = -16; cy < 16; cy++)
+    for (int32_t cx = -16; cx < 16; cx++) vCoords.push_back({cx, cy});
+
+  WorldGenerator plain(12345), simd(12345);
+  plain.bSimd = false;
+  JobSystem serial(0);
+  std::printf("AVX2 %s\n",
+              WorldGenerator::HasSimd() ? "available" : "not available");
+  bool bSame = SameChunks(plain.GenerateMany(vCoords, serial),
+                          simd.GenerateMany(vCoords, serial));
+  std::printf("%zu chunks per batch, plain and AVX2 chunks %s\n",
+              vCoords.size(), bSame ? "match" : "DIFFER");
+
+  std::printf("%8s %14s %14s\n", "threads", "plain chunk/s", "AVX2 chunk/s");
+  for (size_t nThreads : {1, 2, 4, 8}) {
+    JobSystem jobs(nThreads - 1);
+    std::printf("%8zu %14.0f %14.0f\n", nThreads,
+                ChunksPerSecond(plain, vCoords, jobs),
+                ChunksPerSecond(simd, vCoords, jobs));
+  }
+  std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  return bSame ? 0 : 1;
+}
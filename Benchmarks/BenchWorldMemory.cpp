@@ -0,0 +1,68 @@
+// Memory per million tiles of the chunked world, and the cost of a tile get
+// and set.
+//
+// A 1024 x 1024 tile area is filled with tiles drawn from a given number of
+// kinds, which decides the palette width each chunk ends up with. Sizes
+// include the chunk map overhead, as reported by World::MemoryUsage().
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../MMOServer/MMOWorld.h"
+
+constexpr int32_t nSide = 1024;
+
+static World FillWorld(uint32_t nKinds) {
+  World world;
+  std::mt19937 rng(1);
+  for (int32_t y = 0; y < nSide; y++)
+    for (int32_t x = 0; x < nSide; x++)
+      world.SetTile(x, y, Tile(nKinds ? rng() % nKinds : 0));
+  return world;
+}
+
+int main() {
+  struct sCase {
+    const char* sName;
+    uint32_t nKinds;
+  };
+  const sCase vCases[] = {{"all floor (lazy)", 0},
+                          {"walls + floor (1 bit)", 2},
+                          {"4 tile kinds (2 bit)", 4},
+                          {"12 tile kinds (4 bit)", 12},
+                          {"random 16-bit (direct)", 65536}};
+
+  std::printf("memory per million tiles:\n");
+  for (const sCase& c : vCases) {
+    World world = FillWorld(c.nKinds);
+    std::printf("  %-24s %8.1f KB\n", c.sName,
+                world.MemoryUsage() / 1024.0);
+  }
+  std::printf("  %-24s %8.1f KB\n", "flat std::string",
+              nSide * nSide / 1024.0);
+
+  // Random access over the 1 bit world, the common case.
+  World world = FillWorld(2);
+  std::mt19937 rng(2);
+  std::vector<int32_t> vX(1 << 20), vY(1 << 20);
+  for (size_t i = 0; i < vX.size(); i++) {
+    vX[i] = int32_t(rng() % nSide);
+    vY[i] = int32_t(rng() % nSide);
+  }
+
+  auto tp0 = std::chrono::steady_clock::now();
+  uint32_t nSum = 0;
+  for (size_t i = 0; i < vX.size(); i++) nSum += world.GetTile(vX[i], vY[i]);
+  auto tp1 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < vX.size(); i++)
+    world.SetTile(vX[i], vY[i], Tile(i & 1));
+  auto tp2 = std::chrono::steady_clock::now();
+
+  double fGet = std::chrono::duration<double, std::nano>(tp1 - tp0).count();
+  double fSet = std::chrono::duration<double, std::nano>(tp2 - tp1).count();
+  std::printf("get %.1f ns, set %.1f ns per tile (checksum %u)\n",
+              fGet / vX.size(), fSet / vX.size(), nSum);
+  return 0;
+}
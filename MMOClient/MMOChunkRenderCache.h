@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../MMOServer/MMOJobs.h"
+#include "../MMOServer/MMOLighting.h"
+#include "../MMOServer/MMOWorld.h"
+#include "../include/olcPixelGameEngine.h"
+
+// Pre-rendered chunk images.
+//
+// Drawing the world tile by tile costs a transform and a handful of line
+// primitives per wall, every frame. Instead each chunk is rasterized once
+// into a sprite and the whole chunk is blitted. Sprites are kept per zoom
+// bucket, a power of two number of pixels per tile, so zooming never
+// resamples: the view scale is always an integer multiple of a bucket. A
+// sprite is redrawn only when its chunk's or its light's revision moves on.
+//
+// Closer in than the largest bucket, scaling its image up costs more than
+// drawing the few tiles that fit on screen, so those zooms draw tiles.
+class ChunkRenderCache {
+ public:
+  // Buckets run from 1/32 pixel per tile (a whole chunk in one pixel) up to
+  // 8 pixels per tile, the default zoom, where a chunk image is 256KB.
+  static constexpr int32_t nMinShift = -nChunkShift;
+  static constexpr int32_t nMaxShift = 3;
+  static constexpr int32_t nBuckets = nMaxShift - nMinShift + 1;
+
+  olc::Pixel pWall = olc::WHITE;
+  olc::Pixel pFloor = olc::BLACK;
+  // Floor at full light; dimmer levels fade towards pFloor.
+  olc::Pixel pLitFloor = olc::Pixel(96, 80, 40);
+  olc::Pixel pLamp = olc::YELLOW;
+
+  // A chunk to draw this frame, and its light if it has any yet.
+  struct sVisible {
+    uint64_t nKey;
+    const Chunk* chunk;
+    const ChunkLight* light;
+  };
+
+  // Bucket for a view drawing fPixelsPerTile pixels per tile.
+  static int32_t BucketShift(float fPixelsPerTile) {
+    int32_t nShift = int32_t(std::floor(std::log2(fPixelsPerTile) + 0.001f));
+    return std::clamp(nShift, nMinShift, nMaxShift);
+  }
+
+  // Should a view drawing fPixelsPerTile pixels per tile skip the images
+  // and draw tiles with DrawTiles()?
+  static bool DrawsTiles(float fPixelsPerTile) {
+    return fPixelsPerTile >= std::ldexp(1.0f, nMaxShift + 1) - 0.001f;
+  }
+
+  // Draw a chunk tile by tile, nTile pixels per tile with its top left
+  // corner at vOrigin, looking as its images do. Tiles off the draw target
+  // are skipped, and so is plain pFloor, which the target is expected to
+  // have been cleared to.
+  void DrawTiles(olc::PixelGameEngine& pge, const sVisible& visible,
+                 const olc::vi2d& vOrigin, int32_t nTile) const {
+    olc::vi2d vTarget = {pge.GetDrawTargetWidth(), pge.GetDrawTargetHeight()};
+    olc::vi2d vFrom = (-vOrigin / nTile).max({0, 0});
+    olc::vi2d vTo = ((vTarget - vOrigin + olc::vi2d(nTile - 1, nTile - 1)) /
+                     nTile)
+                        .min({nChunkSize, nChunkSize});
+    const ChunkLight* light = visible.light;
+    for (int32_t ly = vFrom.y; ly < vTo.y; ly++)
+      for (int32_t lx = vFrom.x; lx < vTo.x; lx++) {
+        Tile tile = visible.chunk->Get(lx, ly);
+        olc::Pixel pBack =
+            Shade(tile, light ? light->Get(ly * nChunkSize + lx) : 0);
+        int32_t x0 = vOrigin.x + lx * nTile, y0 = vOrigin.y + ly * nTile;
+        int32_t x1 = x0 + nTile - 1, y1 = y0 + nTile - 1;
+        if (pBack != pFloor) pge.FillRect(x0, y0, nTile, nTile, pBack);
+        if (tile == Tile_Wall) {
+          pge.DrawRect(x0, y0, nTile - 1, nTile - 1, pWall);
+          pge.DrawLine(x0, y0, x1, y1, pWall);
+          pge.DrawLine(x0, y1, x1, y0, pWall);
+        }
+      }
+  }
+
+  // Image of the chunk at the given bucket, redrawn if it changed.
+  olc::Sprite* Get(const sVisible& visible, int32_t nShift) {
+    sEntry& entry = mapEntries[visible.nKey];
+    entry.nLastUsed = nFrame;
+
+    sBucket& bucket = entry.buckets[nShift - nMinShift];
+    if (IsStale(bucket, visible)) Redraw(visible, nShift, bucket);
+    bucket.nLastUsed = nFrame;
+    return bucket.sprite.get();
+  }
+
+  // Redraw, in parallel, every out of date image among the chunks about to
+  // be drawn, so the Get() calls that follow are all lookups.
+  void Prepare(const std::vector<sVisible>& vChunks, int32_t nShift,
+               JobSystem& jobs) {
+    vStale.clear();
+    for (const sVisible& visible : vChunks) {
+      sBucket& bucket = mapEntries[visible.nKey].buckets[nShift - nMinShift];
+      if (IsStale(bucket, visible)) vStale.push_back({visible, &bucket});
+    }
+
+    jobs.ParallelFor(0, vStale.size(), 1, [&](size_t nBegin, size_t nEnd) {
+      for (size_t i = nBegin; i < nEnd; i++)
+        Redraw(vStale[i].first, nShift, *vStale[i].second);
+    });
+  }
+
+  // Call once per frame after drawing. Images not drawn for nKeepFrames are
+  // released, which also covers chunks the world has evicted.
+  void EndFrame(uint64_t nKeepFrames = 120) {
+    for (auto it = mapEntries.begin(); it != mapEntries.end();) {
+      sEntry& entry = it->second;
+      if (nFrame - entry.nLastUsed > nKeepFrames) {
+        it = mapEntries.erase(it);
+        continue;
+      }
+      for (auto& bucket : entry.buckets)
+        if (bucket.sprite && nFrame - bucket.nLastUsed > nKeepFrames)
+          bucket.sprite.reset();
+      ++it;
+    }
+    nFrame++;
+  }
+
+  size_t MemoryUsage() const {
+    size_t nBytes = 0;
+    for (const auto& [nKey, entry] : mapEntries)
+      for (const auto& bucket : entry.buckets)
+        if (bucket.sprite)
+          nBytes += sizeof(olc::Pixel) * bucket.sprite->width *
+                    bucket.sprite->height;
+    return nBytes;
+  }
+
+ private:
+  struct sBucket {
+    std::unique_ptr<olc::Sprite> sprite;
+    uint64_t nRevision = 0;
+    uint64_t nLightRevision = 0;
+    uint64_t nLastUsed = 0;
+  };
+
+  struct sEntry {
+    std::array<sBucket, nBuckets> buckets;
+    uint64_t nLastUsed = 0;
+  };
+
+  static bool IsStale(const sBucket& bucket, const sVisible& visible) {
+    uint64_t nLightRevision = visible.light ? visible.light->Revision() : 0;
+    return !bucket.sprite || bucket.nRevision != visible.chunk->Revision() ||
+           bucket.nLightRevision != nLightRevision;
+  }
+
+  void Redraw(const sVisible& visible, int32_t nShift, sBucket& bucket) {
+    Rasterize(*visible.chunk, visible.light, nShift, bucket);
+    bucket.nRevision = visible.chunk->Revision();
+    bucket.nLightRevision = visible.light ? visible.light->Revision() : 0;
+  }
+
+  // Colour of a tile that is not a wall.
+  olc::Pixel Shade(Tile tile, uint8_t nLight) const {
+    if (tile == Tile_Lamp) return pLamp;
+    return olc::PixelLerp(pFloor, pLitFloor, float(nLight) / nMaxLight);
+  }
+
+  void Rasterize(const Chunk& chunk, const ChunkLight* light, int32_t nShift,
+                 sBucket& bucket) {
+    auto Light = [light](int32_t lx, int32_t ly) -> uint8_t {
+      return light ? light->Get(ly * nChunkSize + lx) : 0;
+    };
+
+    int32_t nSize = nShift >= 0 ? nChunkSize << nShift : nChunkSize >> -nShift;
+    if (!bucket.sprite)
+      bucket.sprite = std::make_unique<olc::Sprite>(nSize, nSize);
+    olc::Sprite* sprite = bucket.sprite.get();
+
+    if (nShift < 0) {
+      // Less than a pixel per tile: a pixel is a lamp if any tile under it
+      // is, then a wall if any is, so neither vanishes when zoomed out, and
+      // otherwise as bright as the brightest tile under it.
+      int32_t nBlock = 1 << -nShift;
+      for (int32_t py = 0; py < nSize; py++)
+        for (int32_t px = 0; px < nSize; px++) {
+          Tile dominant = Tile_Floor;
+          uint8_t nLight = 0;
+          for (int32_t j = 0; j < nBlock && dominant != Tile_Lamp; j++)
+            for (int32_t i = 0; i < nBlock && dominant != Tile_Lamp; i++) {
+              int32_t lx = px * nBlock + i, ly = py * nBlock + j;
+              Tile tile = chunk.Get(lx, ly);
+              if (tile == Tile_Lamp || tile == Tile_Wall) dominant = tile;
+              nLight = std::max(nLight, Light(lx, ly));
+            }
+          sprite->SetPixel(px, py, dominant == Tile_Wall
+                                       ? pWall
+                                       : Shade(dominant, nLight));
+        }
+      return;
+    }
+
+    // Walls are an outlined box with a cross through it, as they always
+    // were, just drawn once.
+    int32_t nTile = 1 << nShift;
+    for (int32_t ly = 0; ly < nChunkSize; ly++)
+      for (int32_t lx = 0; lx < nChunkSize; lx++) {
+        Tile tile = chunk.Get(lx, ly);
+        bool bWall = tile == Tile_Wall;
+        olc::Pixel pBack = Shade(tile, Light(lx, ly));
+        int32_t x0 = lx * nTile, y0 = ly * nTile;
+        for (int32_t j = 0; j < nTile; j++)
+          for (int32_t i = 0; i < nTile; i++) {
+            bool bInk = bWall && (i == 0 || j == 0 || i == nTile - 1 ||
+                                  j == nTile - 1 || i == j ||
+                                  i == nTile - 1 - j);
+            sprite->SetPixel(x0 + i, y0 + j, bInk ? pWall : pBack);
+          }
+      }
+  }
+
+  std::unordered_map<uint64_t, sEntry> mapEntries;
+  std::vector<std::pair<sVisible, sBucket*>> vStale;
+  uint64_t nFrame = 0;
+};
@@ -1,88 +1,306 @@
+#include "../MMOServer/MMOBlockChanges.h"
+#include "../MMOServer/MMOChunkStreaming.h"
 #include "../MMOServer/MMOCommon.h"
+#include "../MMOServer/MMOJobs.h"
+#include "../MMOServer/MMOLighting.h"
+#include "../MMOServer/MMOWorld.h"
 #include "../NetCommon/olc_net.h"
+
+#define OLC_PGE_APPLICATION
 #include "../include/olcPixelGameEngine.h"
 
 #define OLC_PGEX_TRANSFORMEDVIEW
-#include <string>
+#include <unordered_map>
 
 #include "../include/olcPGEX_TransformedView.h"
+#include "MMOChunkRenderCache.h"
+#include "MMOInterpolation.h"
 
 class MMOGame : public olc::PixelGameEngine,
                 olc::net::client_interface<GameMsg> {
  public:
   MMOGame() { sAppName = "MMO Client"; }
 
-  std::string sWorldMap =
-      "################################"
-      "#..............................#"
-      "#.......#####.#.....#####......#"
-      "#.......#...#.#.....#..........#"
-      "#.......#...#.#.....#..........#"
-      "#.......#####.#####.#####......#"
-      "#..............................#"
-      "#.....#####.#####.#####..##....#"
-      "#.........#.#...#.....#.#.#....#"
-      "#.....#####.#...#.#####...#....#"
-      "#.....#.....#...#.#.......#....#"
-      "#.....#####.#####.#####.#####..#"
-      "#..............................#"
-      "#..............................#"
-      "#..#.#..........#....#.........#"
-      "#..#.#..........#....#.........#"
-      "#..#.#.......#####.#######.....#"
-      "#..#.#..........#....#.........#"
-      "#..#.#.............###.#.#.....#"
-      "#..#.##########................#"
-      "#..#..........#....#.#.#.#.....#"
-      "#..#.####.###.#................#"
-      "#..#.#......#.#................#"
-      "#..#.#.####.#.#....###..###....#"
-      "#..#.#......#.#....#......#....#"
-      "#..#.########.#....#......#....#"
-      "#..#..........#....#......#....#"
-      "#..############....#......#....#"
-      "#..................########....#"
-      "#..............................#"
-      "#..............................#"
-      "################################";
-
-  olc::vi2d worldSize = {32, 32};
+  World world;
 
  private:
   olc::TileTransformedView tv;
+  ChunkRenderCache chunkCache;
+  // Chunks on screen this frame.
+  std::vector<ChunkRenderCache::sVisible> vVisibleChunks;
+
+  // Light of the chunks we hold, as last sent by the server.
+  std::unordered_map<uint64_t, ChunkLight> mapLight;
+
+  // Decoded Game_BlockChanges, kept to reuse their storage.
+  std::vector<uint16_t> vChangeIndices;
+  std::vector<Tile> vChangeTiles;
+
+  // Spare cores for the frame's parallel work.
+  JobSystem jobs;
+
+  // Furthest zoom out, in pixels per tile. Roughly the largest view the
+  // server will stream chunks for.
+  float fMinPixelsPerTile = 0.5f;
+
+  // Snapshot history of every remote player we have heard about.
+  std::unordered_map<uint32_t, EntityInterpolator<>> mapRemotePlayers;
+
+  // How far in the past (microseconds) remote players are rendered. This
+  // needs to cover the gap between two server updates, and is widened by the
+  // measured network jitter on top.
+  uint64_t nInterpolationDelay = 100000;
+
+  // Nothing may be sent until the server has accepted our handshake.
+  bool bAccepted = false;
+
+  // Last view rectangle reported to the server.
+  sViewRect viewSent;
+  bool bViewSent = false;
 
  public:
   bool OnUserCreate() override {
     tv = olc::TileTransformedView({ScreenWidth(), ScreenHeight()}, {8, 8});
+
+    // Server_GetPing keeps our estimate of the server clock up to date, all
+    // snapshot timestamps are in server time.
+    SetTimeSyncMessage(GameMsg::Server_GetPing);
+
+    // The world is streamed in by the server around whatever we are looking
+    // at, nothing is known about it up front.
+    Connect("127.0.0.1", 60000);
     return true;
   }
 
+  void HandleIncomingMessages() {
+    while (!Incoming().empty()) {
+      auto msg = Incoming().pop_front().msg;
+
+      switch (msg.header.id) {
+        case GameMsg::Client_Accepted:
+          bAccepted = true;
+          break;
+
+        case GameMsg::Game_AddPlayer:
+        case GameMsg::Game_UpdatePlayer: {
+          sPlayerDescription desc;
+          msg >> desc;
+          mapRemotePlayers[desc.nUniqueID].Push({desc.nTimestamp,
+                                                 {desc.fPosX, desc.fPosY},
+                                                 {desc.fVelX, desc.fVelY}});
+          break;
+        }
+
+        case GameMsg::Game_RemovePlayer: {
+          uint32_t nRemovalID = 0;
+          msg >> nRemovalID;
+          mapRemotePlayers.erase(nRemovalID);
+          break;
+        }
+
+        case GameMsg::Game_ChunkData: {
+          sChunkDataHeader chunkHeader;
+          msg >> chunkHeader;
+
+          // The view may have moved on while this was in flight.
+          if (!ChunkNearView(viewSent, chunkHeader.cx, chunkHeader.cy,
+                             nChunkEvictMargin))
+            break;
+
+          if (msg.body.empty()) {
+            EraseChunk(chunkHeader.cx, chunkHeader.cy);
+            break;
+          }
+
+          auto chunk = std::make_unique<Chunk>();
+          if (chunk->Deserialize(msg.body.data(), msg.body.size()))
+            world.InsertChunk(chunkHeader.cx, chunkHeader.cy, std::move(chunk));
+          break;
+        }
+
+        case GameMsg::Game_LightData: {
+          sLightDataHeader lightHeader;
+          msg >> lightHeader;
+          // Always follows its chunk, so a missing chunk was evicted since.
+          if (!world.FindResidentChunk(lightHeader.cx, lightHeader.cy)) break;
+
+          uint64_t nKey = ChunkKey(lightHeader.cx, lightHeader.cy);
+          if (!ApplyLightData(mapLight[nKey], lightHeader, msg.body))
+            mapLight.erase(nKey);
+          break;
+        }
+
+        case GameMsg::Game_BlockChanges: {
+          sBlockChangeHeader changeHeader;
+          msg >> changeHeader;
+          if (!ChunkNearView(viewSent, changeHeader.cx, changeHeader.cy,
+                             nChunkEvictMargin))
+            break;
+          if (!DecodeBlockChanges(changeHeader, msg.body, vChangeIndices,
+                                  vChangeTiles))
+            break;
+          // Only sent for chunks we hold; an empty one is held as no chunk.
+          world.CreateChunk(changeHeader.cx, changeHeader.cy)
+              .SetMany(vChangeIndices.data(), vChangeTiles.data(),
+                       vChangeIndices.size());
+          break;
+        }
+
+        default:
+          break;
+      }
+    }
+  }
+
+  // Report the view to the server whenever it changes, and drop the chunks
+  // that have fallen well outside it. The server forgets the same chunks when
+  // it gets the new view, so it will send them again if we come back.
+  void UpdateView() {
+    olc::vi2d vTL = tv.GetTopLeftTile();
+    olc::vi2d vBR = tv.GetBottomRightTile();
+    sViewRect view{vTL.x, vTL.y, vBR.x, vBR.y};
+    if (bViewSent && view == viewSent) return;
+
+    olc::net::message<GameMsg> msg;
+    msg.header.id = GameMsg::Client_ViewRect;
+    msg << view;
+    Send(std::move(msg));
+    viewSent = view;
+    bViewSent = true;
+
+    std::vector<olc::vi2d> vEvict;
+    world.ForEachResidentChunk([&](int32_t cx, int32_t cy, const Chunk &) {
+      if (!ChunkNearView(view, cx, cy, nChunkEvictMargin))
+        vEvict.push_back({cx, cy});
+    });
+    for (const auto &vChunk : vEvict) EraseChunk(vChunk.x, vChunk.y);
+  }
+
+  void EraseChunk(int32_t cx, int32_t cy) {
+    world.EraseChunk(cx, cy);
+    mapLight.erase(ChunkKey(cx, cy));
+  }
+
+  // Left click toggles a wall, right click a lamp. The server decides; the
+  // change comes back with the chunk.
+  void EditTiles() {
+    int32_t nButton = GetMouse(0).bPressed ? 0 : GetMouse(1).bPressed ? 1 : -1;
+    if (nButton < 0) return;
+
+    olc::vf2d vTile = tv.ScreenToWorld(GetMousePos());
+    sTileEdit edit;
+    edit.x = int32_t(std::floor(vTile.x));
+    edit.y = int32_t(std::floor(vTile.y));
+    Tile tile = world.GetTile(edit.x, edit.y);
+    Tile placed = nButton == 0 ? Tile_Wall : Tile_Lamp;
+    edit.nTile = tile == placed ? Tile(Tile_Floor) : placed;
+
+    olc::net::message<GameMsg> msg;
+    msg.header.id = GameMsg::Client_SetTile;
+    msg << edit;
+    Send(std::move(msg));
+  }
+
+  // Blit the cached image of every visible chunk, clipped to the screen, or
+  // when zoomed in past the largest image draw its tiles. Chunks we have not
+  // been sent are empty floor and draw nothing.
+  void DrawWorld() {
+    olc::vi2d vTL = tv.GetTopLeftTile();
+    olc::vi2d vBR = tv.GetBottomRightTile();
+
+    float fPixelsPerTile = tv.GetWorldScale().x;
+    int32_t nShift = ChunkRenderCache::BucketShift(fPixelsPerTile);
+    int32_t nScale =
+        std::max(1, int32_t(fPixelsPerTile / std::ldexp(1.0f, nShift) + 0.5f));
+    olc::vi2d vScreen = {ScreenWidth(), ScreenHeight()};
+
+    vVisibleChunks.clear();
+    for (int32_t cy = TileToChunk(vTL.y); cy <= TileToChunk(vBR.y - 1); cy++)
+      for (int32_t cx = TileToChunk(vTL.x); cx <= TileToChunk(vBR.x - 1);
+           cx++)
+        if (const Chunk *chunk = world.FindResidentChunk(cx, cy)) {
+          auto itLight = mapLight.find(ChunkKey(cx, cy));
+          vVisibleChunks.push_back(
+              {ChunkKey(cx, cy), chunk,
+               itLight != mapLight.end() ? &itLight->second : nullptr});
+        }
+
+    if (ChunkRenderCache::DrawsTiles(fPixelsPerTile)) {
+      int32_t nTile = int32_t(fPixelsPerTile + 0.5f);
+      for (const auto &visible : vVisibleChunks) {
+        int32_t cx = int32_t(visible.nKey >> 32);
+        int32_t cy = int32_t(uint32_t(visible.nKey));
+        chunkCache.DrawTiles(*this, visible,
+                             tv.WorldToScreen({float(cx * nChunkSize),
+                                               float(cy * nChunkSize)}),
+                             nTile);
+      }
+      chunkCache.EndFrame();
+      return;
+    }
+
+    // Chunks that just arrived or changed are rasterized across the cores.
+    chunkCache.Prepare(vVisibleChunks, nShift, jobs);
+
+    for (const auto &visible : vVisibleChunks) {
+      int32_t cx = int32_t(visible.nKey >> 32);
+      int32_t cy = int32_t(uint32_t(visible.nKey));
+      olc::Sprite *sprite = chunkCache.Get(visible, nShift);
+      olc::vi2d vSize = {sprite->width, sprite->height};
+      olc::vi2d vOrigin = tv.WorldToScreen(
+          {float(cx * nChunkSize), float(cy * nChunkSize)});
+
+      olc::vi2d vFrom = (-vOrigin / nScale).max({0, 0});
+      olc::vi2d vTo =
+          ((vScreen - vOrigin + olc::vi2d(nScale - 1, nScale - 1)) / nScale)
+              .min(vSize);
+      if (vTo.x <= vFrom.x || vTo.y <= vFrom.y) continue;
+
+      DrawPartialSprite(vOrigin + vFrom * nScale, sprite, vFrom,
+                        vTo - vFrom, nScale);
+    }
+
+    chunkCache.EndFrame();
+  }
+
   bool OnUserUpdate(float elapsedTime) override {
     // Handle Pan & Zoom
     if (GetMouse(2).bPressed) tv.StartPan(GetMousePos());
     if (GetMouse(2).bHeld) tv.UpdatePan(GetMousePos());
     if (GetMouse(2).bReleased) tv.EndPan(GetMousePos());
     if (GetMouseWheel() > 0) tv.ZoomAtScreenPos(2.0f, GetMousePos());
-    if (GetMouseWheel() < 0) tv.ZoomAtScreenPos(0.5f, GetMousePos());
+    if (GetMouseWheel() < 0 && tv.GetWorldScale().x > fMinPixelsPerTile)
+      tv.ZoomAtScreenPos(0.5f, GetMousePos());
+
+    if (isConnected()) {
+      HandleIncomingMessages();
+      if (bAccepted) {
+        UpdateView();
+        EditTiles();
+      }
+    }
 
     Clear(olc::BLACK);
 
-    // Draw World
-    olc::vi2d vTL = tv.GetTopLeftTile().max({0, 0});
-    olc::vi2d vBR = tv.GetBottomRightTile().min(worldSize);
-    olc::vi2d vTile;
-    for (vTile.y = vTL.y; vTile.y < vBR.y; vTile.y++)
-      for (vTile.x = vTL.x; vTile.x < vBR.x; vTile.x++) {
-        if (sWorldMap[vTile.y * worldSize.x + vTile.x] == '#') {
-          tv.DrawRect(vTile, {1.0f, 1.0f}, olc::WHITE);
-          tv.DrawLine(vTile, vTile + olc::vf2d(1.0f, 1.0f), olc::WHITE);
-          tv.DrawLine(vTile + olc::vf2d(0.0f, 1.0f),
-                      vTile + olc::vf2d(1.0f, 0.0f), olc::WHITE);
-        }
+    DrawWorld();
+
+    // Draw remote players, rendered slightly in the past so that updates
+    // arriving unevenly still have a pair of snapshots to blend between.
+    if (IsClockSynced()) {
+      uint64_t nRenderTime =
+          GetServerTime() - nInterpolationDelay - 2 * GetJitter();
+      for (auto &[nID, player] : mapRemotePlayers) {
+        if (!player.Empty())
+          tv.FillCircle(player.Sample(nRenderTime), 0.5f, olc::YELLOW);
       }
+    }
 
     return true;
   }
 };
 
-int main(int argc, char *argv[]) { MMOGame demo; }
+int main(int argc, char *argv[]) {
+  MMOGame demo;
+  if (demo.Construct(480, 480, 1, 1)) demo.Start();
+  return 0;
+}
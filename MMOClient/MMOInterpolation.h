@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "../include/olcPixelGameEngine.h"
+
+// A single time-stamped state received from the network for a remote entity.
+struct sEntitySnapshot {
+  uint64_t nTimestamp = 0;  // microseconds
+  olc::vf2d vPos;
+  olc::vf2d vVel;
+};
+
+// Fixed-size history of snapshots for one remote entity. Snapshots are stored
+// in a ring so pushing never allocates, and the entity is rendered some time
+// in the past so there is (almost) always a pair of snapshots to blend
+// between. When the render time runs past the newest snapshot (a late or lost
+// packet) the state is extrapolated along the last known velocity for a short
+// while, then held.
+template <size_t nHistory = 16>
+class EntityInterpolator {
+  static_assert((nHistory & (nHistory - 1)) == 0,
+                "History length must be a power of two");
+
+ public:
+  void Push(const sEntitySnapshot& snapshot) {
+    // Out of order packets are dropped, we only ever move forwards in time.
+    if (nCount > 0 && snapshot.nTimestamp <= Newest().nTimestamp) return;
+
+    nHead = (nHead + 1) & (nHistory - 1);
+    ringSnapshots[nHead] = snapshot;
+    if (nCount < nHistory) nCount++;
+  }
+
+  bool Empty() const { return nCount == 0; }
+
+  const sEntitySnapshot& Newest() const { return ringSnapshots[nHead]; }
+
+  // Returns the interpolated position of the entity at nRenderTime. If
+  // nRenderTime lies beyond the newest snapshot, the position is extrapolated
+  // for at most nMaxExtrapolation microseconds.
+  olc::vf2d Sample(uint64_t nRenderTime,
+                   uint64_t nMaxExtrapolation = 250000) const {
+    if (nCount == 0) return {0.0f, 0.0f};
+
+    const sEntitySnapshot& newest = Newest();
+    if (nRenderTime >= newest.nTimestamp) {
+      uint64_t nAhead = nRenderTime - newest.nTimestamp;
+      if (nAhead > nMaxExtrapolation) nAhead = nMaxExtrapolation;
+      return newest.vPos + newest.vVel * (float(nAhead) * 1e-6f);
+    }
+
+    // Walk backwards from the newest snapshot until we find the pair that
+    // brackets the render time.
+    for (size_t i = 1; i < nCount; i++) {
+      const sEntitySnapshot& older = At(i);
+      if (older.nTimestamp <= nRenderTime) {
+        const sEntitySnapshot& newer = At(i - 1);
+        float t = float(nRenderTime - older.nTimestamp) /
+                  float(newer.nTimestamp - older.nTimestamp);
+        return older.vPos + (newer.vPos - older.vPos) * t;
+      }
+    }
+
+    // Render time is older than anything we remember.
+    return At(nCount - 1).vPos;
+  }
+
+ private:
+  // i = 0 is the newest snapshot, i = nCount - 1 the oldest.
+  const sEntitySnapshot& At(size_t i) const {
+    return ringSnapshots[(nHead - i) & (nHistory - 1)];
+  }
+
+  std::array<sEntitySnapshot, nHistory> ringSnapshots;
+  size_t nHead = nHistory - 1;
+  size_t nCount = 0;
+};
@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "MMOWorld.h"
+
+// Batched tile change replication.
+//
+// Tile changes are collected over a tick and go out as one Game_BlockChanges
+// message per chunk instead of one message per tile. A tile written several
+// times in a tick is sent once with its final value, and not at all if it
+// ends the tick as it started.
+//
+// The body is a small palette of the tiles used, then one varint per change
+// holding the distance from the previous changed index and the palette index
+// below it. Changes are sorted by index, so a cluster of edits costs about a
+// byte per tile.
+
+// Trailer of a Game_BlockChanges message, pushed after the body. The changes
+// take the chunk from nBaseRevision on the server to its current state;
+// clients holding any other version of the chunk are sent it whole instead.
+struct sBlockChangeHeader {
+  int32_t cx = 0;
+  int32_t cy = 0;
+  uint32_t nCount = 0;
+  uint32_t nPaletteSize = 0;
+};
+
+// Decode a Game_BlockChanges body into tile indices and tiles. Returns false
+// if it is malformed.
+inline bool DecodeBlockChanges(const sBlockChangeHeader& header,
+                               const std::vector<uint8_t>& vBody,
+                               std::vector<uint16_t>& vIndices,
+                               std::vector<Tile>& vTiles) {
+  vIndices.clear();
+  vTiles.clear();
+  if (header.nPaletteSize == 0 || header.nPaletteSize > 256 ||
+      header.nCount > uint32_t(nChunkArea) ||
+      vBody.size() < header.nPaletteSize * sizeof(Tile))
+    return false;
+
+  std::vector<Tile> vPalette(header.nPaletteSize);
+  std::memcpy(vPalette.data(), vBody.data(), vPalette.size() * sizeof(Tile));
+  uint32_t nPaletteBits = 0;
+  while ((1u << nPaletteBits) < header.nPaletteSize) nPaletteBits++;
+
+  size_t nPos = vPalette.size() * sizeof(Tile);
+  int32_t nIndex = -1;
+  for (uint32_t k = 0; k < header.nCount; k++) {
+    uint32_t nValue = 0;
+    for (int32_t nShift = 0;; nShift += 7) {
+      if (nPos == vBody.size() || nShift > 28) return false;
+      uint8_t nByte = vBody[nPos++];
+      nValue |= uint32_t(nByte & 0x7F) << nShift;
+      if (!(nByte & 0x80)) break;
+    }
+
+    uint32_t nPalette = nValue & ((1u << nPaletteBits) - 1);
+    nIndex += int32_t(nValue >> nPaletteBits) + 1;
+    if (nPalette >= vPalette.size() || nIndex >= nChunkArea) return false;
+    vIndices.push_back(uint16_t(nIndex));
+    vTiles.push_back(vPalette[nPalette]);
+  }
+  return nPos == vBody.size();
+}
+
+// Server side: the tick's tile changes, per chunk.
+class BlockChangeAccumulator {
+ public:
+  // Note a change to tile (x, y) from tileOld to tile, made to a chunk that
+  // was at nRevision just before.
+  void Record(int32_t x, int32_t y, Tile tileOld, Tile tile,
+              uint64_t nRevision) {
+    auto [it, bNew] =
+        mapChunks.try_emplace(ChunkKey(TileToChunk(x), TileToChunk(y)));
+    if (bNew) it->second.nBaseRevision = nRevision;
+    it->second.vChanges.push_back(
+        {uint16_t(TileInChunk(y) * nChunkSize + TileInChunk(x)), tileOld,
+         tile});
+  }
+
+  // Calls f(header, nBaseRevision, vBody) for every chunk with changes, then
+  // forgets them.
+  template <typename F>
+  void Consume(F&& f) {
+    for (auto& [nKey, pending] : mapChunks) {
+      // Stable, so for each tile the first change has the tile's value at the
+      // start of the tick and the last its value now.
+      auto& vChanges = pending.vChanges;
+      std::stable_sort(vChanges.begin(), vChanges.end(),
+                       [](const sChange& a, const sChange& b) {
+                         return a.nIndex < b.nIndex;
+                       });
+
+      vFinal.clear();
+      for (size_t k = 0; k < vChanges.size();) {
+        size_t nLast = k;
+        while (nLast + 1 < vChanges.size() &&
+               vChanges[nLast + 1].nIndex == vChanges[k].nIndex)
+          nLast++;
+        if (vChanges[nLast].tile != vChanges[k].tileOld)
+          vFinal.push_back({vChanges[k].nIndex, 0, vChanges[nLast].tile});
+        k = nLast + 1;
+      }
+
+      sBlockChangeHeader header;
+      header.cx = int32_t(nKey >> 32);
+      header.cy = int32_t(uint32_t(nKey));
+      header.nCount = uint32_t(vFinal.size());
+      Encode(header);
+      f(header, pending.nBaseRevision, vBody);
+    }
+    mapChunks.clear();
+  }
+
+ private:
+  struct sChange {
+    uint16_t nIndex;
+    Tile tileOld;
+    Tile tile;
+  };
+
+  struct sPending {
+    uint64_t nBaseRevision = 0;
+    std::vector<sChange> vChanges;
+  };
+
+  void Encode(sBlockChangeHeader& header) {
+    vPalette.clear();
+    for (const sChange& change : vFinal)
+      if (std::find(vPalette.begin(), vPalette.end(), change.tile) ==
+          vPalette.end())
+        vPalette.push_back(change.tile);
+    // Even an empty batch has a palette, so decoding never divides by zero
+    // bits.
+    if (vPalette.empty()) vPalette.push_back(Tile_Floor);
+    header.nPaletteSize = uint32_t(vPalette.size());
+
+    uint32_t nPaletteBits = 0;
+    while ((1u << nPaletteBits) < vPalette.size()) nPaletteBits++;
+
+    vBody.resize(vPalette.size() * sizeof(Tile));
+    std::memcpy(vBody.data(), vPalette.data(), vBody.size());
+
+    int32_t nPrevious = -1;
+    for (const sChange& change : vFinal) {
+      uint32_t nPalette = uint32_t(
+          std::find(vPalette.begin(), vPalette.end(), change.tile) -
+          vPalette.begin());
+      uint32_t nValue =
+          (uint32_t(change.nIndex - nPrevious - 1) << nPaletteBits) | nPalette;
+      nPrevious = change.nIndex;
+      while (nValue >= 0x80) {
+        vBody.push_back(uint8_t(nValue | 0x80));
+        nValue >>= 7;
+      }
+      vBody.push_back(uint8_t(nValue));
+    }
+  }
+
+  std::unordered_map<uint64_t, sPending> mapChunks;
+  std::vector<sChange> vFinal;
+  std::vector<Tile> vPalette;
+  std::vector<uint8_t> vBody;
+};
@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "MMOWorld.h"
+
+// Viewport driven chunk streaming.
+//
+// Clients tell the server which tiles they can see (Client_ViewRect). Each
+// tick the server sends the chunks around that view the client does not have
+// yet, or has an out of date copy of, nearest first and within a byte budget
+// (Game_ChunkData). Both sides apply the same eviction rule to chunks far
+// outside the view, so they agree on what the client holds without any
+// unload messages.
+
+// Visible tile rectangle, left/top inclusive and right/bottom exclusive.
+struct sViewRect {
+  int32_t nLeft = 0;
+  int32_t nTop = 0;
+  int32_t nRight = 0;
+  int32_t nBottom = 0;
+
+  bool operator==(const sViewRect& rhs) const {
+    return nLeft == rhs.nLeft && nTop == rhs.nTop && nRight == rhs.nRight &&
+           nBottom == rhs.nBottom;
+  }
+  bool operator!=(const sViewRect& rhs) const { return !(*this == rhs); }
+};
+
+// Trailer of a Game_ChunkData body, after the serialized chunk. An empty
+// chunk is sent with no chunk bytes at all.
+struct sChunkDataHeader {
+  int32_t cx = 0;
+  int32_t cy = 0;
+};
+
+// Chunks within this many chunks of the view are streamed in...
+constexpr int32_t nChunkLoadMargin = 1;
+// ...and only dropped again once they are further out than this, so panning
+// back and forth over a boundary does not thrash.
+constexpr int32_t nChunkEvictMargin = 3;
+// Views wider or taller than this many chunks are cut down around their
+// centre, so a zoomed out (or lying) client cannot ask for the whole world.
+constexpr int32_t nMaxViewChunks = 32;
+
+// Is chunk (cx, cy) within nMargin chunks of the view?
+inline bool ChunkNearView(const sViewRect& view, int32_t cx, int32_t cy,
+                          int32_t nMargin) {
+  return cx >= TileToChunk(view.nLeft) - nMargin &&
+         cx <= TileToChunk(view.nRight - 1) + nMargin &&
+         cy >= TileToChunk(view.nTop) - nMargin &&
+         cy <= TileToChunk(view.nBottom - 1) + nMargin;
+}
+
+// Server side bookkeeping of what each client has been sent.
+class ChunkStreamer {
+ public:
+  void SetView(uint32_t nClientID, const sViewRect& view) {
+    sClientState& client = mapClients[nClientID];
+    client.view = ClampView(view);
+    client.bHasView = true;
+
+    // Forget chunks the client is about to evict itself.
+    for (auto it = client.mapSent.begin(); it != client.mapSent.end();) {
+      int32_t cx = int32_t(it->first >> 32), cy = int32_t(uint32_t(it->first));
+      if (!ChunkNearView(client.view, cx, cy, nChunkEvictMargin))
+        it = client.mapSent.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  void RemoveClient(uint32_t nClientID) { mapClients.erase(nClientID); }
+
+  // Is chunk (cx, cy) within nMargin chunks of any client's view?
+  bool AnyViewNear(int32_t cx, int32_t cy, int32_t nMargin) const {
+    for (const auto& [nClientID, client] : mapClients)
+      if (client.bHasView && ChunkNearView(client.view, cx, cy, nMargin))
+        return true;
+    return false;
+  }
+
+  bool ClientHasChunk(uint32_t nClientID, int32_t cx, int32_t cy) const {
+    auto it = mapClients.find(nClientID);
+    return it != mapClients.end() && it->second.mapSent.count(ChunkKey(cx, cy));
+  }
+
+  // Record that a client holding revision nFrom of chunk (cx, cy) is being
+  // sent the changes that take it to nTo. Returns false, changing nothing,
+  // if it holds some other revision or none.
+  bool AdvanceSent(uint32_t nClientID, int32_t cx, int32_t cy, uint64_t nFrom,
+                   uint64_t nTo) {
+    auto itClient = mapClients.find(nClientID);
+    if (itClient == mapClients.end()) return false;
+    auto itSent = itClient->second.mapSent.find(ChunkKey(cx, cy));
+    if (itSent == itClient->second.mapSent.end() || itSent->second != nFrom)
+      return false;
+    itSent->second = nTo;
+    return true;
+  }
+
+  // Serialize the chunks this client should receive this tick, nearest to the
+  // centre of its view first, until nByteBudget is spent. fnSend(cx, cy,
+  // vBytes) is called for each one.
+  template <typename F>
+  void Stream(uint32_t nClientID, World& world, size_t nByteBudget,
+              F&& fnSend) {
+    auto itClient = mapClients.find(nClientID);
+    if (itClient == mapClients.end() || !itClient->second.bHasView) return;
+    sClientState& client = itClient->second;
+    const sViewRect& view = client.view;
+
+    int32_t cx0 = TileToChunk(view.nLeft) - nChunkLoadMargin;
+    int32_t cy0 = TileToChunk(view.nTop) - nChunkLoadMargin;
+    int32_t cx1 = TileToChunk(view.nRight - 1) + nChunkLoadMargin;
+    int32_t cy1 = TileToChunk(view.nBottom - 1) + nChunkLoadMargin;
+
+    // Centre of the view in chunk space, doubled to stay integral.
+    int32_t nMidX = cx0 + cx1, nMidY = cy0 + cy1;
+
+    // Only resident chunks are looked at here, the budget allows for few
+    // of the candidates to be fetched and sent. Chunks a client holds stay
+    // resident, so one that is not resident was either never sent or sent
+    // as empty, which it still is.
+    vCandidates.clear();
+    for (int32_t cy = cy0; cy <= cy1; cy++) {
+      for (int32_t cx = cx0; cx <= cx1; cx++) {
+        auto itSent = client.mapSent.find(ChunkKey(cx, cy));
+        if (itSent != client.mapSent.end()) {
+          const Chunk* chunk = world.FindResidentChunk(cx, cy);
+          if (!chunk || itSent->second == chunk->Revision()) continue;
+        }
+
+        int32_t dx = 2 * cx - nMidX, dy = 2 * cy - nMidY;
+        vCandidates.push_back({dx * dx + dy * dy, cx, cy});
+      }
+    }
+    std::sort(vCandidates.begin(), vCandidates.end());
+
+    size_t nSpent = 0;
+    for (const auto& candidate : vCandidates) {
+      if (nSpent >= nByteBudget) break;
+
+      const Chunk* chunk = world.GetChunk(candidate.cx, candidate.cy);
+      vBytes.clear();
+      if (chunk) chunk->Serialize(vBytes);
+
+      fnSend(candidate.cx, candidate.cy, vBytes);
+      client.mapSent[ChunkKey(candidate.cx, candidate.cy)] =
+          chunk ? chunk->Revision() : 0;
+      nSpent += vBytes.size() + sizeof(sChunkDataHeader);
+    }
+  }
+
+ private:
+  // Done in 64 bits, as the bounds are whatever the client sent. The result
+  // lies well inside the int32 range, so its chunk range plus margins does
+  // too.
+  static sViewRect ClampView(sViewRect view) {
+    const int64_t nMaxTiles = int64_t(nMaxViewChunks) * nChunkSize;
+    const int64_t nLimit = int64_t(INT32_MAX) - 2 * nMaxTiles;
+    auto Clamp = [&](int32_t& nMin, int32_t& nMax) {
+      int64_t nLo = std::clamp<int64_t>(nMin, -nLimit, nLimit);
+      int64_t nHi = std::clamp<int64_t>(nMax, -nLimit, nLimit);
+      if (nHi <= nLo) nHi = nLo + 1;
+      if (nHi - nLo > nMaxTiles) {
+        int64_t nMid = (nLo + nHi) / 2;
+        nLo = nMid - nMaxTiles / 2;
+        nHi = nMid + nMaxTiles / 2;
+      }
+      nMin = int32_t(nLo);
+      nMax = int32_t(nHi);
+    };
+    Clamp(view.nLeft, view.nRight);
+    Clamp(view.nTop, view.nBottom);
+    return view;
+  }
+
+  struct sClientState {
+    sViewRect view;
+    bool bHasView = false;
+    // Chunk key -> revision the client was sent
+    std::unordered_map<uint64_t, uint64_t> mapSent;
+  };
+
+  struct sCandidate {
+    int32_t nDistance;
+    int32_t cx;
+    int32_t cy;
+    bool operator<(const sCandidate& rhs) const {
+      return nDistance < rhs.nDistance;
+    }
+  };
+
+  std::unordered_map<uint32_t, sClientState> mapClients;
+  std::vector<sCandidate> vCandidates;
+  std::vector<uint8_t> vBytes;
+};
@@ -1,4 +1,8 @@
+#pragma once
 #include <_types/_uint32_t.h>
+
+#include <cstdint>
+
 enum class GameMsg : uint32_t {
   Server_GetStatus,
   Server_GetPing,
@@ -11,4 +15,72 @@ enum class GameMsg : uint32_t {
   Game_AddPlayer,
   Game_RemovePlayer,
   Game_UpdatePlayer,
+
+  Client_ViewRect,
+  Game_ChunkData,
+
+  Client_SetTile,
+  Game_LightData,
+  Game_BlockChanges,
+};
+
+// Network description of a player. This is pushed as POD into the body of
+// Game_AddPlayer/Game_UpdatePlayer messages, so keep it standard layout.
+struct sPlayerDescription {
+  uint32_t nUniqueID = 0;
+  // Server time (microseconds) at which this state was sampled.
+  uint64_t nTimestamp = 0;
+  float fPosX = 0.0f;
+  float fPosY = 0.0f;
+  float fVelX = 0.0f;
+  float fVelY = 0.0f;
 };
+
+// Fastest a player may move, in tiles per second. Faster velocities sent by
+// clients are slowed down to this.
+constexpr float fMaxPlayerSpeed = 10.0f;
+
+// Body of Client_SetTile: a client asking for one tile to be changed.
+struct sTileEdit {
+  int32_t x = 0;
+  int32_t y = 0;
+  uint16_t nTile = 0;
+};
+
+// Hand authored starting world, shared so server and client agree on it.
+// '#' is a wall and '.' is open floor.
+constexpr int32_t nDefaultWorldWidth = 32;
+constexpr int32_t nDefaultWorldHeight = 32;
+constexpr const char *sDefaultWorldMap =
+    "################################"
+    "#..............................#"
+    "#.......#####.#.....#####......#"
+    "#.......#...#.#.....#..........#"
+    "#.......#...#.#.....#..........#"
+    "#.......#####.#####.#####......#"
+    "#..............................#"
+    "#.....#####.#####.#####..##....#"
+    "#.........#.#...#.....#.#.#....#"
+    "#.....#####.#...#.#####...#....#"
+    "#.....#.....#...#.#.......#....#"
+    "#.....#####.#####.#####.#####..#"
+    "#..............................#"
+    "#..............................#"
+    "#..#.#..........#....#.........#"
+    "#..#.#..........#....#.........#"
+    "#..#.#.......#####.#######.....#"
+    "#..#.#..........#....#.........#"
+    "#..#.#.............###.#.#.....#"
+    "#..#.##########................#"
+    "#..#..........#....#.#.#.#.....#"
+    "#..#.####.###.#................#"
+    "#..#.#......#.#................#"
+    "#..#.#.####.#.#....###..###....#"
+    "#..#.#......#.#....#......#....#"
+    "#..#.########.#....#......#....#"
+    "#..#..........#....#......#....#"
+    "#..############....#......#....#"
+    "#..................########....#"
+    "#..............................#"
+    "#..............................#"
+    "################################";
@@ -0,0 +1,222 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Entity store.
+//
+// Entities are handles, their state lives in one array per component (a
+// structure of arrays), all indexed by the same dense index. Systems are
+// plain loops over those arrays with no pointer chasing, over nothing but
+// contiguous data, which the compiler is free to vectorize.
+//
+// Removing an entity moves the last one into its place, so the arrays never
+// have holes. Handles therefore do not point into the arrays directly: they
+// name a slot, and the slot knows where its entity currently is. Each slot
+// carries a generation that is bumped when its entity is destroyed, so a
+// handle to a dead entity never resolves to whoever reuses the slot.
+
+using EntityID = uint32_t;
+
+// Low bits are the slot, high bits the slot's generation. Generation 0 is
+// never used, so 0 is never a valid handle.
+constexpr uint32_t nEntityIndexBits = 20;
+constexpr uint32_t nMaxEntities = 1u << nEntityIndexBits;
+constexpr uint32_t nEntityGenerationMask = (1u << (32 - nEntityIndexBits)) - 1;
+constexpr EntityID nInvalidEntity = 0;
+
+inline uint32_t EntityIndex(EntityID id) { return id & (nMaxEntities - 1); }
+inline uint32_t EntityGeneration(EntityID id) {
+  return id >> nEntityIndexBits;
+}
+
+enum EntityDirty : uint8_t {
+  Dirty_Position = 1 << 0,
+  Dirty_Velocity = 1 << 1,
+  Dirty_Spawned = 1 << 2,
+  // The server overruled the owner, so the owner must hear about it too.
+  Dirty_Corrected = 1 << 3,
+};
+
+// Who drives an entity. Client owned entities are players and live only as
+// long as their connection; server owned ones (NPCs) persist.
+enum EntityOwnerKind : uint8_t {
+  Owner_Server = 0,
+  Owner_Client = 1,
+};
+
+class EntityStore {
+ public:
+  // Dense component arrays. Index i is the same entity in all of them.
+  // Systems may read and write the elements freely, only Create/Destroy may
+  // change their size.
+  std::vector<EntityID> vID;
+  std::vector<float> vPosX;
+  std::vector<float> vPosY;
+  std::vector<float> vVelX;
+  std::vector<float> vVelY;
+  std::vector<EntityOwnerKind> vOwnerKind;
+  // Connection ID of the controlling client, 0 for server owned entities.
+  std::vector<uint32_t> vOwner;
+  // Server time (microseconds) the position and velocity are valid at.
+  std::vector<uint64_t> vTimestamp;
+  // Server time the state was last set from outside, e.g. by the owner.
+  std::vector<uint64_t> vUpdated;
+  // EntityDirty bits, set by whoever changes state and cleared once the
+  // change has been sent.
+  std::vector<uint8_t> vDirty;
+
+  // Entities are not moved further than this past their last update, the
+  // same limit clients extrapolate remote players by.
+  static constexpr uint64_t nMaxExtrapolation = 250000;
+
+  size_t Size() const { return vID.size(); }
+
+  // nOwner is the connection ID of a client owned entity. Returns
+  // nInvalidEntity if the store is full.
+  EntityID Create(EntityOwnerKind ownerKind = Owner_Server,
+                  uint32_t nOwner = 0) {
+    uint32_t nIndex;
+    if (!vFreeSlots.empty()) {
+      nIndex = vFreeSlots.back();
+      vFreeSlots.pop_back();
+    } else {
+      if (vSlots.size() >= nMaxEntities) return nInvalidEntity;
+      nIndex = uint32_t(vSlots.size());
+      vSlots.push_back({0, 1});
+    }
+
+    sSlot& slot = vSlots[nIndex];
+    slot.nDense = uint32_t(vID.size());
+    EntityID id = (slot.nGeneration << nEntityIndexBits) | nIndex;
+
+    vID.push_back(id);
+    vPosX.push_back(0.0f);
+    vPosY.push_back(0.0f);
+    vVelX.push_back(0.0f);
+    vVelY.push_back(0.0f);
+    vOwnerKind.push_back(ownerKind);
+    vOwner.push_back(ownerKind == Owner_Client ? nOwner : 0);
+    vTimestamp.push_back(0);
+    vUpdated.push_back(0);
+    vDirty.push_back(Dirty_Spawned);
+    return id;
+  }
+
+  // Returns false if the entity was already gone.
+  bool Destroy(EntityID id) {
+    size_t i = Find(id);
+    if (i == npos) return false;
+
+    // Swap-remove: the last entity takes over the hole.
+    size_t nLast = vID.size() - 1;
+    if (i != nLast) {
+      vID[i] = vID[nLast];
+      vPosX[i] = vPosX[nLast];
+      vPosY[i] = vPosY[nLast];
+      vVelX[i] = vVelX[nLast];
+      vVelY[i] = vVelY[nLast];
+      vOwnerKind[i] = vOwnerKind[nLast];
+      vOwner[i] = vOwner[nLast];
+      vTimestamp[i] = vTimestamp[nLast];
+      vUpdated[i] = vUpdated[nLast];
+      vDirty[i] = vDirty[nLast];
+      vSlots[EntityIndex(vID[i])].nDense = uint32_t(i);
+    }
+    vID.pop_back();
+    vPosX.pop_back();
+    vPosY.pop_back();
+    vVelX.pop_back();
+    vVelY.pop_back();
+    vOwnerKind.pop_back();
+    vOwner.pop_back();
+    vTimestamp.pop_back();
+    vUpdated.pop_back();
+    vDirty.pop_back();
+
+    sSlot& slot = vSlots[EntityIndex(id)];
+    slot.nGeneration = (slot.nGeneration + 1) & nEntityGenerationMask;
+    if (slot.nGeneration == 0) slot.nGeneration = 1;
+    vFreeSlots.push_back(EntityIndex(id));
+    return true;
+  }
+
+  static constexpr size_t npos = size_t(-1);
+
+  // Dense index of a live entity, or npos. Dense indices change whenever an
+  // entity is destroyed, so never hold on to one.
+  size_t Find(EntityID id) const {
+    uint32_t nIndex = EntityIndex(id);
+    if (nIndex >= vSlots.size()) return npos;
+    const sSlot& slot = vSlots[nIndex];
+    if (slot.nGeneration != EntityGeneration(id)) return npos;
+    return slot.nDense;
+  }
+
+  bool IsAlive(EntityID id) const { return Find(id) != npos; }
+
+  // Seconds entity i moves for when integrated to server time nNow.
+  float IntegrationTime(size_t i, uint64_t nNow) const {
+    return StepTime(vTimestamp[i], vUpdated[i], nNow);
+  }
+
+  // Dead reckoning: advance everything along its velocity to server time
+  // nNow. Entities may be at different times, e.g. a player whose update
+  // arrived mid tick, so each steps by its own interval.
+  void Integrate(uint64_t nNow) { Integrate(nNow, 0, vID.size()); }
+
+  // Only entities nBegin <= i < nEnd, so ranges can be run in parallel.
+  void Integrate(uint64_t nNow, size_t nBegin, size_t nEnd) {
+    float* pPosX = vPosX.data();
+    float* pPosY = vPosY.data();
+    const float* pVelX = vVelX.data();
+    const float* pVelY = vVelY.data();
+    uint64_t* pTimestamp = vTimestamp.data();
+    const uint64_t* pUpdated = vUpdated.data();
+    for (size_t i = nBegin; i < nEnd; i++) {
+      float fElapsedTime = StepTime(pTimestamp[i], pUpdated[i], nNow);
+      pPosX[i] += pVelX[i] * fElapsedTime;
+      pPosY[i] += pVelY[i] * fElapsedTime;
+      pTimestamp[i] = nNow;
+    }
+  }
+
+  // Calls f(i) for the dense index of every dirty entity, then clears the
+  // flags. Most entities are clean on most ticks, so clean runs are skipped
+  // eight flags at a time.
+  template <typename F>
+  void ConsumeDirty(F&& f) {
+    size_t n = vDirty.size();
+    uint8_t* pDirty = vDirty.data();
+    size_t i = 0;
+    while (i < n) {
+      uint64_t nEight = 0;
+      if (i + 8 <= n) std::memcpy(&nEight, pDirty + i, 8);
+      if (i + 8 <= n && nEight == 0) {
+        i += 8;
+        continue;
+      }
+      if (pDirty[i]) {
+        f(i);
+        pDirty[i] = 0;
+      }
+      i++;
+    }
+  }
+
+ private:
+  static float StepTime(uint64_t nTimestamp, uint64_t nUpdated,
+                        uint64_t nNow) {
+    uint64_t nStop = nUpdated + nMaxExtrapolation;
+    int64_t nStep = int64_t((nNow < nStop ? nNow : nStop) - nTimestamp);
+    return nStep > 0 ? float(nStep) * 1e-6f : 0.0f;
+  }
+
+  struct sSlot {
+    uint32_t nDense;
+    uint32_t nGeneration;
+  };
+
+  std::vector<sSlot> vSlots;
+  std::vector<uint32_t> vFreeSlots;
+};
@@ -0,0 +1,256 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job system shared by the server tick and the client frame.
+//
+// Every worker has its own deque of runnable jobs. A worker pushes and pops
+// at the back of its own deque, so the job it runs next is the one it just
+// made and whose data is still in cache; when it runs dry it steals from the
+// front of someone else's, taking the oldest and usually biggest piece of
+// work. Threads that are not workers, e.g. the game loop, share one more
+// deque that the workers steal from.
+//
+// A job may depend on other jobs and is only queued once they have all
+// finished. A waiting thread runs queued jobs until the one it wants is
+// done, so a wait inside a job cannot deadlock the pool and the main thread
+// is one more pair of hands. Only with nothing left to run does it sleep,
+// like an idle worker, until more work is queued or its wait is over.
+
+class JobSystem {
+ public:
+  struct sJob;
+  using Job = std::shared_ptr<sJob>;
+
+  struct sJob {
+    std::function<void()> fn;
+    // Dependencies not yet finished, plus one held while the job is being
+    // set up so it cannot be queued half built.
+    std::atomic<int32_t> nWaitingOn{1};
+    std::atomic<bool> bDone{false};
+    std::mutex mux;
+    std::vector<Job> vDependents;
+  };
+
+  // nWorkers threads besides the callers'. The default leaves one core for
+  // the thread that submits the work, which helps out while it waits.
+  explicit JobSystem(size_t nWorkers = DefaultWorkers()) {
+    vQueues.resize(nWorkers + 1);
+    for (auto& queue : vQueues) queue = std::make_unique<sQueue>();
+    for (size_t i = 0; i < nWorkers; i++)
+      vThreads.emplace_back([this, i]() { WorkerLoop(i + 1); });
+  }
+
+  ~JobSystem() {
+    {
+      std::scoped_lock lock(muxSleep);
+      bStop = true;
+    }
+    cvSleep.notify_all();
+    for (auto& thread : vThreads) thread.join();
+  }
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  static size_t DefaultWorkers() {
+    unsigned nCores = std::thread::hardware_concurrency();
+    return nCores > 1 ? nCores - 1 : 0;
+  }
+
+  // Threads that can run jobs, including the one waiting on them.
+  size_t Concurrency() const { return vThreads.size() + 1; }
+
+  // Queue fn to run once every job in vAfter has finished.
+  Job Run(std::function<void()> fn, const std::vector<Job>& vAfter = {}) {
+    Job job = std::make_shared<sJob>();
+    job->fn = std::move(fn);
+    for (const Job& dependency : vAfter) {
+      if (!dependency) continue;
+      std::scoped_lock lock(dependency->mux);
+      if (dependency->bDone) continue;
+      job->nWaitingOn++;
+      dependency->vDependents.push_back(job);
+    }
+    // Drop the set up hold; if nothing was outstanding it can go now.
+    if (--job->nWaitingOn == 0) Push(job);
+    return job;
+  }
+
+  // Run queued jobs on this thread until job has finished.
+  void Wait(const Job& job) {
+    if (job) WaitUntil([&job]() { return bool(job->bDone); });
+  }
+
+  void Wait(const std::vector<Job>& vJobs) {
+    for (const Job& job : vJobs) Wait(job);
+  }
+
+  // Calls f(nBegin, nEnd) over [nFirst, nLast) split into ranges of about
+  // nGrain items, returning once all of them are done. Ranges are split in
+  // halves as they are taken, so an idle worker always finds a large piece
+  // to steal.
+  template <typename F>
+  void ParallelFor(size_t nFirst, size_t nLast, size_t nGrain, F&& f) {
+    if (nLast <= nFirst) return;
+    nGrain = std::max<size_t>(nGrain, 1);
+    if (nLast - nFirst <= nGrain || vThreads.empty()) {
+      f(nFirst, nLast);
+      return;
+    }
+    std::atomic<size_t> nRemaining{nLast - nFirst};
+    Split(nFirst, nLast, nGrain, f, nRemaining);
+    WaitUntil([&nRemaining]() { return nRemaining == 0; });
+  }
+
+  // Jobs run, and how many of those were stolen from another thread.
+  uint64_t JobsRun() const { return nJobsRun; }
+  uint64_t JobsStolen() const { return nJobsStolen; }
+
+ private:
+  struct sQueue {
+    std::mutex mux;
+    std::deque<Job> deqJobs;
+  };
+
+  // Which queue this thread pushes to: its own for one of our workers,
+  // otherwise the shared one at index 0.
+  static inline thread_local const JobSystem* pWorkerOf = nullptr;
+  static inline thread_local size_t nWorkerIndex = 0;
+
+  size_t ThreadQueue() const { return pWorkerOf == this ? nWorkerIndex : 0; }
+
+  template <typename F>
+  void Split(size_t nFirst, size_t nLast, size_t nGrain, F& f,
+             std::atomic<size_t>& nRemaining) {
+    // Hand off the upper halves and keep going with the lower one.
+    while (nLast - nFirst > nGrain) {
+      size_t nMid = nFirst + (nLast - nFirst) / 2;
+      Run([this, nMid, nLast, nGrain, &f, &nRemaining]() {
+        Split(nMid, nLast, nGrain, f, nRemaining);
+      });
+      nLast = nMid;
+    }
+    f(nFirst, nLast);
+    // The waiter may return as soon as this reaches zero, so nRemaining
+    // must not be touched after it.
+    if ((nRemaining -= nLast - nFirst) == 0) WakeWaiters();
+  }
+
+  void Push(const Job& job) {
+    sQueue& queue = *vQueues[ThreadQueue()];
+    nQueued++;
+    {
+      std::scoped_lock lock(queue.mux);
+      queue.deqJobs.push_back(job);
+    }
+    if (nSleeping != 0) {
+      std::scoped_lock lock(muxSleep);
+      cvSleep.notify_one();
+    }
+  }
+
+  // Newest job from our own queue, else the oldest from anyone else's.
+  Job Take() {
+    size_t nSelf = ThreadQueue();
+    {
+      sQueue& queue = *vQueues[nSelf];
+      std::scoped_lock lock(queue.mux);
+      if (!queue.deqJobs.empty()) {
+        Job job = std::move(queue.deqJobs.back());
+        queue.deqJobs.pop_back();
+        return job;
+      }
+    }
+    for (size_t n = 1; n < vQueues.size(); n++) {
+      sQueue& queue = *vQueues[(nSelf + n) % vQueues.size()];
+      std::scoped_lock lock(queue.mux);
+      if (!queue.deqJobs.empty()) {
+        Job job = std::move(queue.deqJobs.front());
+        queue.deqJobs.pop_front();
+        nJobsStolen++;
+        return job;
+      }
+    }
+    return nullptr;
+  }
+
+  bool RunOne() {
+    if (nQueued == 0) return false;
+    Job job = Take();
+    if (!job) return false;
+    nQueued--;
+
+    job->fn();
+    job->fn = nullptr;
+    nJobsRun++;
+
+    std::vector<Job> vDependents;
+    {
+      std::scoped_lock lock(job->mux);
+      job->bDone = true;
+      vDependents.swap(job->vDependents);
+    }
+    for (const Job& dependent : vDependents)
+      if (--dependent->nWaitingOn == 0) Push(dependent);
+    WakeWaiters();
+    return true;
+  }
+
+  // Run jobs until bDone() holds, sleeping whenever there are none to run.
+  template <typename F>
+  void WaitUntil(F&& bDone) {
+    while (!bDone()) {
+      if (RunOne()) continue;
+
+      std::unique_lock lock(muxSleep);
+      nSleeping++;
+      nWaiting++;
+      cvSleep.wait(lock, [&]() { return bDone() || nQueued != 0; });
+      nWaiting--;
+      nSleeping--;
+    }
+  }
+
+  // Something finished that a sleeping Wait() or ParallelFor() may be
+  // waiting on. Workers wake too, find nothing and go back to sleep.
+  void WakeWaiters() {
+    if (nWaiting == 0) return;
+    std::scoped_lock lock(muxSleep);
+    cvSleep.notify_all();
+  }
+
+  void WorkerLoop(size_t nIndex) {
+    pWorkerOf = this;
+    nWorkerIndex = nIndex;
+    while (true) {
+      if (RunOne()) continue;
+
+      std::unique_lock lock(muxSleep);
+      nSleeping++;
+      cvSleep.wait(lock, [this]() { return bStop || nQueued != 0; });
+      nSleeping--;
+      if (bStop) return;
+    }
+  }
+
+  std::vector<std::unique_ptr<sQueue>> vQueues;
+  std::vector<std::thread> vThreads;
+  std::atomic<size_t> nQueued{0};
+  std::atomic<size_t> nSleeping{0};
+  // Threads asleep in WaitUntil, a subset of nSleeping.
+  std::atomic<size_t> nWaiting{0};
+  std::mutex muxSleep;
+  std::condition_variable cvSleep;
+  bool bStop = false;
+  std::atomic<uint64_t> nJobsRun{0};
+  std::atomic<uint64_t> nJobsStolen{0};
+};
@@ -0,0 +1,333 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "MMOWorld.h"
+
+// Tile lighting.
+//
+// Light levels run from 0 (dark) to nMaxLight and are kept per chunk, four
+// bits a tile. Light spreads out from emitting tiles one level per step and
+// is stopped by solid ones, so it is a breadth first flood fill.
+//
+// Changing a tile never recomputes whole chunks. Light is taken away by a
+// removal flood from the tile, which clears everything that was lit through
+// it and notes the edges where other light remains; those edges, plus the
+// tile itself, then flood back in. Both only visit tiles whose light actually
+// changes. All of a tick's changes are batched into one pair of floods.
+//
+// The server owns the light. Clients are sent a chunk's full light map along
+// with the chunk, and after that only the tiles whose level changed.
+
+constexpr uint8_t nMaxLight = 15;
+
+inline uint8_t LightEmission(Tile tile) { return tile == Tile_Lamp ? nMaxLight : 0; }
+inline bool BlocksLight(Tile tile) { return IsSolidTile(tile); }
+
+// Light levels of one chunk, in the same row order as its tiles.
+class ChunkLight {
+ public:
+  static constexpr size_t nBytes = nChunkArea / 2;
+
+  uint8_t Get(int32_t i) const {
+    return (vLevels[size_t(i) >> 1] >> ((i & 1) * 4)) & 0xF;
+  }
+
+  void Set(int32_t i, uint8_t nLevel) {
+    uint8_t& nByte = vLevels[size_t(i) >> 1];
+    int32_t nShift = (i & 1) * 4;
+    nByte = uint8_t((nByte & ~(0xF << nShift)) | (nLevel << nShift));
+  }
+
+  const uint8_t* Data() const { return vLevels.data(); }
+  uint8_t* Data() { return vLevels.data(); }
+
+  // New on every change, from one counter for all chunks, like
+  // Chunk::Revision().
+  uint64_t Revision() const { return nRevision; }
+  void Touch() { nRevision = NextRevision(); }
+
+ private:
+  static uint64_t NextRevision() {
+    static std::atomic<uint64_t> nCounter{0};
+    return ++nCounter;
+  }
+
+  std::array<uint8_t, nBytes> vLevels{};
+  uint64_t nRevision = NextRevision();
+};
+
+// Trailer of a Game_LightData message, pushed after the body. A full update
+// carries ChunkLight::nBytes of levels; a delta carries uint16 entries of
+// (tile index << 4) | level.
+struct sLightDataHeader {
+  int32_t cx = 0;
+  int32_t cy = 0;
+  uint32_t bFull = 0;
+};
+
+// Apply a Game_LightData body. Returns false if it is malformed.
+inline bool ApplyLightData(ChunkLight& light, const sLightDataHeader& header,
+                           const std::vector<uint8_t>& vBody) {
+  if (header.bFull) {
+    if (vBody.size() != ChunkLight::nBytes) return false;
+    std::memcpy(light.Data(), vBody.data(), ChunkLight::nBytes);
+  } else {
+    if (vBody.size() % sizeof(uint16_t)) return false;
+    for (size_t i = 0; i < vBody.size(); i += sizeof(uint16_t)) {
+      uint16_t nEntry;
+      std::memcpy(&nEntry, vBody.data() + i, sizeof(nEntry));
+      if ((nEntry >> 4) >= nChunkArea) return false;
+      light.Set(nEntry >> 4, nEntry & 0xF);
+    }
+  }
+  light.Touch();
+  return true;
+}
+
+// Server side light for every resident chunk.
+class LightEngine {
+ public:
+  // Tiles visited by the floods, since construction.
+  uint64_t nVisited = 0;
+
+  // Queue a newly resident chunk to be lit on the next Update().
+  void OnChunkLoaded(int32_t cx, int32_t cy) { vLoaded.push_back({cx, cy}); }
+
+  // Take a chunk's light out of its neighbours before it goes.
+  void OnChunkUnloaded(int32_t cx, int32_t cy) {
+    auto it = mapChunks.find(ChunkKey(cx, cy));
+    if (it == mapChunks.end()) return;
+    for (int32_t i = 0; i < nChunkArea; i++) {
+      uint8_t nLevel = it->second.light.Get(i);
+      if (nLevel)
+        vRemove.push_back({cx * nChunkSize + (i & (nChunkSize - 1)),
+                           cy * nChunkSize + (i >> nChunkShift), nLevel});
+    }
+    mapChunks.erase(it);
+    pLast = nullptr;
+  }
+
+  // Queue a tile whose emission or opacity may have changed.
+  void OnTileChanged(int32_t x, int32_t y) { vChanged.push_back({x, y, 0}); }
+
+  // Bring the light up to date with this tick's changes. Only resident
+  // chunks are lit, light never causes chunks to be loaded.
+  void Update(const World& world) {
+    for (auto [cx, cy] : vLoaded) LightChunk(world, cx, cy);
+    vLoaded.clear();
+
+    for (const sNode& change : vChanged) {
+      if (!FindLight(change.x, change.y)) continue;
+      uint8_t nOld = Level(change.x, change.y);
+      if (nOld) {
+        SetLevel(change.x, change.y, 0);
+        vRemove.push_back({change.x, change.y, nOld});
+      }
+    }
+    Remove(world);
+
+    for (const sNode& change : vChanged) {
+      if (!FindLight(change.x, change.y)) continue;
+      uint8_t nEmission = LightEmission(ResidentTile(world, change.x, change.y));
+      if (nEmission > Level(change.x, change.y)) {
+        SetLevel(change.x, change.y, nEmission);
+        vAdd.push_back({change.x, change.y, 0});
+      }
+      // Light on either side flows back in, e.g. through a removed wall.
+      for (int32_t d = 0; d < 4; d++) {
+        int32_t nx = change.x + vDirX[d], ny = change.y + vDirY[d];
+        if (Level(nx, ny) > 1) vAdd.push_back({nx, ny, 0});
+      }
+    }
+    vChanged.clear();
+    Add(world);
+  }
+
+  uint8_t Level(int32_t x, int32_t y) {
+    sLitChunk* pLit = FindLight(x, y);
+    return pLit ? pLit->light.Get(LocalIndex(x, y)) : 0;
+  }
+
+  // The whole light map of a chunk, as a Game_LightData body. False if the
+  // chunk is not lit (yet).
+  bool FullLight(int32_t cx, int32_t cy, std::vector<uint8_t>& vBody) const {
+    auto it = mapChunks.find(ChunkKey(cx, cy));
+    if (it == mapChunks.end()) return false;
+    vBody.assign(it->second.light.Data(),
+                 it->second.light.Data() + ChunkLight::nBytes);
+    return true;
+  }
+
+  // Calls f(header, vBody) with a Game_LightData update for every chunk whose
+  // light changed since the last call. Changes are deltas unless most of the
+  // chunk changed.
+  template <typename F>
+  void ConsumeChanges(F&& f) {
+    for (auto& [nKey, lit] : mapChunks) {
+      if (lit.vTouched.empty()) continue;
+
+      vBody.clear();
+      for (uint16_t i : lit.vTouched) {
+        lit.vMarked[i] = false;
+        uint8_t nLevel = lit.light.Get(i);
+        if (nLevel == lit.sent.Get(i)) continue;
+        lit.sent.Set(i, nLevel);
+        uint16_t nEntry = uint16_t((i << 4) | nLevel);
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&nEntry);
+        vBody.insert(vBody.end(), p, p + sizeof(nEntry));
+      }
+      lit.vTouched.clear();
+      if (vBody.empty()) continue;
+
+      sLightDataHeader header;
+      header.cx = int32_t(nKey >> 32);
+      header.cy = int32_t(uint32_t(nKey));
+      if (vBody.size() >= ChunkLight::nBytes) {
+        header.bFull = 1;
+        vBody.assign(lit.light.Data(), lit.light.Data() + ChunkLight::nBytes);
+      }
+      f(header, vBody);
+    }
+  }
+
+ private:
+  struct sNode {
+    int32_t x;
+    int32_t y;
+    uint8_t nLevel;
+  };
+
+  struct sLitChunk {
+    ChunkLight light;
+    // What clients were last told, and the tiles touched since.
+    ChunkLight sent;
+    std::vector<uint16_t> vTouched;
+    std::vector<bool> vMarked = std::vector<bool>(nChunkArea);
+  };
+
+  static constexpr int32_t vDirX[4] = {1, -1, 0, 0};
+  static constexpr int32_t vDirY[4] = {0, 0, 1, -1};
+
+  static int32_t LocalIndex(int32_t x, int32_t y) {
+    return TileInChunk(y) * nChunkSize + TileInChunk(x);
+  }
+
+  // Never goes to the chunk source; a chunk that is not resident is solid.
+  static Tile ResidentTile(const World& world, int32_t x, int32_t y) {
+    const Chunk* chunk = world.FindResidentChunk(TileToChunk(x), TileToChunk(y));
+    return chunk ? chunk->Get(TileInChunk(x), TileInChunk(y))
+                 : Tile(Tile_Wall);
+  }
+
+  // Light of the chunk holding tile (x, y), or nullptr if it is not lit.
+  // Floods walk neighbouring tiles, so the last chunk is remembered.
+  sLitChunk* FindLight(int32_t x, int32_t y) {
+    uint64_t nKey = ChunkKey(TileToChunk(x), TileToChunk(y));
+    if (pLast && nKey == nLastKey) return pLast;
+    auto it = mapChunks.find(nKey);
+    if (it == mapChunks.end()) return nullptr;
+    nLastKey = nKey;
+    pLast = &it->second;
+    return pLast;
+  }
+
+  void SetLevel(int32_t x, int32_t y, uint8_t nLevel) {
+    sLitChunk* pLit = FindLight(x, y);
+    if (!pLit) return;
+    int32_t i = LocalIndex(x, y);
+    pLit->light.Set(i, nLevel);
+    if (!pLit->vMarked[i]) {
+      pLit->vMarked[i] = true;
+      pLit->vTouched.push_back(uint16_t(i));
+    }
+  }
+
+  // Emitters of a newly resident chunk, and light already at its edges,
+  // spread into it.
+  void LightChunk(const World& world, int32_t cx, int32_t cy) {
+    const Chunk* chunk = world.FindResidentChunk(cx, cy);
+    if (!chunk || mapChunks.count(ChunkKey(cx, cy))) return;
+    mapChunks.emplace(ChunkKey(cx, cy), sLitChunk{});
+    pLast = nullptr;
+
+    int32_t x0 = cx * nChunkSize, y0 = cy * nChunkSize;
+    for (int32_t ly = 0; ly < nChunkSize; ly++)
+      for (int32_t lx = 0; lx < nChunkSize; lx++) {
+        uint8_t nEmission = LightEmission(chunk->Get(lx, ly));
+        if (!nEmission) continue;
+        SetLevel(x0 + lx, y0 + ly, nEmission);
+        vAdd.push_back({x0 + lx, y0 + ly, 0});
+      }
+
+    for (int32_t n = 0; n < nChunkSize; n++) {
+      const int32_t vEdgeX[4] = {x0 - 1, x0 + nChunkSize, x0 + n, x0 + n};
+      const int32_t vEdgeY[4] = {y0 + n, y0 + n, y0 - 1, y0 + nChunkSize};
+      for (int32_t d = 0; d < 4; d++)
+        if (Level(vEdgeX[d], vEdgeY[d]) > 1)
+          vAdd.push_back({vEdgeX[d], vEdgeY[d], 0});
+    }
+  }
+
+  // Clear light that came through the queued tiles. Neighbours at least as
+  // bright as what was removed have another source and are queued to
+  // spread again.
+  void Remove(const World& world) {
+    for (size_t nHead = 0; nHead < vRemove.size(); nHead++) {
+      sNode node = vRemove[nHead];
+      for (int32_t d = 0; d < 4; d++) {
+        int32_t nx = node.x + vDirX[d], ny = node.y + vDirY[d];
+        uint8_t nLevel = Level(nx, ny);
+        nVisited++;
+        if (nLevel == 0) continue;
+        if (nLevel >= node.nLevel) {
+          vAdd.push_back({nx, ny, 0});
+          continue;
+        }
+
+        SetLevel(nx, ny, 0);
+        vRemove.push_back({nx, ny, nLevel});
+        // An emitter is its own source.
+        uint8_t nEmission = LightEmission(ResidentTile(world, nx, ny));
+        if (nEmission) {
+          SetLevel(nx, ny, nEmission);
+          vAdd.push_back({nx, ny, 0});
+        }
+      }
+    }
+    vRemove.clear();
+  }
+
+  // Spread light out from the queued tiles.
+  void Add(const World& world) {
+    for (size_t nHead = 0; nHead < vAdd.size(); nHead++) {
+      sNode node = vAdd[nHead];
+      uint8_t nLevel = Level(node.x, node.y);
+      if (nLevel <= 1) continue;
+
+      for (int32_t d = 0; d < 4; d++) {
+        int32_t nx = node.x + vDirX[d], ny = node.y + vDirY[d];
+        nVisited++;
+        if (!FindLight(nx, ny) || Level(nx, ny) + 2 > nLevel) continue;
+        if (BlocksLight(ResidentTile(world, nx, ny))) continue;
+        SetLevel(nx, ny, nLevel - 1);
+        vAdd.push_back({nx, ny, 0});
+      }
+    }
+    vAdd.clear();
+  }
+
+  std::unordered_map<uint64_t, sLitChunk> mapChunks;
+  sLitChunk* pLast = nullptr;
+  uint64_t nLastKey = 0;
+
+  std::vector<std::pair<int32_t, int32_t>> vLoaded;
+  std::vector<sNode> vChanged;
+  std::vector<sNode> vRemove;
+  std::vector<sNode> vAdd;
+  std::vector<uint8_t> vBody;
+};
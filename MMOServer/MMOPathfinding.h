@@ -0,0 +1,443 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "MMOWorld.h"
+
+// Hierarchical pathfinding (HPA*) over the tile world.
+//
+// Chunks double as clusters. Where two neighbouring chunks share a run of
+// open tiles along their border there is an entrance: a pair of tiles, one
+// each side, joined by a step. Inside a cluster, the walking distance
+// between every pair of its entrance tiles is precomputed. A path search
+// then runs over that small graph of entrance tiles instead of over every
+// tile, and only the chosen route is refined back into single tile steps.
+//
+// Clusters are built the first time a search needs them and remember the
+// revisions of their own chunk and its four neighbours. When any of those
+// changes, only that cluster is rebuilt, the next time it is needed.
+//
+// Movement is 4-connected, every step costs 1.
+
+struct sTilePos {
+  int32_t x = 0;
+  int32_t y = 0;
+
+  bool operator==(const sTilePos& rhs) const {
+    return x == rhs.x && y == rhs.y;
+  }
+  bool operator!=(const sTilePos& rhs) const { return !(*this == rhs); }
+};
+
+class Pathfinder {
+ public:
+  // A search gives up after this many expansions, so an unreachable goal in
+  // an unbounded world still has a bounded cost...
+  size_t nMaxExpansions = 8192;
+  // ...and never strays more than this many chunks outside the box around
+  // its start and goal.
+  int32_t nSearchMargin = 4;
+
+  size_t nMaxCachedPaths = 4096;
+
+  // Statistics, for tuning.
+  size_t nSearches = 0;
+  size_t nCacheHits = 0;
+  size_t nClusterBuilds = 0;
+
+  // Find a path from start to goal, both included. Recently found paths are
+  // reused for as long as the chunks they cross stay unchanged, and failed
+  // searches for as long as every cluster they visited does.
+  bool FindPath(World& world, sTilePos start, sTilePos goal,
+                std::vector<sTilePos>& vPath) {
+    uint64_t nKey = PathKey(start, goal);
+    auto itCached = mapPathCache.find(nKey);
+    if (itCached != mapPathCache.end()) {
+      if (itCached->second.start == start && itCached->second.goal == goal &&
+          CachedPathValid(world, itCached->second)) {
+        nCacheHits++;
+        vPath = itCached->second.vPath;
+        return itCached->second.bFound;
+      }
+      mapPathCache.erase(itCached);
+    }
+
+    nSearches++;
+    bool bFound = Search(world, start, goal, vPath);
+    if (!bFound) vPath.clear();
+
+    if (mapPathCache.size() >= nMaxCachedPaths)
+      mapPathCache.erase(mapPathCache.begin());
+    sCachedPath& cached = mapPathCache[nKey];
+    cached.start = start;
+    cached.goal = goal;
+    cached.bFound = bFound;
+    cached.vPath = vPath;
+    cached.vChunks.clear();
+    if (bFound) {
+      for (const sTilePos& tile : vPath) {
+        int32_t cx = TileToChunk(tile.x), cy = TileToChunk(tile.y);
+        if (!cached.vChunks.empty() && cached.vChunks.back().cx == cx &&
+            cached.vChunks.back().cy == cy)
+          continue;
+        cached.vChunks.push_back({cx, cy, ChunkRevision(world, cx, cy)});
+      }
+      return bFound;
+    }
+
+    // A failed search depends on everything it looked at: the clusters of
+    // the endpoints and of every entrance it reached, each of which also
+    // depends on its neighbours' borders.
+    vSearchChunks.clear();
+    auto AddCluster = [&](sTilePos tile) {
+      int32_t cx = TileToChunk(tile.x), cy = TileToChunk(tile.y);
+      vSearchChunks.push_back(ChunkKey(cx, cy));
+      for (int32_t d = 0; d < 4; d++)
+        vSearchChunks.push_back(ChunkKey(cx + vDirX[d], cy + vDirY[d]));
+    };
+    AddCluster(start);
+    AddCluster(goal);
+    for (const auto& [nKey, visit] : mapVisited)
+      if (nKey != nGoalKey) AddCluster(KeyTile(nKey));
+    std::sort(vSearchChunks.begin(), vSearchChunks.end());
+    vSearchChunks.erase(std::unique(vSearchChunks.begin(), vSearchChunks.end()),
+                        vSearchChunks.end());
+    for (uint64_t nChunk : vSearchChunks) {
+      sTilePos chunk = KeyTile(nChunk);
+      cached.vChunks.push_back(
+          {chunk.x, chunk.y, ChunkRevision(world, chunk.x, chunk.y)});
+    }
+    return bFound;
+  }
+
+ private:
+  static constexpr uint16_t nUnreachable = 0xFFFF;
+  // Search sentinels. Every key is some tile's, so these are the keys of
+  // the last two tiles of the int32 range, in a chunk searches stay out of.
+  static constexpr uint64_t nGoalKey =
+      (uint64_t(INT32_MAX) << 32) | uint32_t(INT32_MAX);
+  static constexpr uint64_t nStartParent = nGoalKey - 1;
+  static constexpr int32_t nLastChunk = INT32_MAX >> nChunkShift;
+
+  // Entrance tile inside a cluster, and the tile across the border it steps
+  // to.
+  struct sNode {
+    int32_t nLocal;
+    sTilePos pair;
+  };
+
+  struct sCluster {
+    // Own chunk, then east, west, south, north.
+    std::array<uint64_t, 5> nRevisions{};
+    std::array<uint8_t, nChunkArea> bWalkable{};
+    std::vector<sNode> vNodes;
+    // vNodes.size()^2 walking distances, nUnreachable if none.
+    std::vector<uint16_t> vDistances;
+  };
+
+  struct sChunkRevision {
+    int32_t cx;
+    int32_t cy;
+    uint64_t nRevision;
+  };
+
+  struct sCachedPath {
+    sTilePos start;
+    sTilePos goal;
+    bool bFound = false;
+    std::vector<sTilePos> vPath;
+    std::vector<sChunkRevision> vChunks;
+  };
+
+  struct sVisit {
+    int32_t nCost;
+    uint64_t nParent;
+  };
+
+  struct sOpen {
+    int32_t nEstimate;
+    int32_t nCost;
+    uint64_t nKey;
+    bool operator>(const sOpen& rhs) const {
+      return nEstimate != rhs.nEstimate ? nEstimate > rhs.nEstimate
+                                        : nCost < rhs.nCost;
+    }
+  };
+
+  static constexpr int32_t vDirX[4] = {1, -1, 0, 0};
+  static constexpr int32_t vDirY[4] = {0, 0, 1, -1};
+
+  static uint64_t TileKey(sTilePos tile) { return ChunkKey(tile.x, tile.y); }
+  static sTilePos KeyTile(uint64_t nKey) {
+    return {int32_t(nKey >> 32), int32_t(uint32_t(nKey))};
+  }
+
+  static uint64_t PathKey(sTilePos start, sTilePos goal) {
+    uint64_t a = TileKey(start), b = TileKey(goal);
+    return a ^ (b * 0x9E3779B97F4A7C15ull + (a << 6) + (a >> 2));
+  }
+
+  static int32_t LocalIndex(sTilePos tile) {
+    return TileInChunk(tile.y) * nChunkSize + TileInChunk(tile.x);
+  }
+
+  static sTilePos LocalTile(int32_t cx, int32_t cy, int32_t nLocal) {
+    return {cx * nChunkSize + nLocal % nChunkSize,
+            cy * nChunkSize + nLocal / nChunkSize};
+  }
+
+  static uint64_t ChunkRevision(World& world, int32_t cx, int32_t cy) {
+    const Chunk* chunk = world.GetChunk(cx, cy);
+    return chunk ? chunk->Revision() : 0;
+  }
+
+  bool CachedPathValid(World& world, const sCachedPath& cached) const {
+    for (const auto& chunk : cached.vChunks)
+      if (ChunkRevision(world, chunk.cx, chunk.cy) != chunk.nRevision)
+        return false;
+    return true;
+  }
+
+  // The cluster for chunk (cx, cy), rebuilt if it or a neighbour changed.
+  const sCluster& GetCluster(World& world, int32_t cx, int32_t cy) {
+    std::array<uint64_t, 5> nRevisions = {
+        ChunkRevision(world, cx, cy), ChunkRevision(world, cx + 1, cy),
+        ChunkRevision(world, cx - 1, cy), ChunkRevision(world, cx, cy + 1),
+        ChunkRevision(world, cx, cy - 1)};
+
+    auto itCluster = mapClusters.find(ChunkKey(cx, cy));
+    if (itCluster != mapClusters.end() &&
+        itCluster->second.nRevisions == nRevisions)
+      return itCluster->second;
+
+    sCluster& cluster = mapClusters[ChunkKey(cx, cy)];
+    cluster.nRevisions = nRevisions;
+    BuildCluster(world, cx, cy, cluster);
+    nClusterBuilds++;
+    return cluster;
+  }
+
+  void BuildCluster(World& world, int32_t cx, int32_t cy, sCluster& cluster) {
+    const Chunk* chunk = world.GetChunk(cx, cy);
+    for (int32_t i = 0; i < nChunkArea; i++)
+      cluster.bWalkable[i] =
+          !chunk || !IsSolidTile(chunk->Get(i % nChunkSize, i / nChunkSize));
+
+    // Entrances along each border. Both clusters sharing a border see the
+    // same runs of open tiles, so they agree on where the entrances are.
+    cluster.vNodes.clear();
+    for (int32_t d = 0; d < 4; d++) {
+      const Chunk* neighbour = world.GetChunk(cx + vDirX[d], cy + vDirY[d]);
+      auto BorderTiles = [&](int32_t k, int32_t& nMine, int32_t& nTheirs) {
+        int32_t lx = vDirX[d] > 0 ? nChunkSize - 1 : vDirX[d] < 0 ? 0 : k;
+        int32_t ly = vDirY[d] > 0 ? nChunkSize - 1 : vDirY[d] < 0 ? 0 : k;
+        nMine = ly * nChunkSize + lx;
+        int32_t nx = TileInChunk(lx + vDirX[d]), ny = TileInChunk(ly + vDirY[d]);
+        nTheirs = ny * nChunkSize + nx;
+      };
+
+      int32_t nRunStart = -1;
+      for (int32_t k = 0; k <= nChunkSize; k++) {
+        bool bOpen = false;
+        int32_t nMine = 0, nTheirs = 0;
+        if (k < nChunkSize) {
+          BorderTiles(k, nMine, nTheirs);
+          bOpen = cluster.bWalkable[nMine] &&
+                  (!neighbour ||
+                   !IsSolidTile(neighbour->Get(nTheirs % nChunkSize,
+                                               nTheirs / nChunkSize)));
+        }
+        if (bOpen && nRunStart < 0) nRunStart = k;
+        if (bOpen || nRunStart < 0) continue;
+
+        // A run of open border tiles just ended. Long runs get an entrance
+        // at each end so paths do not all funnel through the middle.
+        int32_t nRunEnd = k - 1;
+        std::vector<int32_t> vAt;
+        if (nRunEnd - nRunStart + 1 >= 6)
+          vAt = {nRunStart, nRunEnd};
+        else
+          vAt = {(nRunStart + nRunEnd) / 2};
+        for (int32_t nAt : vAt) {
+          BorderTiles(nAt, nMine, nTheirs);
+          cluster.vNodes.push_back(
+              {nMine,
+               LocalTile(cx + vDirX[d], cy + vDirY[d], nTheirs)});
+        }
+        nRunStart = -1;
+      }
+    }
+
+    size_t n = cluster.vNodes.size();
+    cluster.vDistances.assign(n * n, nUnreachable);
+    for (size_t i = 0; i < n; i++) {
+      LocalBFS(cluster, cluster.vNodes[i].nLocal);
+      for (size_t j = 0; j < n; j++)
+        cluster.vDistances[i * n + j] = vLocalDistance[cluster.vNodes[j].nLocal];
+    }
+  }
+
+  // Breadth first search within one cluster from a local tile. Fills
+  // vLocalDistance and vLocalParent.
+  void LocalBFS(const sCluster& cluster, int32_t nFrom) {
+    vLocalDistance.fill(nUnreachable);
+    vLocalParent.fill(-1);
+    int32_t nHead = 0, nTail = 0;
+    vLocalQueue[nTail++] = nFrom;
+    vLocalDistance[nFrom] = 0;
+    while (nHead < nTail) {
+      int32_t i = vLocalQueue[nHead++];
+      int32_t x = i % nChunkSize, y = i / nChunkSize;
+      for (int32_t d = 0; d < 4; d++) {
+        int32_t nx = x + vDirX[d], ny = y + vDirY[d];
+        if (nx < 0 || ny < 0 || nx >= nChunkSize || ny >= nChunkSize) continue;
+        int32_t j = ny * nChunkSize + nx;
+        if (!cluster.bWalkable[j] || vLocalDistance[j] != nUnreachable)
+          continue;
+        vLocalDistance[j] = uint16_t(vLocalDistance[i] + 1);
+        vLocalParent[j] = int16_t(i);
+        vLocalQueue[nTail++] = j;
+      }
+    }
+  }
+
+  bool Search(World& world, sTilePos start, sTilePos goal,
+              std::vector<sTilePos>& vPath) {
+    mapVisited.clear();
+    if (world.IsSolid(start.x, start.y) || world.IsSolid(goal.x, goal.y))
+      return false;
+
+    int32_t csx = TileToChunk(start.x), csy = TileToChunk(start.y);
+    int32_t cgx = TileToChunk(goal.x), cgy = TileToChunk(goal.y);
+    int32_t nMinX = std::min(csx, cgx) - nSearchMargin;
+    int32_t nMaxX = std::max(csx, cgx) + nSearchMargin;
+    int32_t nMinY = std::min(csy, cgy) - nSearchMargin;
+    int32_t nMaxY = std::max(csy, cgy) + nSearchMargin;
+    if (nMaxX >= nLastChunk || nMaxY >= nLastChunk) return false;
+
+    // Distances from the goal within its cluster tell every entrance of
+    // that cluster how far it is from finishing.
+    const sCluster& clusterGoal = GetCluster(world, cgx, cgy);
+    LocalBFS(clusterGoal, LocalIndex(goal));
+    std::array<uint16_t, nChunkArea> vGoalDistance = vLocalDistance;
+
+    auto Heuristic = [&](sTilePos tile) {
+      return std::abs(tile.x - goal.x) + std::abs(tile.y - goal.y);
+    };
+
+    while (!qOpen.empty()) qOpen.pop();
+    auto Relax = [&](uint64_t nKey, int32_t nCost, uint64_t nParent) {
+      auto [itVisit, bNew] = mapVisited.try_emplace(nKey, sVisit{nCost, nParent});
+      if (!bNew) {
+        if (itVisit->second.nCost <= nCost) return;
+        itVisit->second = {nCost, nParent};
+      }
+      int32_t nEstimate =
+          nKey == nGoalKey ? nCost : nCost + Heuristic(KeyTile(nKey));
+      qOpen.push({nEstimate, nCost, nKey});
+    };
+
+    // The start is usually not an entrance, it reaches the entrances of
+    // its cluster by walking.
+    const sCluster& clusterStart = GetCluster(world, csx, csy);
+    LocalBFS(clusterStart, LocalIndex(start));
+    std::array<uint16_t, nChunkArea> vStartDistance = vLocalDistance;
+    uint64_t nStartKey = TileKey(start);
+    Relax(nStartKey, 0, nStartParent);
+
+    size_t nExpansions = 0;
+    bool bFound = false;
+    while (!qOpen.empty() && nExpansions < nMaxExpansions) {
+      sOpen open = qOpen.top();
+      qOpen.pop();
+      if (open.nKey == nGoalKey) {
+        bFound = true;
+        break;
+      }
+      if (mapVisited[open.nKey].nCost < open.nCost) continue;
+      nExpansions++;
+
+      sTilePos tile = KeyTile(open.nKey);
+      int32_t cx = TileToChunk(tile.x), cy = TileToChunk(tile.y);
+      const sCluster& cluster = GetCluster(world, cx, cy);
+      int32_t nLocal = LocalIndex(tile);
+
+      if (cx == cgx && cy == cgy && vGoalDistance[nLocal] != nUnreachable)
+        Relax(nGoalKey, open.nCost + vGoalDistance[nLocal], open.nKey);
+
+      if (open.nKey == nStartKey) {
+        for (const sNode& node : cluster.vNodes)
+          if (vStartDistance[node.nLocal] != nUnreachable)
+            Relax(TileKey(LocalTile(cx, cy, node.nLocal)),
+                  vStartDistance[node.nLocal], nStartKey);
+      }
+
+      size_t n = cluster.vNodes.size();
+      size_t nFirst = n;
+      for (size_t i = 0; i < n; i++) {
+        if (cluster.vNodes[i].nLocal != nLocal) continue;
+        if (nFirst == n) nFirst = i;
+
+        sTilePos pair = cluster.vNodes[i].pair;
+        int32_t px = TileToChunk(pair.x), py = TileToChunk(pair.y);
+        if (px >= nMinX && px <= nMaxX && py >= nMinY && py <= nMaxY)
+          Relax(TileKey(pair), open.nCost + 1, open.nKey);
+      }
+      if (nFirst == n) continue;
+
+      for (size_t j = 0; j < n; j++) {
+        uint16_t nDistance = cluster.vDistances[nFirst * n + j];
+        if (nDistance == nUnreachable || nDistance == 0) continue;
+        Relax(TileKey(LocalTile(cx, cy, cluster.vNodes[j].nLocal)),
+              open.nCost + nDistance, open.nKey);
+      }
+    }
+    if (!bFound) return false;
+
+    // Walk the parents back to the start, then refine each hop.
+    std::vector<sTilePos> vWaypoints = {goal};
+    for (uint64_t nKey = mapVisited[nGoalKey].nParent; nKey != nStartParent;
+         nKey = mapVisited[nKey].nParent)
+      vWaypoints.push_back(KeyTile(nKey));
+
+    vPath.clear();
+    vPath.push_back(start);
+    for (size_t w = vWaypoints.size() - 1; w-- > 0;)
+      Refine(world, vWaypoints[w + 1], vWaypoints[w], vPath);
+    return true;
+  }
+
+  // Append the tiles from a (excluded) to b (included). Hops are either a
+  // step across a border or a walk inside one cluster.
+  void Refine(World& world, sTilePos a, sTilePos b,
+              std::vector<sTilePos>& vPath) {
+    int32_t cx = TileToChunk(a.x), cy = TileToChunk(a.y);
+    if (cx != TileToChunk(b.x) || cy != TileToChunk(b.y)) {
+      vPath.push_back(b);
+      return;
+    }
+
+    LocalBFS(GetCluster(world, cx, cy), LocalIndex(a));
+    size_t nFirst = vPath.size();
+    for (int32_t i = LocalIndex(b); i != LocalIndex(a); i = vLocalParent[i])
+      vPath.push_back(LocalTile(cx, cy, i));
+    std::reverse(vPath.begin() + nFirst, vPath.end());
+  }
+
+  std::unordered_map<uint64_t, sCluster> mapClusters;
+  std::unordered_map<uint64_t, sCachedPath> mapPathCache;
+
+  // Search scratch space, kept between searches to avoid reallocating.
+  std::unordered_map<uint64_t, sVisit> mapVisited;
+  std::vector<uint64_t> vSearchChunks;
+  std::priority_queue<sOpen, std::vector<sOpen>, std::greater<sOpen>> qOpen;
+  std::array<uint16_t, nChunkArea> vLocalDistance;
+  std::array<int16_t, nChunkArea> vLocalParent;
+  std::array<int32_t, nChunkArea> vLocalQueue;
+};
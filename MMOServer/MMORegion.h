@@ -0,0 +1,400 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "MMOWorld.h"
+
+// Region files: where the world's chunks live on disk.
+//
+// Chunks are grouped into regions of 32 x 32 chunks, one file each, so the
+// world on disk is only as big as the parts of it that differ from what the
+// generator would make. A region file is a header, a table with one entry
+// per chunk, then the chunks, each run length encoded on top of its own
+// palette packing.
+//
+// Regions are memory mapped when first touched, so loading a chunk pages in
+// just that chunk and startup costs nothing however big the world has
+// grown. Saved chunks are handed to a writer thread, which rewrites each
+// affected region to a temporary file and renames it over the old one, the
+// same crash safe swap as snapshots. Until that is done, the chunk is served
+// from the bytes waiting to be written.
+
+constexpr int32_t nRegionShift = 5;
+constexpr int32_t nRegionSize = 1 << nRegionShift;  // 32 x 32 chunks
+constexpr int32_t nRegionArea = nRegionSize * nRegionSize;
+
+constexpr char sRegionMagic[8] = {'M', 'M', 'O', 'R', 'E', 'G', 'N', '\0'};
+constexpr uint32_t nRegionVersion = 1;
+
+struct sRegionHeader {
+  char sMagic[8];
+  uint32_t nVersion = nRegionVersion;
+  uint32_t nReserved = 0;
+};
+
+// Where a chunk is in its region file. nSize 0 means the region has no copy
+// of the chunk.
+struct sRegionEntry {
+  uint32_t nOffset = 0;
+  uint32_t nSize = 0;
+};
+
+constexpr size_t nRegionDataStart =
+    sizeof(sRegionHeader) + sizeof(sRegionEntry) * nRegionArea;
+
+// Run length encoding. A control byte c < 128 is followed by c + 1 literal
+// bytes; c >= 128 by one byte to be repeated c - 125 times. Packed chunks
+// are mostly long runs of the same word, which this takes care of.
+inline void RleCompress(const uint8_t* pData, size_t nSize,
+                        std::vector<uint8_t>& vOut) {
+  size_t i = 0;
+  while (i < nSize) {
+    size_t nRun = 1;
+    while (i + nRun < nSize && nRun < 130 && pData[i + nRun] == pData[i])
+      nRun++;
+    if (nRun >= 3) {
+      vOut.push_back(uint8_t(nRun + 125));
+      vOut.push_back(pData[i]);
+      i += nRun;
+      continue;
+    }
+
+    // Literals up to where the next run of three starts.
+    size_t nLiteral = 0;
+    while (i + nLiteral < nSize && nLiteral < 128) {
+      size_t j = i + nLiteral;
+      if (j + 2 < nSize && pData[j] == pData[j + 1] &&
+          pData[j] == pData[j + 2])
+        break;
+      nLiteral++;
+    }
+    vOut.push_back(uint8_t(nLiteral - 1));
+    vOut.insert(vOut.end(), pData + i, pData + i + nLiteral);
+    i += nLiteral;
+  }
+}
+
+// Returns false on malformed input.
+inline bool RleDecompress(const uint8_t* pData, size_t nSize,
+                          std::vector<uint8_t>& vOut) {
+  size_t i = 0;
+  while (i < nSize) {
+    uint8_t nControl = pData[i++];
+    if (nControl < 128) {
+      size_t nLiteral = size_t(nControl) + 1;
+      if (nLiteral > nSize - i) return false;
+      vOut.insert(vOut.end(), pData + i, pData + i + nLiteral);
+      i += nLiteral;
+    } else {
+      if (i == nSize) return false;
+      vOut.insert(vOut.end(), size_t(nControl) - 125, pData[i++]);
+    }
+  }
+  return true;
+}
+
+// Chunks in region files under one directory, loaded on demand and saved in
+// the background. Load() and Save() are for the game thread only.
+class RegionStore {
+ public:
+  explicit RegionStore(std::string sDirectory)
+      : sDirectory(std::move(sDirectory)) {
+    ::mkdir(this->sDirectory.c_str(), 0755);
+    thrWriter = std::thread([this]() { WriterThread(); });
+  }
+
+  ~RegionStore() {
+    {
+      std::scoped_lock lock(muxPending);
+      bQuit = true;
+    }
+    cvPending.notify_one();
+    if (thrWriter.joinable()) thrWriter.join();
+    for (auto& [nKey, region] : mapRegions) region.Close();
+  }
+
+  RegionStore(const RegionStore&) = delete;
+  RegionStore& operator=(const RegionStore&) = delete;
+
+  // The chunk as last saved, or nullptr if it never was.
+  std::unique_ptr<Chunk> Load(int32_t cx, int32_t cy) {
+    std::scoped_lock lock(muxPending);
+    vScratch.clear();
+
+    auto itPending = mapPending.find(ChunkKey(cx, cy));
+    if (itPending != mapPending.end()) {
+      vScratch = itPending->second.vBytes;
+    } else {
+      sMappedRegion& region = Region(cx >> nRegionShift, cy >> nRegionShift);
+      if (!region.pData) return nullptr;
+
+      const sRegionEntry& entry = region.Entry(LocalIndex(cx, cy));
+      if (entry.nSize == 0) return nullptr;
+      if (!RleDecompress(region.pData + entry.nOffset, entry.nSize, vScratch))
+        return nullptr;
+    }
+
+    auto chunk = std::make_unique<Chunk>();
+    if (!chunk->Deserialize(vScratch.data(), vScratch.size())) return nullptr;
+    return chunk;
+  }
+
+  // Queue a chunk, in Chunk::Serialize form, to be written.
+  void Save(int32_t cx, int32_t cy, std::vector<uint8_t>&& vBytes) {
+    {
+      std::scoped_lock lock(muxPending);
+      sPending& pending = mapPending[ChunkKey(cx, cy)];
+      pending.vBytes = std::move(vBytes);
+      pending.nSequence = ++nSaveSequence;
+      bHasWork = true;
+    }
+    cvPending.notify_one();
+  }
+
+  // Run fn on the writer thread once everything saved so far has been
+  // written out. fn is told whether every write succeeded.
+  void AfterWrites(std::function<void(bool bWritten)> fn) {
+    {
+      std::scoped_lock lock(muxPending);
+      vAfterWrites.push_back(std::move(fn));
+      bHasWork = true;
+    }
+    cvPending.notify_one();
+  }
+
+  size_t MappedRegionCount() const { return mapRegions.size(); }
+
+ private:
+  struct sMappedRegion {
+    const uint8_t* pData = nullptr;
+    size_t nSize = 0;
+    // Set once the file has been replaced underneath this mapping.
+    bool bStale = false;
+
+    const sRegionEntry& Entry(size_t i) const {
+      return reinterpret_cast<const sRegionEntry*>(
+          pData + sizeof(sRegionHeader))[i];
+    }
+
+    void Close() {
+      if (pData) ::munmap(const_cast<uint8_t*>(pData), nSize);
+      pData = nullptr;
+      nSize = 0;
+    }
+  };
+
+  struct sPending {
+    std::vector<uint8_t> vBytes;
+    uint64_t nSequence = 0;
+  };
+
+  static size_t LocalIndex(int32_t cx, int32_t cy) {
+    return size_t(cy & (nRegionSize - 1)) * nRegionSize +
+           size_t(cx & (nRegionSize - 1));
+  }
+
+  std::string RegionPath(int32_t rx, int32_t ry) const {
+    return sDirectory + "/r." + std::to_string(rx) + "." + std::to_string(ry) +
+           ".region";
+  }
+
+  // The mapping of a region, (re)opened if needed. A region with no file
+  // has a null mapping. Called with muxPending held.
+  sMappedRegion& Region(int32_t rx, int32_t ry) {
+    auto [it, bNew] = mapRegions.try_emplace(ChunkKey(rx, ry));
+    sMappedRegion& region = it->second;
+    if (!bNew && !region.bStale) return region;
+
+    region.Close();
+    region.bStale = false;
+    if (!MapFile(RegionPath(rx, ry), region.pData, region.nSize))
+      region = {};
+    return region;
+  }
+
+  static bool Validate(const uint8_t* pData, size_t nSize) {
+    if (nSize < nRegionDataStart) return false;
+    sRegionHeader header;
+    std::memcpy(&header, pData, sizeof(header));
+    if (std::memcmp(header.sMagic, sRegionMagic, sizeof(sRegionMagic)) ||
+        header.nVersion != nRegionVersion)
+      return false;
+
+    auto* pEntries =
+        reinterpret_cast<const sRegionEntry*>(pData + sizeof(sRegionHeader));
+    for (size_t i = 0; i < size_t(nRegionArea); i++) {
+      if (pEntries[i].nSize == 0) continue;
+      if (pEntries[i].nOffset < nRegionDataStart ||
+          pEntries[i].nOffset > nSize ||
+          pEntries[i].nSize > nSize - pEntries[i].nOffset)
+        return false;
+    }
+    return true;
+  }
+
+  static bool MapFile(const std::string& sPath, const uint8_t*& pData,
+                      size_t& nSize) {
+    int fd = ::open(sPath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+
+    void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+
+    if (!Validate(static_cast<const uint8_t*>(p), size_t(st.st_size))) {
+      std::cout << "[REGION] Ignoring damaged " << sPath << "\n";
+      ::munmap(p, size_t(st.st_size));
+      return false;
+    }
+    pData = static_cast<const uint8_t*>(p);
+    nSize = size_t(st.st_size);
+    return true;
+  }
+
+  void WriterThread() {
+    while (true) {
+      // Take a copy of everything waiting. Entries stay in mapPending, and
+      // so keep being served to Load(), until their region is on disk; a
+      // failed write is simply tried again next time.
+      std::unordered_map<uint64_t, std::vector<std::pair<uint64_t, sPending>>>
+          mapByRegion;
+      std::vector<std::function<void(bool)>> vCallbacks;
+      {
+        std::unique_lock<std::mutex> lock(muxPending);
+        cvPending.wait(lock, [this]() { return bHasWork || bQuit; });
+        // Pending work is still flushed on shutdown.
+        if (!bHasWork) return;
+        bHasWork = false;
+
+        for (const auto& [nKey, pending] : mapPending) {
+          int32_t cx = int32_t(nKey >> 32), cy = int32_t(uint32_t(nKey));
+          mapByRegion[ChunkKey(cx >> nRegionShift, cy >> nRegionShift)]
+              .push_back({nKey, pending});
+        }
+        vCallbacks.swap(vAfterWrites);
+      }
+
+      bool bAllWritten = true;
+      for (auto& [nRegionKey, vChunks] : mapByRegion) {
+        int32_t rx = int32_t(nRegionKey >> 32);
+        int32_t ry = int32_t(uint32_t(nRegionKey));
+        bool bWritten = WriteRegion(rx, ry, vChunks);
+        bAllWritten &= bWritten;
+        if (!bWritten)
+          std::cout << "[REGION] Failed to write " << RegionPath(rx, ry)
+                    << "\n";
+
+        std::scoped_lock lock(muxPending);
+        auto itRegion = mapRegions.find(nRegionKey);
+        if (itRegion != mapRegions.end()) itRegion->second.bStale = true;
+        // Done with, unless it was saved again in the meantime. On failure
+        // the bytes stay and are served from memory instead.
+        for (const auto& [nKey, pending] : vChunks) {
+          auto it = mapPending.find(nKey);
+          if (bWritten && it != mapPending.end() &&
+              it->second.nSequence == pending.nSequence)
+            mapPending.erase(it);
+        }
+      }
+
+      for (auto& fn : vCallbacks) fn(bAllWritten);
+    }
+  }
+
+  // Merge new chunks into the region's file, replacing it atomically.
+  bool WriteRegion(int32_t rx, int32_t ry,
+                   const std::vector<std::pair<uint64_t, sPending>>& vChunks) {
+    std::string sPath = RegionPath(rx, ry);
+
+    // Chunks currently in the file, as stored.
+    std::vector<std::pair<const uint8_t*, size_t>> vOld(nRegionArea);
+    const uint8_t* pOld = nullptr;
+    size_t nOldSize = 0;
+    if (MapFile(sPath, pOld, nOldSize)) {
+      auto* pEntries =
+          reinterpret_cast<const sRegionEntry*>(pOld + sizeof(sRegionHeader));
+      for (size_t i = 0; i < size_t(nRegionArea); i++)
+        if (pEntries[i].nSize)
+          vOld[i] = {pOld + pEntries[i].nOffset, pEntries[i].nSize};
+    }
+
+    std::vector<std::vector<uint8_t>> vNew(nRegionArea);
+    std::vector<bool> vReplaced(nRegionArea, false);
+    for (const auto& [nKey, pending] : vChunks) {
+      size_t i = LocalIndex(int32_t(nKey >> 32), int32_t(uint32_t(nKey)));
+      RleCompress(pending.vBytes.data(), pending.vBytes.size(), vNew[i]);
+      vReplaced[i] = true;
+    }
+
+    std::vector<uint8_t> vImage(nRegionDataStart, 0);
+    sRegionHeader header;
+    std::memcpy(header.sMagic, sRegionMagic, sizeof(sRegionMagic));
+    std::memcpy(vImage.data(), &header, sizeof(header));
+    for (size_t i = 0; i < size_t(nRegionArea); i++) {
+      const uint8_t* p = vReplaced[i] ? vNew[i].data() : vOld[i].first;
+      size_t n = vReplaced[i] ? vNew[i].size() : vOld[i].second;
+      sRegionEntry entry;
+      entry.nOffset = n ? uint32_t(vImage.size()) : 0;
+      entry.nSize = uint32_t(n);
+      std::memcpy(vImage.data() + sizeof(sRegionHeader) + i * sizeof(entry),
+                  &entry, sizeof(entry));
+      vImage.insert(vImage.end(), p, p + n);
+    }
+    if (pOld) ::munmap(const_cast<uint8_t*>(pOld), nOldSize);
+
+    std::string sTemp = sPath + ".tmp";
+    int fd = ::open(sTemp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    size_t nWritten = 0;
+    while (nWritten < vImage.size()) {
+      ssize_t n =
+          ::write(fd, vImage.data() + nWritten, vImage.size() - nWritten);
+      if (n <= 0) {
+        ::close(fd);
+        return false;
+      }
+      nWritten += size_t(n);
+    }
+
+    bool bSynced = ::fsync(fd) == 0;
+    ::close(fd);
+    return bSynced && ::rename(sTemp.c_str(), sPath.c_str()) == 0;
+  }
+
+  std::string sDirectory;
+  // Only touched by the game thread, apart from bStale.
+  std::unordered_map<uint64_t, sMappedRegion> mapRegions;
+  std::vector<uint8_t> vScratch;
+
+  std::thread thrWriter;
+  std::mutex muxPending;
+  std::condition_variable cvPending;
+  // Chunk key -> bytes not yet known to be on disk
+  std::unordered_map<uint64_t, sPending> mapPending;
+  std::vector<std::function<void(bool)>> vAfterWrites;
+  uint64_t nSaveSequence = 0;
+  bool bHasWork = false;
+  bool bQuit = false;
+};
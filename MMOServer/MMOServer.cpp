@@ -0,0 +1,711 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "../NetCommon/olc_net.h"
+#include "MMOBlockChanges.h"
+#include "MMOChunkStreaming.h"
+#include "MMOCommon.h"
+#include "MMOEntities.h"
+#include "MMOJobs.h"
+#include "MMOLighting.h"
+#include "MMORegion.h"
+#include "MMOSnapshot.h"
+#include "MMOSpatial.h"
+#include "MMOWorld.h"
+#include "MMOWorldGen.h"
+
+class GameServer : public olc::net::server_interface<GameMsg> {
+ public:
+  GameServer(uint16_t nPort, const std::string &sSnapshotPath,
+             const std::string &sRegionPath)
+      : olc::net::server_interface<GameMsg>(nPort),
+        m_snapshotWriter(sSnapshotPath),
+        m_regions(sRegionPath) {
+    // Pings are answered by the connections themselves, which gives every
+    // client an RTT/jitter estimate on this side too.
+    SetTimeSyncMessage(GameMsg::Server_GetPing);
+
+    // Clients only ever send us small fixed size messages, anything bigger
+    // is a broken or hostile client.
+    SetDefaultMaxMessageSize(4096);
+  }
+
+  // Every player and NPC. Players are entities owned by a connection.
+  EntityStore m_entities;
+
+  struct sPlayer {
+    EntityID nEntity = nInvalidEntity;
+    std::shared_ptr<olc::net::connection<GameMsg>> client;
+  };
+  // Connection ID -> that client's player
+  std::unordered_map<uint32_t, sPlayer> m_mapPlayers;
+
+  // Where every entity is, refreshed each tick.
+  SpatialHash m_spatial;
+
+  // Worker threads for tick phases that split into independent pieces.
+  JobSystem m_jobs;
+  // Entities integrated per job; smaller batches cost more than they save.
+  size_t m_nIntegrateGrain = 16384;
+
+  World m_world;
+
+  ChunkStreamer m_chunkStreamer;
+
+  LightEngine m_light;
+
+  struct sPendingLight {
+    std::shared_ptr<olc::net::connection<GameMsg>> client;
+    int32_t cx = 0;
+    int32_t cy = 0;
+  };
+  // Chunks sent to a client before they were lit, owed their light.
+  std::vector<sPendingLight> m_vPendingLight;
+
+  // Tile changes made this tick, sent to clients in one batch per chunk.
+  BlockChangeAccumulator m_blockChanges;
+
+  // All tile changes go through here, so light and clients follow them.
+  bool SetTile(int32_t x, int32_t y, Tile tile) {
+    int32_t cx = TileToChunk(x), cy = TileToChunk(y);
+    const Chunk *chunk = m_world.GetChunk(cx, cy);
+    // An empty chunk is streamed as revision 0.
+    uint64_t nRevision = chunk ? chunk->Revision() : 0;
+    Tile tileOld = m_world.GetTile(x, y);
+    if (!m_world.SetTile(x, y, tile)) return false;
+    if (!chunk) m_light.OnChunkLoaded(cx, cy);
+    m_light.OnTileChanged(x, y);
+    m_blockChanges.Record(x, y, tileOld, tile, nRevision);
+    return true;
+  }
+
+  // Restore the world and roster from a snapshot if there is a valid one,
+  // otherwise start a new world. Chunks are not read here, the world pulls
+  // them out of the region files, or generates them, the first time each one
+  // is touched.
+  void LoadWorld(const std::string &sSnapshotPath, uint64_t nNewSeed) {
+    auto tpStart = std::chrono::steady_clock::now();
+
+    MappedSnapshot &snapshot = m_restoredSnapshot;
+    if (snapshot.Open(sSnapshotPath)) {
+      size_t nPlayers = 0, nData = 0;
+      auto *pPlayers = snapshot.SectionArray<sPlayerDescription>(
+          SnapshotSection::Players, nPlayers);
+      m_pRestoredIndex = snapshot.SectionArray<sSnapshotChunkEntry>(
+          SnapshotSection::ChunkIndex, m_nRestoredChunks);
+      m_pRestoredData = snapshot.SectionArray<uint8_t>(
+          SnapshotSection::ChunkData, nData);
+      size_t nInfo = 0;
+      auto *pInfo = snapshot.SectionArray<sSnapshotWorldInfo>(
+          SnapshotSection::WorldInfo, nInfo);
+
+      // The chunk index is binary searched, so it must be strictly sorted.
+      bool bValid = true;
+      for (size_t i = 0; i < m_nRestoredChunks; i++) {
+        const sSnapshotChunkEntry &entry = m_pRestoredIndex[i];
+        bValid &= entry.nOffset <= nData &&
+                  entry.nSize <= nData - entry.nOffset;
+        bValid &= i == 0 || m_pRestoredIndex[i - 1] < entry;
+      }
+
+      if (bValid) {
+        if (nInfo == 1) {
+          m_generator = WorldGenerator(pInfo->nSeed);
+          m_bGenerated = true;
+        }
+        m_world.SetChunkSource(
+            [this](int32_t cx, int32_t cy) { return LoadChunk(cx, cy); });
+
+        // Only server owned entities are saved. They come back under new
+        // IDs.
+        for (size_t i = 0; i < nPlayers; i++) {
+          EntityID nEntity = m_entities.Create();
+          if (nEntity == nInvalidEntity) break;
+          SetEntityState(m_entities.Find(nEntity), pPlayers[i]);
+        }
+        m_nSnapshotSequence = snapshot.Header().nSequence + 1;
+
+        auto tpEnd = std::chrono::steady_clock::now();
+        std::cout << "[SERVER] Restored snapshot "
+                  << snapshot.Header().nSequence << " ("
+                  << m_nRestoredChunks << " chunks) in "
+                  << std::chrono::duration<double, std::milli>(tpEnd - tpStart)
+                         .count()
+                  << "ms\n";
+        return;
+      }
+    }
+
+    snapshot.Close();
+    m_pRestoredIndex = nullptr;
+    m_nRestoredChunks = 0;
+    m_generator = WorldGenerator(nNewSeed);
+    m_bGenerated = true;
+    m_world.SetChunkSource(
+        [this](int32_t cx, int32_t cy) { return LoadChunk(cx, cy); });
+    PregenerateSpawn();
+
+    // The hand made map stays where players spawn.
+    m_world.LoadFromString(sDefaultWorldMap, nDefaultWorldWidth,
+                           nDefaultWorldHeight);
+    // Record the seed straight away, the region files mean nothing without
+    // it.
+    TakeSnapshot();
+
+    auto tpEnd = std::chrono::steady_clock::now();
+    std::cout << "[SERVER] No snapshot, generated world " << nNewSeed << " ("
+              << m_world.ResidentChunkCount() << " chunks) in "
+              << std::chrono::duration<double, std::milli>(tpEnd - tpStart)
+                     .count()
+              << "ms\n";
+  }
+
+  // Generate the chunks around spawn up front, across every core, so the
+  // first players do not wait on them one tick at a time.
+  void PregenerateSpawn() {
+    std::vector<std::pair<int32_t, int32_t>> vCoords;
+    for (int32_t cy = -m_nSpawnRadius; cy <= m_nSpawnRadius; cy++)
+      for (int32_t cx = -m_nSpawnRadius; cx <= m_nSpawnRadius; cx++)
+        vCoords.push_back({cx, cy});
+
+    auto vChunks = m_generator.GenerateMany(vCoords, m_jobs);
+    for (size_t i = 0; i < vCoords.size(); i++) {
+      auto [cx, cy] = vCoords[i];
+      m_mapCleanRevisions[ChunkKey(cx, cy)] = vChunks[i]->Revision();
+      m_world.InsertChunk(cx, cy, std::move(vChunks[i]));
+      m_light.OnChunkLoaded(cx, cy);
+    }
+  }
+
+  // Called once per server tick from main.
+  void OnTick() {
+    auto tpNow = std::chrono::steady_clock::now();
+    RemoveDisconnectedClients();
+    uint64_t nNow = olc::net::SteadyMicroseconds();
+    StopBlockedEntities(nNow);
+    m_jobs.ParallelFor(0, m_entities.Size(), m_nIntegrateGrain,
+                       [&](size_t nBegin, size_t nEnd) {
+                         m_entities.Integrate(nNow, nBegin, nEnd);
+                       });
+    for (size_t i = 0; i < m_entities.Size(); i++)
+      m_spatial.Move(m_entities.vID[i], m_entities.vPosX[i],
+                     m_entities.vPosY[i]);
+    BroadcastChanges();
+    BroadcastBlockChanges();
+    m_light.Update(m_world);
+    BroadcastLight();
+
+    if (tpNow >= m_tpNextSnapshot) {
+      TakeSnapshot();
+      m_tpNextSnapshot = tpNow + m_snapshotInterval;
+    }
+
+    StreamChunks();
+  }
+
+  // Send every entity that changed since the last tick to everyone, except
+  // back to the client it came from. Updates arriving several times within a
+  // tick go out once.
+  void BroadcastChanges() {
+    m_vOutgoing.clear();
+    m_entities.ConsumeDirty([this](size_t i) {
+      olc::net::message<GameMsg> msg;
+      msg.header.id = (m_entities.vDirty[i] & Dirty_Spawned)
+                          ? GameMsg::Game_AddPlayer
+                          : GameMsg::Game_UpdatePlayer;
+      msg << DescribeEntity(i);
+      uint32_t nOwner = m_entities.vOwnerKind[i] == Owner_Client
+                            ? m_entities.vOwner[i]
+                            : 0;
+      m_vOutgoing.push_back({std::move(msg), nOwner, m_entities.vDirty[i]});
+    });
+
+    // Sending can discover dead connections and destroy their players, so
+    // that must not happen while walking the entity arrays.
+    for (auto &[msg, nOwner, nDirty] : m_vOutgoing) {
+      std::shared_ptr<olc::net::connection<GameMsg>> pOwner;
+      auto itOwner = m_mapPlayers.find(nOwner);
+      if (nOwner != 0 && itOwner != m_mapPlayers.end())
+        pOwner = itOwner->second.client;
+
+      // The owner knows its own player from Client_AssignID, and only
+      // hears about it again when the server overrules it.
+      bool bCorrected = pOwner && (nDirty & Dirty_Corrected);
+      bool bSpawned = nDirty & Dirty_Spawned;
+      MessageAllClients(msg, bCorrected && !bSpawned ? nullptr : pOwner,
+                        olc::net::priority::high);
+      // Overruled in the tick it joined, so the owner gets it as an update.
+      if (bCorrected && bSpawned) {
+        msg.header.id = GameMsg::Game_UpdatePlayer;
+        MessageClient(pOwner, msg, olc::net::priority::high);
+      }
+    }
+
+    for (EntityID nEntity : m_vRemoved) {
+      olc::net::message<GameMsg> msg;
+      msg.header.id = GameMsg::Game_RemovePlayer;
+      msg << nEntity;
+      MessageAllClients(msg);
+    }
+    m_vRemoved.clear();
+  }
+
+  // Send this tick's tile changes to the clients holding the chunks they
+  // were made to. A client with any other version of a chunk is left to
+  // StreamChunks, which sends it whole, as is everyone when the batch would
+  // be bigger than the chunk. Batches ride the bulk lane so they land after
+  // the chunk they apply to.
+  void BroadcastBlockChanges() {
+    m_blockChanges.Consume([&](const sBlockChangeHeader &header,
+                               uint64_t nBaseRevision,
+                               const std::vector<uint8_t> &vBody) {
+      const Chunk *chunk = m_world.FindResidentChunk(header.cx, header.cy);
+      // Rewriting most of a chunk is cheaper to send as the chunk itself.
+      if (!chunk || vBody.size() >= chunk->SerializedSize()) return;
+      for (auto &client : m_deqConnections) {
+        if (!client || !client->IsConnected() ||
+            !m_chunkStreamer.AdvanceSent(client->GetID(), header.cx,
+                                         header.cy, nBaseRevision,
+                                         chunk->Revision()))
+          continue;
+        // Changes that cancelled out only needed the revision moved on.
+        if (header.nCount == 0) continue;
+        olc::net::message<GameMsg> msg;
+        msg.header.id = GameMsg::Game_BlockChanges;
+        msg.body = vBody;
+        msg << header;
+        client->Send(std::move(msg), olc::net::priority::bulk);
+      }
+    });
+  }
+
+  // Send light that changed this tick to the clients holding those chunks.
+  // Light rides the bulk lane behind the chunk it belongs to, so it can
+  // never arrive ahead of it.
+  void BroadcastLight() {
+    m_light.ConsumeChanges(
+        [&](const sLightDataHeader &header, const std::vector<uint8_t> &vBody) {
+          for (auto &client : m_deqConnections) {
+            if (!client || !client->IsConnected() ||
+                !m_chunkStreamer.ClientHasChunk(client->GetID(), header.cx,
+                                                header.cy))
+              continue;
+            olc::net::message<GameMsg> msg;
+            msg.header.id = GameMsg::Game_LightData;
+            msg.body = vBody;
+            msg << header;
+            client->Send(std::move(msg), olc::net::priority::bulk);
+          }
+        });
+  }
+
+  // Top up every client with the chunks around its view. Chunks go on the
+  // bulk lane so they never hold up player updates.
+  void StreamChunks() {
+    // Chunks that were sent before they had been lit get their light now,
+    // unless they have been dropped since.
+    size_t nKept = 0;
+    for (sPendingLight &pending : m_vPendingLight) {
+      if (!pending.client->IsConnected() ||
+          !m_chunkStreamer.ClientHasChunk(pending.client->GetID(),
+                                          pending.cx, pending.cy) ||
+          SendFullLight(*pending.client, pending.cx, pending.cy))
+        continue;
+      m_vPendingLight[nKept++] = std::move(pending);
+    }
+    m_vPendingLight.resize(nKept);
+
+    for (auto &client : m_deqConnections) {
+      if (!client || !client->IsConnected()) continue;
+
+      m_chunkStreamer.Stream(
+          client->GetID(), m_world, m_nChunkBytesPerTick,
+          [&](int32_t cx, int32_t cy, const std::vector<uint8_t> &vBytes) {
+            olc::net::message<GameMsg> msg;
+            msg.header.id = GameMsg::Game_ChunkData;
+            msg.body = vBytes;
+            msg << sChunkDataHeader{cx, cy};
+            client->Send(std::move(msg), olc::net::priority::bulk);
+
+            // A chunk loaded this tick is lit on the next one.
+            if (!SendFullLight(*client, cx, cy))
+              m_vPendingLight.push_back({client, cx, cy});
+          });
+    }
+  }
+
+  // Follow a chunk with its whole light map. False if it is not lit yet.
+  bool SendFullLight(olc::net::connection<GameMsg> &client, int32_t cx,
+                     int32_t cy) {
+    sLightDataHeader lightHeader;
+    lightHeader.cx = cx;
+    lightHeader.cy = cy;
+    lightHeader.bFull = 1;
+    olc::net::message<GameMsg> light;
+    light.header.id = GameMsg::Game_LightData;
+    if (!m_light.FullLight(cx, cy, light.body)) return false;
+    light << lightHeader;
+    client.Send(std::move(light), olc::net::priority::bulk);
+    return true;
+  }
+
+  // Save every changed chunk to the region files and the roster to the
+  // snapshot. Both are written on threads of their own; the game thread only
+  // pays for serializing. The snapshot goes out after the chunks it follows
+  // are on disk.
+  void TakeSnapshot() {
+    // Players belong to their connections and register again when they come
+    // back, so only server owned entities are kept.
+    std::vector<sPlayerDescription> vPlayers;
+    for (size_t i = 0; i < m_entities.Size(); i++)
+      if (m_entities.vOwnerKind[i] == Owner_Server)
+        vPlayers.push_back(DescribeEntity(i));
+
+    m_world.ForEachResidentChunk(
+        [&](int32_t cx, int32_t cy, const Chunk &chunk) {
+          uint64_t &nClean = m_mapCleanRevisions[ChunkKey(cx, cy)];
+          if (nClean == chunk.Revision()) return;
+
+          std::vector<uint8_t> vBytes;
+          chunk.Serialize(vBytes);
+          m_regions.Save(cx, cy, std::move(vBytes));
+          nClean = chunk.Revision();
+        });
+
+    // Snapshots from before region files kept chunks inside themselves.
+    // Whatever was not loaded since is moved over once, as it is.
+    for (size_t i = 0; i < m_nRestoredChunks; i++) {
+      const sSnapshotChunkEntry &entry = m_pRestoredIndex[i];
+      if (m_world.FindResidentChunk(entry.cx, entry.cy)) continue;
+
+      const uint8_t *pBytes = m_pRestoredData + entry.nOffset;
+      m_regions.Save(entry.cx, entry.cy,
+                     std::vector<uint8_t>(pBytes, pBytes + entry.nSize));
+    }
+    m_pRestoredIndex = nullptr;
+    m_nRestoredChunks = 0;
+
+    EvictIdleChunks();
+
+    sSnapshotWorldInfo info;
+    info.nSeed = m_generator.Seed();
+
+    SnapshotBuilder builder;
+    if (m_bGenerated)
+      builder.AddSection(SnapshotSection::WorldInfo, &info, sizeof(info));
+    builder.AddSection(SnapshotSection::Players, vPlayers.data(),
+                       vPlayers.size() * sizeof(sPlayerDescription));
+    // A snapshot must not refer to chunks that never reached disk, so on a
+    // failed write the previous one stands until the next attempt.
+    m_regions.AfterWrites(
+        [this, vImage = builder.Finish(m_nSnapshotSequence++,
+                                       olc::net::SteadyMicroseconds())](
+            bool bWritten) mutable {
+          if (bWritten)
+            m_snapshotWriter.Submit(std::move(vImage));
+          else
+            std::cout << "[SNAPSHOT] Skipped, chunks were not saved\n";
+        });
+  }
+
+  // Drop chunks that are saved and that no client can see, so memory follows
+  // where the players are rather than how much of the world exists. They
+  // come back from the region files, or the generator, when needed.
+  void EvictIdleChunks() {
+    std::vector<std::pair<int32_t, int32_t>> vIdle;
+    m_world.ForEachResidentChunk(
+        [&](int32_t cx, int32_t cy, const Chunk &chunk) {
+          auto itClean = m_mapCleanRevisions.find(ChunkKey(cx, cy));
+          if (itClean == m_mapCleanRevisions.end() ||
+              itClean->second != chunk.Revision())
+            return;
+          if (m_chunkStreamer.AnyViewNear(cx, cy, nChunkEvictMargin)) return;
+          // Spawn stays ready for the next player to join.
+          if (std::abs(cx) <= m_nSpawnRadius && std::abs(cy) <= m_nSpawnRadius)
+            return;
+          vIdle.push_back({cx, cy});
+        });
+
+    for (auto [cx, cy] : vIdle) {
+      m_light.OnChunkUnloaded(cx, cy);
+      m_world.EraseChunk(cx, cy);
+      m_mapCleanRevisions.erase(ChunkKey(cx, cy));
+    }
+  }
+
+ protected:
+  bool OnClientConnect(
+      std::shared_ptr<olc::net::connection<GameMsg>> client) override {
+    return true;
+  }
+
+  void onClientValidated(
+      std::shared_ptr<olc::net::connection<GameMsg>> client) override {
+    olc::net::message<GameMsg> msg;
+    msg.header.id = GameMsg::Client_Accepted;
+    client->Send(msg);
+  }
+
+  void OnClientDisconnect(
+      std::shared_ptr<olc::net::connection<GameMsg>> client) override {
+    if (!client) return;
+
+    m_chunkStreamer.RemoveClient(client->GetID());
+
+    // This can be called from inside MessageAllClients, so the removal is
+    // only announced on the next tick.
+    auto itPlayer = m_mapPlayers.find(client->GetID());
+    if (itPlayer == m_mapPlayers.end()) return;
+    m_spatial.Remove(itPlayer->second.nEntity);
+    if (m_entities.Destroy(itPlayer->second.nEntity))
+      m_vRemoved.push_back(itPlayer->second.nEntity);
+    m_mapPlayers.erase(itPlayer);
+  }
+
+  void OnMessage(std::shared_ptr<olc::net::connection<GameMsg>> client,
+                 olc::net::message<GameMsg> &msg) override {
+    switch (msg.header.id) {
+      case GameMsg::Client_RegisterWithServer: {
+        if (m_mapPlayers.count(client->GetID())) break;
+        if (msg.body.size() != sizeof(sPlayerDescription)) break;
+        EntityID nEntity =
+            m_entities.Create(Owner_Client, client->GetID());
+        if (nEntity == nInvalidEntity) break;
+
+        sPlayerDescription desc;
+        msg >> desc;
+        SetEntityState(m_entities.Find(nEntity), desc);
+        m_mapPlayers[client->GetID()] = {nEntity, client};
+
+        // Everybody, the newcomer included, hears about the new player from
+        // the next tick's broadcast.
+        olc::net::message<GameMsg> msgID;
+        msgID.header.id = GameMsg::Client_AssignID;
+        msgID << nEntity;
+        MessageClient(client, msgID);
+
+        // Tell the newcomer about everybody already here
+        for (size_t i = 0; i < m_entities.Size(); i++) {
+          if (m_entities.vID[i] == nEntity) continue;
+          olc::net::message<GameMsg> msgOther;
+          msgOther.header.id = GameMsg::Game_AddPlayer;
+          msgOther << DescribeEntity(i);
+          MessageClient(client, msgOther);
+        }
+        break;
+      }
+
+      case GameMsg::Client_ViewRect: {
+        if (msg.body.size() != sizeof(sViewRect)) break;
+        sViewRect view;
+        msg >> view;
+        m_chunkStreamer.SetView(client->GetID(), view);
+        break;
+      }
+
+      // Clients may only edit chunks they have been sent.
+      case GameMsg::Client_SetTile: {
+        if (msg.body.size() != sizeof(sTileEdit)) break;
+        sTileEdit edit;
+        msg >> edit;
+        if (edit.nTile != Tile_Floor && edit.nTile != Tile_Wall &&
+            edit.nTile != Tile_Lamp)
+          break;
+        if (!m_chunkStreamer.ClientHasChunk(client->GetID(),
+                                            TileToChunk(edit.x),
+                                            TileToChunk(edit.y)))
+          break;
+        SetTile(edit.x, edit.y, edit.nTile);
+        break;
+      }
+
+      case GameMsg::Client_UnregisterWithServer:
+        OnClientDisconnect(client);
+        break;
+
+      case GameMsg::Game_UpdatePlayer: {
+        auto itPlayer = m_mapPlayers.find(client->GetID());
+        if (itPlayer == m_mapPlayers.end()) break;
+        if (msg.body.size() != sizeof(sPlayerDescription)) break;
+
+        // Clients may only move their own player, whatever ID they send.
+        sPlayerDescription desc;
+        msg >> desc;
+        size_t i = m_entities.Find(itPlayer->second.nEntity);
+        if (i == EntityStore::npos) break;
+
+        // Nobody walks through or stands inside a wall, or moves more than
+        // a chunk in one update. Keep the player where it was and tell its
+        // client so.
+        float fFromX = m_entities.vPosX[i], fFromY = m_entities.vPosY[i];
+        if (!std::isfinite(desc.fPosX) || !std::isfinite(desc.fPosY) ||
+            !std::isfinite(desc.fVelX) || !std::isfinite(desc.fVelY) ||
+            std::abs(desc.fPosX - fFromX) > float(nChunkSize) ||
+            std::abs(desc.fPosY - fFromY) > float(nChunkSize) ||
+            SweepHitsSolid(m_world, fFromX, fFromY, desc.fPosX,
+                           desc.fPosY)) {
+          m_entities.vVelX[i] = 0.0f;
+          m_entities.vVelY[i] = 0.0f;
+          m_entities.vDirty[i] |= Dirty_Corrected;
+          break;
+        }
+
+        SetEntityState(i, desc);
+        m_entities.vDirty[i] |= Dirty_Position | Dirty_Velocity;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+ private:
+  sPlayerDescription DescribeEntity(size_t i) const {
+    sPlayerDescription desc;
+    desc.nUniqueID = m_entities.vID[i];
+    desc.nTimestamp = m_entities.vTimestamp[i];
+    desc.fPosX = m_entities.vPosX[i];
+    desc.fPosY = m_entities.vPosY[i];
+    desc.fVelX = m_entities.vVelX[i];
+    desc.fVelY = m_entities.vVelY[i];
+    return desc;
+  }
+
+  // State is stamped with server time of arrival, so remote clients can
+  // interpolate everything against one clock. Anything non-finite is zeroed
+  // and velocities are held to the fastest a player may move.
+  void SetEntityState(size_t i, const sPlayerDescription &desc) {
+    auto Finite = [](float f) { return std::isfinite(f) ? f : 0.0f; };
+    float fVelX = Finite(desc.fVelX), fVelY = Finite(desc.fVelY);
+    float fSpeed = std::hypot(fVelX, fVelY);
+    if (fSpeed > fMaxPlayerSpeed) {
+      fVelX *= fMaxPlayerSpeed / fSpeed;
+      fVelY *= fMaxPlayerSpeed / fSpeed;
+    }
+    m_entities.vPosX[i] = Finite(desc.fPosX);
+    m_entities.vPosY[i] = Finite(desc.fPosY);
+    m_entities.vVelX[i] = fVelX;
+    m_entities.vVelY[i] = fVelY;
+    m_entities.vTimestamp[i] = olc::net::SteadyMicroseconds();
+    m_entities.vUpdated[i] = m_entities.vTimestamp[i];
+  }
+
+  // Sweeps this tick's step of every moving entity through the world before
+  // it is integrated, which does not look at the world. Entities that would
+  // hit a wall stop where they are, and their owners are told. Entities that
+  // have run out of extrapolation stop too, as they do on the clients.
+  void StopBlockedEntities(uint64_t nNow) {
+    for (size_t i = 0; i < m_entities.Size(); i++) {
+      float fVelX = m_entities.vVelX[i], fVelY = m_entities.vVelY[i];
+      if (fVelX == 0.0f && fVelY == 0.0f) continue;
+
+      float fStep = m_entities.IntegrationTime(i, nNow);
+      float fPosX = m_entities.vPosX[i], fPosY = m_entities.vPosY[i];
+      bool bBlocked =
+          fStep > 0.0f && SweepHitsSolid(m_world, fPosX, fPosY,
+                                         fPosX + fVelX * fStep,
+                                         fPosY + fVelY * fStep);
+      bool bExpired = fStep == 0.0f && nNow - m_entities.vUpdated[i] >=
+                                           EntityStore::nMaxExtrapolation;
+      if (!bBlocked && !bExpired) continue;
+
+      if (bBlocked) m_entities.vDirty[i] |= Dirty_Position | Dirty_Corrected;
+      m_entities.vVelX[i] = 0.0f;
+      m_entities.vVelY[i] = 0.0f;
+      m_entities.vDirty[i] |= Dirty_Velocity;
+    }
+  }
+
+  // Chunk source for the world: the region files, then a snapshot from
+  // before region files, then the generator. Chunks are remembered at the
+  // revision they arrived with, so saving can tell which have changed since.
+  std::unique_ptr<Chunk> LoadChunk(int32_t cx, int32_t cy) {
+    auto chunk = m_regions.Load(cx, cy);
+    bool bClean = true;
+    if (!chunk) {
+      // Never clean, these are not in the region files yet.
+      chunk = LoadRestoredChunk(cx, cy);
+      bClean = !chunk;
+    }
+    if (!chunk && m_bGenerated) chunk = m_generator.Generate(cx, cy);
+    if (!chunk) return nullptr;
+
+    if (bClean) m_mapCleanRevisions[ChunkKey(cx, cy)] = chunk->Revision();
+    m_light.OnChunkLoaded(cx, cy);
+    return chunk;
+  }
+
+  std::unique_ptr<Chunk> LoadRestoredChunk(int32_t cx, int32_t cy) {
+    if (!m_pRestoredIndex) return nullptr;
+    sSnapshotChunkEntry key;
+    key.cx = cx;
+    key.cy = cy;
+    auto *pEnd = m_pRestoredIndex + m_nRestoredChunks;
+    auto *pEntry = std::lower_bound(m_pRestoredIndex, pEnd, key);
+    if (pEntry == pEnd || pEntry->cx != cx || pEntry->cy != cy) return nullptr;
+
+    auto chunk = std::make_unique<Chunk>();
+    if (!chunk->Deserialize(m_pRestoredData + pEntry->nOffset, pEntry->nSize))
+      return nullptr;
+    return chunk;
+  }
+
+  WorldGenerator m_generator;
+  // False for worlds restored from before generation existed.
+  bool m_bGenerated = false;
+  // Chunk key -> revision matching the region files or the generator
+  std::unordered_map<uint64_t, uint64_t> m_mapCleanRevisions;
+  // Chunks either side of the origin generated before the server opens.
+  int32_t m_nSpawnRadius = 8;
+
+  SnapshotWriter m_snapshotWriter;
+  // After the snapshot writer, so its last writes can still hand it one.
+  RegionStore m_regions;
+  MappedSnapshot m_restoredSnapshot;
+  const sSnapshotChunkEntry *m_pRestoredIndex = nullptr;
+  size_t m_nRestoredChunks = 0;
+  const uint8_t *m_pRestoredData = nullptr;
+  uint64_t m_nSnapshotSequence = 0;
+  // Message, owner connection ID and the dirty flags that caused it
+  std::vector<std::tuple<olc::net::message<GameMsg>, uint32_t, uint8_t>>
+      m_vOutgoing;
+  std::vector<EntityID> m_vRemoved;
+  // 32KB a tick is 640KB/s per client at 20Hz.
+  size_t m_nChunkBytesPerTick = 32 * 1024;
+  std::chrono::seconds m_snapshotInterval{10};
+  std::chrono::steady_clock::time_point m_tpNextSnapshot =
+      std::chrono::steady_clock::now() + m_snapshotInterval;
+};
+
+int main(int argc, char *argv[]) {
+  GameServer server(60000, "world.snap", "regions");
+  // A new world gets a new seed, unless one is given on the command line.
+  uint64_t nSeed = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                            : std::random_device{}();
+  server.LoadWorld("world.snap", nSeed);
+  server.Start();
+
+  // Fixed rate server tick, incoming messages are drained once per tick.
+  const auto tickInterval = std::chrono::milliseconds(50);
+  auto tpNextTick = std::chrono::steady_clock::now();
+  while (1) {
+    server.Update();
+    server.OnTick();
+
+    tpNextTick += tickInterval;
+    std::this_thread::sleep_until(tpNextTick);
+  }
+
+  return 0;
+}
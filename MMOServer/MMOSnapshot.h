@@ -0,0 +1,312 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Server state snapshots.
+//
+// A snapshot is a single binary file: a header, a table of sections, then the
+// section payloads, each 8 byte aligned so they can be used in place once the
+// file is memory mapped. Sections are flat arrays of POD, so restoring is a
+// lookup in the mapping with no parsing up front, however big the world.
+//
+// Files are written to a temporary name, flushed to disk and then renamed
+// over the previous snapshot. Rename is atomic, so after a crash the file on
+// disk is always either the old snapshot or the new one, never a torn mix.
+
+constexpr char sSnapshotMagic[8] = {'M', 'M', 'O', 'S', 'N', 'A', 'P', '\0'};
+// Version 3 added the WorldInfo section. Version 2 files are still read,
+// they restore without a generator.
+constexpr uint32_t nSnapshotVersion = 3;
+constexpr uint32_t nMinSnapshotVersion = 2;
+
+enum class SnapshotSection : uint32_t {
+  Players = 3,
+  ChunkIndex = 4,
+  ChunkData = 5,
+  WorldInfo = 6,
+};
+
+struct sSnapshotHeader {
+  char sMagic[8];
+  uint32_t nVersion = nSnapshotVersion;
+  uint32_t nSectionCount = 0;
+  uint64_t nSequence = 0;
+  int64_t nServerTime = 0;
+  uint64_t nFileSize = 0;
+};
+
+struct sSnapshotSectionEntry {
+  SnapshotSection nType{};
+  uint32_t nReserved = 0;
+  uint64_t nOffset = 0;
+  uint64_t nSize = 0;
+};
+
+// One serialized chunk within the ChunkData section. The ChunkIndex section
+// is an array of these sorted by (cx, cy), so a chunk can be found by binary
+// search straight out of the mapping without building anything first.
+struct sSnapshotChunkEntry {
+  int32_t cx = 0;
+  int32_t cy = 0;
+  uint32_t nSize = 0;
+  uint32_t nReserved = 0;
+  uint64_t nOffset = 0;
+
+  bool operator<(const sSnapshotChunkEntry& rhs) const {
+    return cx != rhs.cx ? cx < rhs.cx : cy < rhs.cy;
+  }
+};
+
+// Settings the world was created with. Snapshots without this section come
+// from before worlds were generated, and have no terrain beyond their chunks.
+struct sSnapshotWorldInfo {
+  uint64_t nSeed = 0;
+};
+
+// Gathers sections into one contiguous image on the game thread. This is the
+// only part of taking a snapshot that costs the game thread anything, and it
+// is a memcpy per section. Section data is not copied until Finish(), so it
+// must stay untouched until then.
+class SnapshotBuilder {
+ public:
+  void AddSection(SnapshotSection nType, const void* pData, size_t nSize) {
+    vSections.push_back({nType, 0, 0, nSize});
+    vPayloads.push_back(static_cast<const uint8_t*>(pData));
+  }
+
+  std::vector<uint8_t> Finish(uint64_t nSequence, int64_t nServerTime) {
+    size_t nOffset = Align(sizeof(sSnapshotHeader) +
+                           sizeof(sSnapshotSectionEntry) * vSections.size());
+    for (auto& section : vSections) {
+      section.nOffset = nOffset;
+      nOffset = Align(nOffset + section.nSize);
+    }
+
+    sSnapshotHeader header;
+    std::memcpy(header.sMagic, sSnapshotMagic, sizeof(sSnapshotMagic));
+    header.nSectionCount = uint32_t(vSections.size());
+    header.nSequence = nSequence;
+    header.nServerTime = nServerTime;
+    header.nFileSize = nOffset;
+
+    std::vector<uint8_t> vImage(nOffset, 0);
+    std::memcpy(vImage.data(), &header, sizeof(header));
+    std::memcpy(vImage.data() + sizeof(header), vSections.data(),
+                sizeof(sSnapshotSectionEntry) * vSections.size());
+    for (size_t i = 0; i < vSections.size(); i++)
+      std::memcpy(vImage.data() + vSections[i].nOffset, vPayloads[i],
+                  vSections[i].nSize);
+
+    vSections.clear();
+    vPayloads.clear();
+    return vImage;
+  }
+
+ private:
+  static size_t Align(size_t n) { return (n + 7) & ~size_t(7); }
+
+  std::vector<sSnapshotSectionEntry> vSections;
+  std::vector<const uint8_t*> vPayloads;
+};
+
+// Writes snapshot images to disk on a thread of its own. Submit() never
+// blocks on IO; if the writer is still busy with an older image when a new
+// one arrives, the older pending one is simply replaced.
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(std::string sPath) : sPath(std::move(sPath)) {
+    thrWriter = std::thread([this]() { WriterThread(); });
+  }
+
+  ~SnapshotWriter() {
+    {
+      std::scoped_lock lock(muxPending);
+      bQuit = true;
+    }
+    cvPending.notify_one();
+    if (thrWriter.joinable()) thrWriter.join();
+  }
+
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+  void Submit(std::vector<uint8_t>&& vImage) {
+    {
+      std::scoped_lock lock(muxPending);
+      vPending = std::move(vImage);
+      bHasPending = true;
+    }
+    cvPending.notify_one();
+  }
+
+ private:
+  void WriterThread() {
+    while (true) {
+      std::vector<uint8_t> vImage;
+      {
+        std::unique_lock<std::mutex> lock(muxPending);
+        cvPending.wait(lock, [this]() { return bHasPending || bQuit; });
+        // Pending work is still flushed on shutdown.
+        if (!bHasPending) return;
+        vImage = std::move(vPending);
+        bHasPending = false;
+      }
+
+      if (!WriteFile(vImage))
+        std::cout << "[SNAPSHOT] Failed to write " << sPath << "\n";
+    }
+  }
+
+  bool WriteFile(const std::vector<uint8_t>& vImage) {
+    std::string sTemp = sPath + ".tmp";
+    int fd = ::open(sTemp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    size_t nWritten = 0;
+    while (nWritten < vImage.size()) {
+      ssize_t n =
+          ::write(fd, vImage.data() + nWritten, vImage.size() - nWritten);
+      if (n <= 0) {
+        ::close(fd);
+        return false;
+      }
+      nWritten += size_t(n);
+    }
+
+    // The data must be on disk before the rename makes it the snapshot.
+    bool bSynced = ::fsync(fd) == 0;
+    ::close(fd);
+    return bSynced && ::rename(sTemp.c_str(), sPath.c_str()) == 0;
+  }
+
+  std::string sPath;
+  std::thread thrWriter;
+  std::mutex muxPending;
+  std::condition_variable cvPending;
+  std::vector<uint8_t> vPending;
+  bool bHasPending = false;
+  bool bQuit = false;
+};
+
+// A snapshot file mapped into memory. Opening only validates the header and
+// section table, section payloads are paged in as they are touched. The
+// mapping is private, so a writable one is copy-on-write: sections can serve
+// directly as live state without ever modifying the file.
+class MappedSnapshot {
+ public:
+  MappedSnapshot() = default;
+  ~MappedSnapshot() { Close(); }
+
+  MappedSnapshot(const MappedSnapshot&) = delete;
+  MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+  bool Open(const std::string& sPath, bool bWritable = false) {
+    Close();
+
+    int fd = ::open(sPath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(sSnapshotHeader)) {
+      ::close(fd);
+      return false;
+    }
+
+    int nProt = bWritable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* p = ::mmap(nullptr, size_t(st.st_size), nProt, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+
+    pData = static_cast<uint8_t*>(p);
+    nSize = size_t(st.st_size);
+
+    if (!Validate()) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void Close() {
+    if (pData) ::munmap(pData, nSize);
+    pData = nullptr;
+    nSize = 0;
+  }
+
+  const sSnapshotHeader& Header() const {
+    return *reinterpret_cast<const sSnapshotHeader*>(pData);
+  }
+
+  // Returns the payload of a section, or nullptr if the snapshot has none.
+  const uint8_t* Section(SnapshotSection nType, size_t& nSectionSize) const {
+    for (const auto& entry : Sections()) {
+      if (entry.nType == nType) {
+        nSectionSize = size_t(entry.nSize);
+        return pData + entry.nOffset;
+      }
+    }
+    nSectionSize = 0;
+    return nullptr;
+  }
+
+  // Typed view over a section holding an array of T. Only write through it
+  // if the snapshot was opened writable.
+  template <typename T>
+  T* SectionArray(SnapshotSection nType, size_t& nCount) const {
+    size_t nBytes = 0;
+    const uint8_t* p = Section(nType, nBytes);
+    nCount = nBytes / sizeof(T);
+    return reinterpret_cast<T*>(const_cast<uint8_t*>(p));
+  }
+
+ private:
+  struct section_range {
+    const sSnapshotSectionEntry* pBegin;
+    const sSnapshotSectionEntry* pEnd;
+    const sSnapshotSectionEntry* begin() const { return pBegin; }
+    const sSnapshotSectionEntry* end() const { return pEnd; }
+  };
+
+  section_range Sections() const {
+    auto* p = reinterpret_cast<const sSnapshotSectionEntry*>(
+        pData + sizeof(sSnapshotHeader));
+    return {p, p + Header().nSectionCount};
+  }
+
+  bool Validate() const {
+    const sSnapshotHeader& header = Header();
+    if (std::memcmp(header.sMagic, sSnapshotMagic, sizeof(sSnapshotMagic)))
+      return false;
+    if (header.nVersion < nMinSnapshotVersion ||
+        header.nVersion > nSnapshotVersion)
+      return false;
+    if (header.nFileSize != nSize) return false;
+
+    size_t nTable = sizeof(sSnapshotHeader) +
+                    sizeof(sSnapshotSectionEntry) * header.nSectionCount;
+    if (nTable > nSize) return false;
+
+    for (const auto& entry : Sections()) {
+      if (entry.nOffset % 8 != 0 || entry.nOffset > nSize ||
+          entry.nSize > nSize - entry.nOffset)
+        return false;
+    }
+    return true;
+  }
+
+  uint8_t* pData = nullptr;
+  size_t nSize = 0;
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "MMOEntities.h"
+#include "MMOWorld.h"
+
+// Spatial index over entities and the tile world.
+//
+// Entities are bucketed into square cells of 2^nCellShift tiles, hashed on
+// cell coordinates, so a query only looks at the cells its area touches
+// rather than at every entity. The index keeps its own copy of positions, so
+// filtering never goes back to the entity store. Moving an entity within its
+// cell is a plain store; the hash is only touched when it changes cells.
+//
+// Queries write into a buffer the caller owns and never allocate.
+
+class SpatialHash {
+ public:
+  explicit SpatialHash(int32_t nCellShift = 3) : nCellShift(nCellShift) {}
+
+  size_t Size() const { return nCount; }
+
+  bool Contains(EntityID id) const { return FindLocation(id) != nullptr; }
+
+  // Add an entity, or move it if it is already in the index.
+  void Insert(EntityID id, float x, float y) { Move(id, x, y); }
+
+  void Move(EntityID id, float x, float y) {
+    uint64_t nCell = CellKey(x, y);
+    sLocation* pLocation = FindLocation(id);
+    if (pLocation) {
+      pLocation->x = x;
+      pLocation->y = y;
+      if (pLocation->nCell == nCell) return;
+      Unlink(*pLocation);
+    } else {
+      uint32_t nIndex = EntityIndex(id);
+      if (nIndex >= vLocations.size()) vLocations.resize(nIndex + 1);
+      pLocation = &vLocations[nIndex];
+      *pLocation = {id, 0, 0, x, y};
+      nCount++;
+    }
+
+    std::vector<EntityID>& vCell = mapCells[nCell];
+    pLocation->nCell = nCell;
+    pLocation->nSlot = uint32_t(vCell.size());
+    vCell.push_back(id);
+  }
+
+  void Remove(EntityID id) {
+    sLocation* pLocation = FindLocation(id);
+    if (!pLocation) return;
+    Unlink(*pLocation);
+    pLocation->id = nInvalidEntity;
+    nCount--;
+  }
+
+  // Entities with x0 <= x < x1 and y0 <= y < y1. Writes at most nMax IDs to
+  // pOut and returns how many it wrote; a return of nMax may mean there
+  // were more.
+  size_t QueryAABB(float x0, float y0, float x1, float y1, EntityID* pOut,
+                   size_t nMax) const {
+    size_t nFound = 0;
+    ForEachCell(x0, y0, x1, y1, [&](const std::vector<EntityID>& vCell) {
+      for (EntityID id : vCell) {
+        if (nFound == nMax) return false;
+        const sLocation& item = vLocations[EntityIndex(id)];
+        if (item.x >= x0 && item.x < x1 && item.y >= y0 && item.y < y1)
+          pOut[nFound++] = id;
+      }
+      return true;
+    });
+    return nFound;
+  }
+
+  // Entities within fRadius of (x, y). Same buffer rules as QueryAABB.
+  size_t QueryRadius(float x, float y, float fRadius, EntityID* pOut,
+                     size_t nMax) const {
+    float fRadius2 = fRadius * fRadius;
+    size_t nFound = 0;
+    ForEachCell(x - fRadius, y - fRadius, x + fRadius, y + fRadius,
+                [&](const std::vector<EntityID>& vCell) {
+                  for (EntityID id : vCell) {
+                    if (nFound == nMax) return false;
+                    const sLocation& item = vLocations[EntityIndex(id)];
+                    float dx = item.x - x, dy = item.y - y;
+                    if (dx * dx + dy * dy <= fRadius2) pOut[nFound++] = id;
+                  }
+                  return true;
+                });
+    return nFound;
+  }
+
+ private:
+  // Where an entity is, indexed by its slot in the entity store. The ID is
+  // kept so a stale handle to a reused slot is not mistaken for it.
+  struct sLocation {
+    EntityID id = nInvalidEntity;
+    uint32_t nSlot = 0;
+    uint64_t nCell = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+  };
+
+  int32_t ToCell(float f) const {
+    return int32_t(std::floor(f)) >> nCellShift;
+  }
+
+  uint64_t CellKey(float x, float y) const {
+    return ChunkKey(ToCell(x), ToCell(y));
+  }
+
+  sLocation* FindLocation(EntityID id) {
+    uint32_t nIndex = EntityIndex(id);
+    if (nIndex >= vLocations.size() || vLocations[nIndex].id != id)
+      return nullptr;
+    return &vLocations[nIndex];
+  }
+
+  const sLocation* FindLocation(EntityID id) const {
+    return const_cast<SpatialHash*>(this)->FindLocation(id);
+  }
+
+  // Take an entity out of its cell. The cell's last item fills the gap.
+  void Unlink(const sLocation& location) {
+    auto itCell = mapCells.find(location.nCell);
+    std::vector<EntityID>& vCell = itCell->second;
+    if (location.nSlot != vCell.size() - 1) {
+      vCell[location.nSlot] = vCell.back();
+      vLocations[EntityIndex(vCell[location.nSlot])].nSlot = location.nSlot;
+    }
+    vCell.pop_back();
+    if (vCell.empty()) mapCells.erase(itCell);
+  }
+
+  // Calls f(cell) for every occupied cell overlapping the box until it
+  // returns false.
+  template <typename F>
+  void ForEachCell(float x0, float y0, float x1, float y1, F&& f) const {
+    int32_t cx0 = ToCell(x0), cy0 = ToCell(y0);
+    int32_t cx1 = ToCell(x1), cy1 = ToCell(y1);
+    for (int32_t cy = cy0; cy <= cy1; cy++)
+      for (int32_t cx = cx0; cx <= cx1; cx++) {
+        auto itCell = mapCells.find(ChunkKey(cx, cy));
+        if (itCell != mapCells.end() && !f(itCell->second)) return;
+      }
+  }
+
+  int32_t nCellShift;
+  size_t nCount = 0;
+  std::unordered_map<uint64_t, std::vector<EntityID>> mapCells;
+  std::vector<sLocation> vLocations;
+};
+
+// Does the box x0 <= x < x1, y0 <= y < y1 touch any solid tile?
+inline bool BoxHitsSolid(World& world, float x0, float y0, float x1, float y1) {
+  int32_t tx0 = int32_t(std::floor(x0)), ty0 = int32_t(std::floor(y0));
+  int32_t tx1 = int32_t(std::ceil(x1)), ty1 = int32_t(std::ceil(y1));
+  for (int32_t ty = ty0; ty < ty1; ty++)
+    for (int32_t tx = tx0; tx < tx1; tx++)
+      if (world.IsSolid(tx, ty)) return true;
+  return false;
+}
+
+// Does a point moving in a straight line from (x0, y0) to (x1, y1) touch any
+// solid tile? The move is swept in steps of at most one tile, each tested as
+// the box it covers, so a long move cannot hop over a wall. Corners are
+// treated as solid if either side is.
+inline bool SweepHitsSolid(World& world, float x0, float y0, float x1,
+                           float y1) {
+  float dx = x1 - x0, dy = y1 - y0;
+  int32_t nSteps =
+      std::max(1, int32_t(std::ceil(std::max(std::abs(dx), std::abs(dy)))));
+  float ax = x0, ay = y0;
+  for (int32_t s = 1; s <= nSteps; s++) {
+    float t = float(s) / float(nSteps);
+    float bx = x0 + dx * t, by = y0 + dy * t;
+    // Boxes exclude their far edge, so nudge it out to cover the end point.
+    if (BoxHitsSolid(world, std::min(ax, bx), std::min(ay, by),
+                     std::nextafter(std::max(ax, bx), INFINITY),
+                     std::nextafter(std::max(ay, by), INFINITY)))
+      return true;
+    ax = bx;
+    ay = by;
+  }
+  return false;
+}
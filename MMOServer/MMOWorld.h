@@ -0,0 +1,368 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Tile world shared by the server and the client.
+//
+// The world is an unbounded grid of tiles split into fixed size chunks. A
+// chunk that has never been written is not allocated at all and reads as
+// Tile_Floor. Allocated chunks store a small palette of the distinct tiles
+// they contain plus a bit packed array of palette indices, so a chunk of one
+// or two kinds of tile costs 0 or 1 bit per tile. Chunks with too much
+// variety for a 16 entry palette store raw 16 bit tiles instead.
+
+using Tile = uint16_t;
+enum : Tile {
+  Tile_Floor = 0,
+  Tile_Wall = 1,
+  Tile_Lamp = 2,
+};
+
+// Tiles nothing can stand in or move through.
+inline bool IsSolidTile(Tile tile) { return tile == Tile_Wall; }
+
+constexpr int32_t nChunkShift = 5;
+constexpr int32_t nChunkSize = 1 << nChunkShift;  // 32 x 32 tiles
+constexpr int32_t nChunkArea = nChunkSize * nChunkSize;
+
+// Chunk coordinates of the chunk holding tile (x, y), and the tile's position
+// inside it. Shifts and masks floor correctly for negative coordinates.
+inline int32_t TileToChunk(int32_t n) { return n >> nChunkShift; }
+inline int32_t TileInChunk(int32_t n) { return n & (nChunkSize - 1); }
+
+inline uint64_t ChunkKey(int32_t cx, int32_t cy) {
+  return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+}
+
+class Chunk {
+ public:
+  Chunk(Tile fill = Tile_Floor)
+      : vPalette{fill}, nRevision(NextRevision()) {}
+
+  Tile Get(int32_t lx, int32_t ly) const {
+    return GetIndex(ly * nChunkSize + lx);
+  }
+
+  // Returns true if the tile actually changed.
+  bool Set(int32_t lx, int32_t ly, Tile tile) {
+    int32_t i = ly * nChunkSize + lx;
+    if (GetIndex(i) == tile) return false;
+
+    if (nBits == 16) {
+      WriteBits(i, tile);
+    } else {
+      WriteBits(i, PaletteIndex(tile));
+    }
+    nRevision = NextRevision();
+    return true;
+  }
+
+  // Set tiles pIndices[k] (row order) to pTiles[k]. New tiles are added to
+  // the palette together, so the chunk is repacked at most once however many
+  // there are. Returns how many tiles actually changed.
+  size_t SetMany(const uint16_t* pIndices, const Tile* pTiles, size_t n) {
+    if (nBits != 16) {
+      std::vector<Tile> vNew;
+      for (size_t k = 0; k < n; k++) {
+        bool bFound = false;
+        for (Tile p : vPalette) bFound |= (p == pTiles[k]);
+        for (Tile p : vNew) bFound |= (p == pTiles[k]);
+        if (!bFound) vNew.push_back(pTiles[k]);
+      }
+      if (!vNew.empty()) {
+        int32_t nNeeded = BitsForPalette(vPalette.size() + vNew.size());
+        std::vector<Tile> vTiles;
+        if (nNeeded != nBits) {
+          vTiles.resize(nChunkArea);
+          for (int32_t i = 0; i < nChunkArea; i++) vTiles[i] = GetIndex(i);
+        }
+        vPalette.insert(vPalette.end(), vNew.begin(), vNew.end());
+        if (nNeeded != nBits) Repack(vTiles, nNeeded);
+      }
+    }
+
+    size_t nChanged = 0;
+    for (size_t k = 0; k < n; k++) {
+      if (GetIndex(pIndices[k]) == pTiles[k]) continue;
+      WriteBits(pIndices[k],
+                nBits == 16 ? pTiles[k] : PaletteIndex(pTiles[k]));
+      nChanged++;
+    }
+    if (nChanged) nRevision = NextRevision();
+    return nChanged;
+  }
+
+  // New on every change. Revisions are drawn from one counter for all
+  // chunks, so a chunk that is replaced by another never looks unchanged to
+  // a cache built from the old one.
+  uint64_t Revision() const { return nRevision; }
+
+  size_t MemoryUsage() const {
+    return sizeof(Chunk) + vPalette.capacity() * sizeof(Tile) +
+           vData.capacity() * sizeof(uint64_t);
+  }
+
+  // Rebuild the palette from the tiles actually in use, dropping entries
+  // that were overwritten and shrinking the index width where possible.
+  void Compact() {
+    std::vector<Tile> vTiles(nChunkArea);
+    for (int32_t i = 0; i < nChunkArea; i++) vTiles[i] = GetIndex(i);
+
+    // Same tiles, so caches built from this chunk are still good.
+    uint64_t nKeepRevision = nRevision;
+    Assign(vTiles.data());
+    nRevision = nKeepRevision;
+  }
+
+  // Replace every tile at once from nChunkArea tiles in row order, which is
+  // much cheaper than setting them one by one.
+  void Assign(const Tile* pTiles) {
+    std::vector<Tile> vTiles(pTiles, pTiles + nChunkArea);
+    vPalette.assign(1, vTiles[0]);
+    for (Tile tile : vTiles) {
+      if (vPalette.size() > 16) break;
+      bool bFound = false;
+      for (Tile p : vPalette) bFound |= (p == tile);
+      if (!bFound) vPalette.push_back(tile);
+    }
+
+    Repack(vTiles, BitsForPalette(vPalette.size()));
+    nRevision = NextRevision();
+  }
+
+  // Compact binary form: bits, palette length, palette, packed words.
+  void Serialize(std::vector<uint8_t>& vOut) const {
+    uint16_t nHeader[2] = {uint16_t(nBits), uint16_t(vPalette.size())};
+    Append(vOut, nHeader, sizeof(nHeader));
+    Append(vOut, vPalette.data(), vPalette.size() * sizeof(Tile));
+    Append(vOut, vData.data(), vData.size() * sizeof(uint64_t));
+  }
+
+  size_t SerializedSize() const {
+    return 2 * sizeof(uint16_t) + vPalette.size() * sizeof(Tile) +
+           vData.size() * sizeof(uint64_t);
+  }
+
+  bool Deserialize(const uint8_t* pData, size_t nSize) {
+    uint16_t nHeader[2];
+    if (nSize < sizeof(nHeader)) return false;
+    std::memcpy(nHeader, pData, sizeof(nHeader));
+
+    int32_t nNewBits = nHeader[0];
+    size_t nPalette = nHeader[1];
+    if (nNewBits != 0 && nNewBits != 1 && nNewBits != 2 && nNewBits != 4 &&
+        nNewBits != 16)
+      return false;
+    if (nNewBits == 16 ? nPalette != 0 : nPalette == 0 || nPalette > 16)
+      return false;
+    size_t nWords = size_t(nChunkArea) * nNewBits / 64;
+    if (nSize != sizeof(nHeader) + nPalette * sizeof(Tile) +
+                     nWords * sizeof(uint64_t))
+      return false;
+
+    nBits = nNewBits;
+    vPalette.resize(nPalette);
+    vData.resize(nWords);
+    std::memcpy(vPalette.data(), pData + sizeof(nHeader),
+                nPalette * sizeof(Tile));
+    std::memcpy(vData.data(),
+                pData + sizeof(nHeader) + nPalette * sizeof(Tile),
+                nWords * sizeof(uint64_t));
+    nRevision = NextRevision();
+
+    // Never trust indices from outside, a bad one would read past the
+    // palette later.
+    if (nBits != 0 && nBits != 16) {
+      for (int32_t i = 0; i < nChunkArea; i++) {
+        if (ReadBits(i) >= vPalette.size()) {
+          *this = Chunk();
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  static uint64_t NextRevision() {
+    static std::atomic<uint64_t> nCounter{0};
+    return nCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  // Index widths are powers of two so an entry never straddles two words.
+  static int32_t BitsForPalette(size_t nEntries) {
+    if (nEntries <= 1) return 0;
+    if (nEntries <= 2) return 1;
+    if (nEntries <= 4) return 2;
+    if (nEntries <= 16) return 4;
+    return 16;
+  }
+
+  Tile GetIndex(int32_t i) const {
+    if (nBits == 0) return vPalette[0];
+    uint32_t nValue = ReadBits(i);
+    return nBits == 16 ? Tile(nValue) : vPalette[nValue];
+  }
+
+  uint32_t ReadBits(int32_t i) const {
+    uint32_t nBit = uint32_t(i) * nBits;
+    uint64_t nMask = (uint64_t(1) << nBits) - 1;
+    return uint32_t((vData[nBit >> 6] >> (nBit & 63)) & nMask);
+  }
+
+  void WriteBits(int32_t i, uint32_t nValue) {
+    uint32_t nBit = uint32_t(i) * nBits;
+    uint64_t nMask = (uint64_t(1) << nBits) - 1;
+    uint64_t& nWord = vData[nBit >> 6];
+    nWord = (nWord & ~(nMask << (nBit & 63))) |
+            (uint64_t(nValue) << (nBit & 63));
+  }
+
+  // Palette index for a tile, growing the palette (and the index width) if
+  // the tile is new to this chunk. Only called while nBits < 16.
+  uint32_t PaletteIndex(Tile tile) {
+    for (size_t i = 0; i < vPalette.size(); i++)
+      if (vPalette[i] == tile) return uint32_t(i);
+
+    int32_t nNeeded = BitsForPalette(vPalette.size() + 1);
+    if (nNeeded != nBits) {
+      std::vector<Tile> vTiles(nChunkArea);
+      for (int32_t i = 0; i < nChunkArea; i++) vTiles[i] = GetIndex(i);
+      vPalette.push_back(tile);
+      Repack(vTiles, nNeeded);
+      return nBits == 16 ? tile : uint32_t(vPalette.size() - 1);
+    }
+
+    vPalette.push_back(tile);
+    return uint32_t(vPalette.size() - 1);
+  }
+
+  // Re-encode the given tiles at a new index width against vPalette.
+  void Repack(const std::vector<Tile>& vTiles, int32_t nNewBits) {
+    nBits = nNewBits;
+    vData.assign(size_t(nChunkArea) * nBits / 64, 0);
+    if (nBits == 16) vPalette.clear();
+    if (nBits == 0) return;
+
+    for (int32_t i = 0; i < nChunkArea; i++) {
+      uint32_t nValue = vTiles[i];
+      if (nBits != 16) {
+        for (size_t p = 0; p < vPalette.size(); p++)
+          if (vPalette[p] == vTiles[i]) nValue = uint32_t(p);
+      }
+      WriteBits(i, nValue);
+    }
+  }
+
+  static void Append(std::vector<uint8_t>& vOut, const void* p, size_t n) {
+    const uint8_t* pBytes = static_cast<const uint8_t*>(p);
+    vOut.insert(vOut.end(), pBytes, pBytes + n);
+  }
+
+  std::vector<Tile> vPalette;
+  std::vector<uint64_t> vData;
+  int32_t nBits = 0;
+  uint64_t nRevision = 0;
+};
+
+class World {
+ public:
+  // Supplies chunks that are not resident, e.g. from a snapshot or a
+  // generator. Return nullptr if the chunk is empty.
+  using ChunkSource =
+      std::function<std::unique_ptr<Chunk>(int32_t cx, int32_t cy)>;
+
+  void SetChunkSource(ChunkSource source) {
+    fnChunkSource = std::move(source);
+  }
+
+  // Fetches the chunk if needed, like GetChunk().
+  Tile GetTile(int32_t x, int32_t y) {
+    const Chunk* chunk = GetChunk(TileToChunk(x), TileToChunk(y));
+    return chunk ? chunk->Get(TileInChunk(x), TileInChunk(y))
+                 : Tile(Tile_Floor);
+  }
+
+  bool IsSolid(int32_t x, int32_t y) { return IsSolidTile(GetTile(x, y)); }
+
+  // Returns true if the tile actually changed.
+  bool SetTile(int32_t x, int32_t y, Tile tile) {
+    int32_t cx = TileToChunk(x), cy = TileToChunk(y);
+    Chunk* chunk = GetChunk(cx, cy);
+    if (!chunk) {
+      // Writing floor into an empty chunk changes nothing.
+      if (tile == Tile_Floor) return false;
+      chunk = &CreateChunk(cx, cy);
+    }
+    return chunk->Set(TileInChunk(x), TileInChunk(y), tile);
+  }
+
+  // Resident chunk, or one fetched from the chunk source; nullptr if empty.
+  // Fetching inserts the chunk, so only the thread that owns the world may
+  // call this. Everything const, FindResidentChunk() included, is safe to
+  // call from several threads while nothing writes.
+  Chunk* GetChunk(int32_t cx, int32_t cy) {
+    auto it = mapChunks.find(ChunkKey(cx, cy));
+    if (it != mapChunks.end()) return it->second.get();
+    if (!fnChunkSource) return nullptr;
+
+    std::unique_ptr<Chunk> chunk = fnChunkSource(cx, cy);
+    if (!chunk) return nullptr;
+    return mapChunks.emplace(ChunkKey(cx, cy), std::move(chunk))
+        .first->second.get();
+  }
+
+  // Only looks at resident chunks, never the chunk source.
+  const Chunk* FindResidentChunk(int32_t cx, int32_t cy) const {
+    auto it = mapChunks.find(ChunkKey(cx, cy));
+    return it != mapChunks.end() ? it->second.get() : nullptr;
+  }
+
+  Chunk& CreateChunk(int32_t cx, int32_t cy) {
+    auto& chunk = mapChunks[ChunkKey(cx, cy)];
+    if (!chunk) chunk = std::make_unique<Chunk>();
+    return *chunk;
+  }
+
+  void InsertChunk(int32_t cx, int32_t cy, std::unique_ptr<Chunk> chunk) {
+    mapChunks[ChunkKey(cx, cy)] = std::move(chunk);
+  }
+
+  void EraseChunk(int32_t cx, int32_t cy) {
+    mapChunks.erase(ChunkKey(cx, cy));
+  }
+
+  // Calls f(cx, cy, chunk) for every resident chunk.
+  template <typename F>
+  void ForEachResidentChunk(F&& f) const {
+    for (const auto& [nKey, chunk] : mapChunks)
+      f(int32_t(nKey >> 32), int32_t(uint32_t(nKey)), *chunk);
+  }
+
+  size_t ResidentChunkCount() const { return mapChunks.size(); }
+
+  size_t MemoryUsage() const {
+    size_t nBytes = sizeof(World) + mapChunks.bucket_count() * sizeof(void*);
+    for (const auto& [nKey, chunk] : mapChunks)
+      nBytes += sizeof(nKey) + sizeof(chunk) + chunk->MemoryUsage();
+    return nBytes;
+  }
+
+  // Load a hand authored map of '#' walls and '.' floor at (x, y).
+  void LoadFromString(const char* sMap, int32_t nWidth, int32_t nHeight,
+                      int32_t x = 0, int32_t y = 0) {
+    for (int32_t j = 0; j < nHeight; j++)
+      for (int32_t i = 0; i < nWidth; i++)
+        SetTile(x + i, y + j,
+                sMap[j * nWidth + i] == '#' ? Tile_Wall : Tile_Floor);
+  }
+
+ private:
+  std::unordered_map<uint64_t, std::unique_ptr<Chunk>> mapChunks;
+  ChunkSource fnChunkSource;
+};
@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "MMOJobs.h"
+#include "MMOWorld.h"
+
+// An AVX2 noise kernel is built for x86-64 with GCC or Clang unless
+// MMO_DISABLE_SIMD is defined, and used if the CPU has AVX2.
+#if !defined(MMO_DISABLE_SIMD) && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define MMO_WORLDGEN_AVX2
+#include <immintrin.h>
+#endif
+
+// Procedural world generation.
+//
+// A chunk is a pure function of the world seed and its coordinates, so any
+// chunk nobody has changed can be thrown away and generated again instead
+// of being stored. Nothing is shared between chunks: structures stay inside
+// the chunk that placed them.
+//
+// Terrain is value noise. The noise kernels work on a whole row of a chunk
+// at a time with integer lattice maths and no branches. The plain kernel is
+// left for the compiler to vectorize, which it only partly manages: the
+// four hashes per sample need 32-bit multiplies it will not use before
+// SSE4.1, the x86-64 baseline being SSE2. The AVX2 kernel does eight
+// samples per instruction. Both do the same float operations in the same
+// order with no fused multiply-adds, so they give the same bits. Lattice
+// spacings are powers of two, which keeps sample positions exact integers
+// and the output bit-identical on every run.
+
+class WorldGenerator {
+ public:
+  explicit WorldGenerator(uint64_t nSeed = 0) : nSeed(nSeed) {}
+
+  uint64_t Seed() const { return nSeed; }
+
+  static bool HasSimd() {
+#if defined(MMO_WORLDGEN_AVX2)
+    static const bool bAVX2 = __builtin_cpu_supports("avx2");
+    return bAVX2;
+#else
+    return false;
+#endif
+  }
+
+  // Safe to call from any number of threads at once.
+  std::unique_ptr<Chunk> Generate(int32_t cx, int32_t cy) const {
+    alignas(32) Tile vTiles[nChunkArea];
+    alignas(32) float vDensity[nChunkSize];
+    alignas(32) float vTunnel[nChunkSize];
+
+    uint32_t nDensitySalt = Salt(1), nTunnelSalt = Salt(2);
+    int32_t x0 = cx * nChunkSize;
+    for (int32_t ly = 0; ly < nChunkSize; ly++) {
+      int32_t y = cy * nChunkSize + ly;
+      FractalRow(x0, y, nDensitySalt, vDensity, bSimd);
+      FractalRow(x0, y, nTunnelSalt, vTunnel, bSimd);
+
+      // Rock where the density is high, but long winding tunnels are
+      // carved wherever the second field crosses zero, which keeps the
+      // caves connected.
+      Tile* pRow = vTiles + ly * nChunkSize;
+      for (int32_t i = 0; i < nChunkSize; i++) {
+        float fTunnel = vTunnel[i] < 0.0f ? -vTunnel[i] : vTunnel[i];
+        bool bRock = vDensity[i] > fRockThreshold && fTunnel > fTunnelWidth;
+        pRow[i] = bRock ? Tile_Wall : Tile_Floor;
+      }
+    }
+
+    PlaceStructures(cx, cy, vTiles);
+    PlaceLamps(cx, cy, vTiles);
+
+    auto chunk = std::make_unique<Chunk>();
+    chunk->Assign(vTiles);
+    return chunk;
+  }
+
+  // Generate a batch of chunks spread over the job system. Results come
+  // back in the order asked for.
+  std::vector<std::unique_ptr<Chunk>> GenerateMany(
+      const std::vector<std::pair<int32_t, int32_t>>& vCoords,
+      JobSystem& jobs) const {
+    std::vector<std::unique_ptr<Chunk>> vChunks(vCoords.size());
+    jobs.ParallelFor(0, vCoords.size(), 4, [&](size_t nBegin, size_t nEnd) {
+      for (size_t i = nBegin; i < nEnd; i++)
+        vChunks[i] = Generate(vCoords[i].first, vCoords[i].second);
+    });
+    return vChunks;
+  }
+
+  float fRockThreshold = -0.05f;
+  float fTunnelWidth = 0.045f;
+  // Out of 256, the chance a chunk contains a ruined room.
+  uint32_t nStructureChance = 64;
+  // Lamps tried per chunk; only those that land on open floor are placed.
+  uint32_t nLampAttempts = 2;
+  // Use the AVX2 noise kernel. Chunks come out the same either way.
+  bool bSimd = HasSimd();
+
+ private:
+  // Integer hash of a lattice point, the only source of randomness.
+  static uint32_t Hash(int32_t x, int32_t y, uint32_t nSalt) {
+    uint32_t h = uint32_t(x) * 0x8da6b343u ^ uint32_t(y) * 0xd8163841u ^ nSalt;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return h;
+  }
+
+  uint32_t Salt(uint32_t nLayer) const {
+    return Hash(int32_t(nSeed), int32_t(nSeed >> 32), nLayer);
+  }
+
+  // Value noise in [-1, 1] for the nChunkSize tiles starting at (x0, y),
+  // with lattice points every 2^nShift tiles.
+  static void ValueNoiseRow(int32_t x0, int32_t y, int32_t nShift,
+                            uint32_t nSalt, float* pOut) {
+    const int32_t nMask = (1 << nShift) - 1;
+    const float fScale = 1.0f / float(1 << nShift);
+
+    int32_t iy = y >> nShift;
+    float fy = float(y & nMask) * fScale;
+    fy = fy * fy * (3.0f - 2.0f * fy);
+
+    for (int32_t i = 0; i < nChunkSize; i++) {
+      int32_t x = x0 + i;
+      int32_t ix = x >> nShift;
+      float fx = float(x & nMask) * fScale;
+      fx = fx * fx * (3.0f - 2.0f * fx);
+
+      float v00 = float(Hash(ix, iy, nSalt) >> 8);
+      float v10 = float(Hash(ix + 1, iy, nSalt) >> 8);
+      float v01 = float(Hash(ix, iy + 1, nSalt) >> 8);
+      float v11 = float(Hash(ix + 1, iy + 1, nSalt) >> 8);
+
+      float a = v00 + (v10 - v00) * fx;
+      float b = v01 + (v11 - v01) * fx;
+      pOut[i] = (a + (b - a) * fy) * (2.0f / 16777215.0f) - 1.0f;
+    }
+  }
+
+#if defined(MMO_WORLDGEN_AVX2)
+  static __attribute__((target("avx2"))) __m256i Hash8(__m256i x, int32_t y,
+                                                       uint32_t nSalt) {
+    __m256i h = _mm256_xor_si256(
+        _mm256_mullo_epi32(x, _mm256_set1_epi32(int32_t(0x8da6b343u))),
+        _mm256_set1_epi32(int32_t(uint32_t(y) * 0xd8163841u ^ nSalt)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(int32_t(0x2c1b3c6du)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(int32_t(0x297a2d39u)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    return h;
+  }
+
+  // Lattice values as floats. Hashes are 24 bits after the shift, so the
+  // conversion is exact.
+  static __attribute__((target("avx2"))) __m256 Value8(__m256i x, int32_t y,
+                                                       uint32_t nSalt) {
+    return _mm256_cvtepi32_ps(_mm256_srli_epi32(Hash8(x, y, nSalt), 8));
+  }
+
+  // ValueNoiseRow eight samples at a time.
+  static __attribute__((target("avx2"))) void ValueNoiseRowAVX2(
+      int32_t x0, int32_t y, int32_t nShift, uint32_t nSalt, float* pOut) {
+    const int32_t nMask = (1 << nShift) - 1;
+    const float fScale = 1.0f / float(1 << nShift);
+
+    int32_t iy = y >> nShift;
+    float fy = float(y & nMask) * fScale;
+    fy = fy * fy * (3.0f - 2.0f * fy);
+
+    const __m128i vShift = _mm_cvtsi32_si128(nShift);
+    const __m256i vMask = _mm256_set1_epi32(nMask);
+    const __m256i vOne = _mm256_set1_epi32(1);
+    const __m256 vScale = _mm256_set1_ps(fScale);
+    const __m256 vTwo = _mm256_set1_ps(2.0f), vThree = _mm256_set1_ps(3.0f);
+    const __m256 vFy = _mm256_set1_ps(fy);
+    const __m256 vRange = _mm256_set1_ps(2.0f / 16777215.0f);
+    for (int32_t i = 0; i < nChunkSize; i += 8) {
+      __m256i x = _mm256_add_epi32(_mm256_set1_epi32(x0 + i),
+                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+      __m256i ix = _mm256_sra_epi32(x, vShift);
+      __m256 fx = _mm256_mul_ps(
+          _mm256_cvtepi32_ps(_mm256_and_si256(x, vMask)), vScale);
+      fx = _mm256_mul_ps(_mm256_mul_ps(fx, fx),
+                         _mm256_sub_ps(vThree, _mm256_mul_ps(vTwo, fx)));
+
+      __m256i ix1 = _mm256_add_epi32(ix, vOne);
+      __m256 v00 = Value8(ix, iy, nSalt), v10 = Value8(ix1, iy, nSalt);
+      __m256 v01 = Value8(ix, iy + 1, nSalt);
+      __m256 v11 = Value8(ix1, iy + 1, nSalt);
+
+      __m256 a = _mm256_add_ps(v00, _mm256_mul_ps(_mm256_sub_ps(v10, v00), fx));
+      __m256 b = _mm256_add_ps(v01, _mm256_mul_ps(_mm256_sub_ps(v11, v01), fx));
+      __m256 v = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), vFy));
+      _mm256_storeu_ps(pOut + i, _mm256_sub_ps(_mm256_mul_ps(v, vRange),
+                                               _mm256_set1_ps(1.0f)));
+    }
+  }
+#endif
+
+  // Four octaves of value noise, from 32 tile features down to 4.
+  static void FractalRow(int32_t x0, int32_t y, uint32_t nSalt, float* pOut,
+                         bool bSimd) {
+    alignas(32) float vOctave[nChunkSize];
+    for (int32_t i = 0; i < nChunkSize; i++) pOut[i] = 0.0f;
+
+    float fAmplitude = 0.5333f;
+    for (int32_t nShift = 5; nShift >= 2; nShift--) {
+      uint32_t nOctaveSalt = nSalt + uint32_t(nShift);
+#if defined(MMO_WORLDGEN_AVX2)
+      if (bSimd)
+        ValueNoiseRowAVX2(x0, y, nShift, nOctaveSalt, vOctave);
+      else
+#endif
+        ValueNoiseRow(x0, y, nShift, nOctaveSalt, vOctave);
+      for (int32_t i = 0; i < nChunkSize; i++)
+        pOut[i] += vOctave[i] * fAmplitude;
+      fAmplitude *= 0.5f;
+    }
+  }
+
+  // Now and then a ruined room: a walled rectangle with its inside cleared,
+  // a doorway in each side and a lamp in the middle, kept clear of the chunk
+  // edge.
+  void PlaceStructures(int32_t cx, int32_t cy, Tile* pTiles) const {
+    uint32_t nRoll = Hash(cx, cy, Salt(3));
+    if ((nRoll & 0xFF) >= nStructureChance) return;
+
+    int32_t w = 8 + int32_t((nRoll >> 8) % 12);
+    int32_t h = 8 + int32_t((nRoll >> 12) % 12);
+    int32_t x0 = 1 + int32_t((nRoll >> 16) % uint32_t(nChunkSize - w - 1));
+    int32_t y0 = 1 + int32_t((nRoll >> 24) % uint32_t(nChunkSize - h - 1));
+
+    for (int32_t y = y0; y < y0 + h; y++)
+      for (int32_t x = x0; x < x0 + w; x++) {
+        bool bEdge = x == x0 || y == y0 || x == x0 + w - 1 || y == y0 + h - 1;
+        bool bDoor = (x == x0 + w / 2) || (y == y0 + h / 2);
+        pTiles[y * nChunkSize + x] =
+            bEdge && !bDoor ? Tile_Wall : Tile_Floor;
+      }
+    pTiles[(y0 + h / 2 - 1) * nChunkSize + x0 + w / 2 - 1] = Tile_Lamp;
+  }
+
+  void PlaceLamps(int32_t cx, int32_t cy, Tile* pTiles) const {
+    for (uint32_t n = 0; n < nLampAttempts; n++) {
+      uint32_t i = Hash(cx, cy, Salt(4) + n) % nChunkArea;
+      if (pTiles[i] == Tile_Floor) pTiles[i] = Tile_Lamp;
+    }
+  }
+
+  uint64_t nSeed;
+};
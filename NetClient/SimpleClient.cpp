@@ -21,16 +21,30 @@ enum class CustomMsgTypes : uint32_t {
 
 class CustomClient : public olc::net::client_interface<CustomMsgTypes> {
 public:
-  void PingServer() {
-    olc::net::message<CustomMsgTypes> msg;
-    msg.header.id = CustomMsgTypes::ServerPing;
+  CustomClient() {
+    // ServerPing messages are answered and timed inside the connection.
+    SetTimeSyncMessage(CustomMsgTypes::ServerPing);
+  }
 
-    // Sketchy way to time the time it takes for the message to round robin.
-    std::chrono::system_clock::time_point timeNow =
-        std::chrono::system_clock::now();
+  void PingServer() {
+    nPingSamples = GetClockSamples();
+    bPingPending = true;
+    SyncClock();
+  }
 
-    msg << timeNow;
+  // The reply is handled on the asio thread, so the estimate only includes
+  // it once the sample count has moved on.
+  void ReportPing() {
+    if (!bPingPending || GetClockSamples() == nPingSamples)
+      return;
+    bPingPending = false;
+    std::cout << "Ping: " << GetRTT() / 1000.0 << "ms (+/- "
+              << GetJitter() / 1000.0 << "ms)\n";
   }
+
+private:
+  uint64_t nPingSamples = 0;
+  bool bPingPending = false;
 };
 
 bool kbhit() {
@@ -66,19 +80,14 @@ int main(int argc, char *argv[]) {
     };
 
     if (c.isConnected()) {
+      c.ReportPing();
+
       if (!c.Incoming().empty()) {
         auto msg = c.Incoming().pop_front().msg;
 
         switch (msg.header.id) {
-        case CustomMsgTypes::ServerPing: {
-          std::chrono::system_clock::time_point timeNow =
-              std::chrono::system_clock::now();
-          std::chrono::system_clock::time_point timeThen;
-          msg >> timeThen;
-          std::cout << "Ping: "
-                    << std::chrono::duration<double>(timeNow - timeThen).count()
-                    << "\n";
-        }
+        default:
+          break;
         }
       }
     } else {
@@ -32,6 +32,9 @@ public:
       m_connection = std::make_unique<connection<T>>(
           connection<T>::owner::client, m_context,
           asio::ip::tcp::socket(m_context), m_qMessagesIn);
+      if (m_bTimeSync)
+        m_connection->SetTimeSyncMessage(m_timeSyncID, m_nTimeSyncInterval);
+      m_connection->SetReceivePolicy(m_pReceivePolicy);
 
       // Tell the connection object to connect ot server.
       m_connection->ConnectToServer(endpoints);
@@ -62,10 +65,74 @@ public:
     m_connection.release();
   }
 
-  bool isConnected() { return false; }
+  bool isConnected() {
+    if (m_connection)
+      return m_connection->IsConnected();
+    else
+      return false;
+  }
+
+  // Send message to server
+  void Send(message<T> msg, priority lane = priority::normal) {
+    if (isConnected()) m_connection->Send(std::move(msg), lane);
+  }
 
   threadSafeQueue<owned_message<T>> &Incoming() { return m_qMessagesIn; }
 
+  // Nominate a message ID that carries the built in time sync protocol. Set
+  // before Connect(); the connection then keeps the clock estimate fresh by
+  // itself every nInterval.
+  void SetTimeSyncMessage(T msgID, std::chrono::milliseconds nInterval =
+                                       std::chrono::milliseconds(1000)) {
+    m_bTimeSync = true;
+    m_timeSyncID = msgID;
+    m_nTimeSyncInterval = nInterval;
+  }
+
+  // Largest body accepted from the server for a message ID, the connection
+  // is dropped if the server sends more. Set before Connect().
+  void SetMaxMessageSize(T msgID, size_t nBytes) {
+    m_pReceivePolicy->SetMaxMessageSize(msgID, nBytes);
+  }
+
+  void SetDefaultMaxMessageSize(size_t nBytes) {
+    m_pReceivePolicy->SetDefaultMaxMessageSize(nBytes);
+  }
+
+  // Stream the bodies of messages with this ID to sink as they arrive
+  // instead of queuing them whole. Set before Connect().
+  void SetStreamSink(T msgID, stream_sink<T> sink) {
+    m_pReceivePolicy->SetStreamSink(msgID, std::move(sink));
+  }
+
+  // Request an extra time sync round trip right now.
+  void SyncClock() {
+    if (isConnected()) m_connection->SendTimeSync();
+  }
+
+  bool IsClockSynced() const {
+    return m_connection && m_connection->IsClockSynced();
+  }
+
+  // Round trips measured so far, goes up as each time sync reply arrives
+  uint64_t GetClockSamples() const {
+    return m_connection ? m_connection->GetClockSamples() : 0;
+  }
+
+  // Smoothed round trip time to the server, in microseconds
+  int64_t GetRTT() const { return m_connection ? m_connection->GetRTT() : 0; }
+
+  // Smoothed round trip time deviation, in microseconds
+  int64_t GetJitter() const {
+    return m_connection ? m_connection->GetJitter() : 0;
+  }
+
+  // Our best estimate of the server's steady clock, in microseconds
+  int64_t GetServerTime() const {
+    int64_t nOffset = m_connection ? m_connection->GetClockOffset() : 0;
+    return SteadyMicroseconds() + nOffset;
+  }
+
 protected:
   asio::ip::tcp::endpoint m_endpoint;
   // Context handles the data transfer...
@@ -78,6 +145,13 @@ protected:
   // data transfer.
   std::unique_ptr<connection<T>> m_connection;
 
+  bool m_bTimeSync = false;
+  T m_timeSyncID{};
+  std::chrono::milliseconds m_nTimeSyncInterval{1000};
+
+  std::shared_ptr<receive_policy<T>> m_pReceivePolicy =
+      std::make_shared<receive_policy<T>>();
+
 private:
   // This is the thread safe queue of incoming messages from server.
   threadSafeQueue<owned_message<T>> m_qMessagesIn;
@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include "net_common.h"
+
+namespace olc {
+namespace net {
+
+// Monotonic clock used by the time sync protocol, in microseconds. Unlike
+// system_clock this never jumps when the wall clock is adjusted.
+inline int64_t SteadyMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Body of a time sync message. The client fills in nClientSend (t0) and
+// echoes the server timestamp of the previous reply along with how long it
+// held onto it, which lets the server measure the round trip too. The server
+// answers with nServerRecv (t1) and nServerSend (t2) filled in, and the
+// client stamps the arrival itself (t3).
+struct time_sync_packet {
+  int64_t nClientSend = 0;
+  int64_t nServerRecv = 0;
+  int64_t nServerSend = 0;
+  int64_t nEchoServerSend = 0;
+  int64_t nEchoHold = 0;
+};
+
+// Running estimate of round trip time, jitter and clock offset for one
+// connection. Samples are added from the asio thread, the estimates can be
+// read from anywhere.
+class clock_estimator {
+ public:
+  // Feed a round trip time and, if known, the offset of the remote clock
+  // relative to ours (remote - local), both in microseconds.
+  void AddSample(int64_t nRTT, int64_t nOffset = 0) {
+    if (nRTT < 0) nRTT = 0;
+
+    if (m_nSamples == 0) {
+      m_nRTT = nRTT;
+      m_nJitter = nRTT / 2;
+    } else {
+      // Same gains as TCP's SRTT/RTTVAR, 1/8 and 1/4.
+      m_nJitter += (std::abs(nRTT - m_nRTT) - m_nJitter) / 4;
+      m_nRTT += (nRTT - m_nRTT) / 8;
+    }
+
+    // Queuing delay only ever adds to a sample and makes its offset
+    // asymmetric, so like NTP we trust the offset from the fastest round trip
+    // in the recent window.
+    m_window[m_nSamples % m_window.size()] = {nRTT, nOffset};
+    m_nSamples++;
+
+    size_t nValid = std::min<size_t>(m_nSamples, m_window.size());
+    size_t nBest = 0;
+    for (size_t i = 1; i < nValid; i++)
+      if (m_window[i].nRTT < m_window[nBest].nRTT) nBest = i;
+
+    m_nPublishedRTT = m_nRTT;
+    m_nPublishedJitter = m_nJitter;
+    m_nPublishedOffset = m_window[nBest].nOffset;
+    m_nPublishedSamples = m_nSamples;
+  }
+
+  // Smoothed round trip time in microseconds
+  int64_t RTT() const { return m_nPublishedRTT; }
+
+  // Smoothed mean deviation of the round trip time in microseconds
+  int64_t Jitter() const { return m_nPublishedJitter; }
+
+  // Best estimate of (remote clock - local clock) in microseconds
+  int64_t Offset() const { return m_nPublishedOffset; }
+
+  // Number of samples seen so far, zero until the first round trip
+  uint64_t Samples() const { return m_nPublishedSamples; }
+
+ private:
+  struct sample {
+    int64_t nRTT = 0;
+    int64_t nOffset = 0;
+  };
+
+  // Owned by the thread adding samples
+  std::array<sample, 8> m_window;
+  uint64_t m_nSamples = 0;
+  int64_t m_nRTT = 0;
+  int64_t m_nJitter = 0;
+
+  // Published copies for other threads
+  std::atomic<int64_t> m_nPublishedRTT = 0;
+  std::atomic<int64_t> m_nPublishedJitter = 0;
+  std::atomic<int64_t> m_nPublishedOffset = 0;
+  std::atomic<uint64_t> m_nPublishedSamples = 0;
+};
+
+}  // namespace net
+}  // namespace olc
@@ -5,13 +5,18 @@
 
 #include <algorithm>
 #include <chrono>
+#include <array>
 #include <cstddef>
+#include <deque>
 #include <iterator>
 #include <memory>
 #include <system_error>
 
+#include "net_clock_sync.h"
 #include "net_common.h"
+#include "net_lane_scheduler.h"
 #include "net_message.h"
+#include "net_receive_policy.h"
 #include "net_server.h"
 #include "net_thread_safe_queue.h"
 
@@ -26,8 +31,8 @@ public:
   connection(owner parent, asio::io_context &asioContext,
              asio::ip::tcp::socket socket,
              threadSafeQueue<owned_message<T>> &qIn)
-      : m_asioContext(asioContext), m_socket(std::move(socket)),
-        m_qMessagesIn(qIn) {
+      : m_socket(std::move(socket)), m_asioContext(asioContext),
+        m_qMessagesIn(qIn), m_timerTimeSync(asioContext) {
     m_nOwnerType = parent;
 
     // Construct validation check data.
@@ -45,6 +50,39 @@ public:
 
   uint32_t GetID() const { return id; }
 
+  // Nominate a message ID that carries the built in time sync protocol.
+  // These messages are answered on the asio thread as soon as they arrive and
+  // never reach the incoming queue. Client connections also start pinging on
+  // their own every nInterval once validated.
+  void SetTimeSyncMessage(T msgID, std::chrono::milliseconds nInterval =
+                                       std::chrono::milliseconds(1000)) {
+    m_bTimeSync = true;
+    m_timeSyncID = msgID;
+    m_nTimeSyncInterval = nInterval;
+  }
+
+  // Size limits and stream sinks for incoming messages, shared with the
+  // owning client or server.
+  void SetReceivePolicy(std::shared_ptr<const receive_policy<T>> pPolicy) {
+    m_pReceivePolicy = std::move(pPolicy);
+  }
+
+  // Smoothed round trip time to the remote, in microseconds
+  int64_t GetRTT() const { return m_clock.RTT(); }
+
+  // Smoothed round trip time deviation, in microseconds
+  int64_t GetJitter() const { return m_clock.Jitter(); }
+
+  // Estimated (remote clock - local clock) in microseconds. Only clients
+  // learn this, the server is the reference clock.
+  int64_t GetClockOffset() const { return m_clock.Offset(); }
+
+  // True once at least one round trip has been measured
+  bool IsClockSynced() const { return m_clock.Samples() > 0; }
+
+  // Round trips measured so far
+  uint64_t GetClockSamples() const { return m_clock.Samples(); }
+
 public:
   void ConnectToServer(const asio::ip::tcp::resolver::results_type &endpoints) {
     // Only relevant to clients
@@ -53,6 +91,7 @@ public:
           m_socket, endpoints,
           [this](std::error_code ec, asio::ip::tcp::endpoint endpoint) {
             if (!ec) {
+              ConfigureSocket();
               readValidation();
             }
           });
@@ -70,6 +109,7 @@ public:
     if (m_nOwnerType == owner::server) {
       if (m_socket.is_open()) {
         id = uid;
+        ConfigureSocket();
 
         // A client attempted to connect to our server, but we wish
         // the client to first validate itself, so first we write out
@@ -84,29 +124,146 @@ public:
   }
 
 public:
-  bool Send(const message<T> &msg) {
-    asio::post(m_asioContext, [this, msg]() {
-      bool bWritingMessage = !m_qMessagesOut.empty();
-      m_qMessagesOut.push_back(msg);
-      if (!bWritingMessage) {
-        WriteHeader();
-      }
+  // Taken by value so large bodies can be moved all the way into the lane.
+  void Send(message<T> msg, priority lane = priority::normal) {
+    asio::post(m_asioContext, [this, msg = std::move(msg), lane]() mutable {
+      QueueMessage(std::move(msg), lane);
     });
   }
 
+  // Client only - send a time sync request right away.
+  void SendTimeSync() {
+    if (m_nOwnerType == owner::client && m_bTimeSync)
+      asio::post(m_asioContext, [this]() { WriteTimeSyncRequest(); });
+  }
+
 private:
-  // ASYNC - Prime context ready to read a message header.
+  void ConfigureSocket() {
+    // Small latency critical messages must not wait on Nagle for an ACK.
+    m_socket.set_option(asio::ip::tcp::no_delay(true));
+
+#ifdef TCP_NOTSENT_LOWAT
+    // Lane priorities only work if frames wait in our queues rather than in
+    // the kernel's send buffer, so keep the unsent backlog there small.
+    using notsent_lowat =
+        asio::detail::socket_option::integer<IPPROTO_TCP, TCP_NOTSENT_LOWAT>;
+    asio::error_code ec;
+    m_socket.set_option(notsent_lowat(4 * nMaxFrameBody), ec);
+#endif
+  }
+
+  // Must be called from the asio thread.
+  void QueueMessage(message<T> &&msg, priority lane) {
+    m_qMessagesOut[size_t(lane)].push_back(std::move(msg));
+    if (!m_bWritingFrame) {
+      WriteFrame();
+    }
+  }
+
+  // Returns the lane to send the next frame from, or nPriorityLanes when
+  // there is nothing left to send.
+  size_t PickLane() {
+    std::array<size_t, nPriorityLanes> nFrame{};
+    for (size_t i = 0; i < nPriorityLanes; i++)
+      if (!m_qMessagesOut[i].empty())
+        nFrame[i] = sizeof(message_header<T>) + NextFrameBody(i);
+    return m_laneScheduler.Pick(nFrame);
+  }
+
+  size_t NextFrameBody(size_t nLane) const {
+    size_t nRemaining =
+        m_qMessagesOut[nLane].front().body.size() - m_nLaneOffset[nLane];
+    return std::min<size_t>(nRemaining, nMaxFrameBody);
+  }
+
+  void WriteTimeSyncRequest() {
+    time_sync_packet packet;
+    if (m_nLastServerSend != 0) {
+      packet.nEchoServerSend = m_nLastServerSend;
+      packet.nEchoHold = SteadyMicroseconds() - m_nLastReplyArrival;
+    }
+
+    message<T> msg;
+    msg.header.id = m_timeSyncID;
+    // Stamp as late as possible so local queuing does not count as latency.
+    packet.nClientSend = SteadyMicroseconds();
+    msg << packet;
+    QueueMessage(std::move(msg), priority::high);
+  }
+
+  // ASYNC - Periodically ping the server, quickly at first so the estimate
+  // converges, then at the configured interval.
+  void ScheduleTimeSync() {
+    auto nDelay = m_clock.Samples() < 4 ? std::chrono::milliseconds(100)
+                                        : m_nTimeSyncInterval;
+    m_timerTimeSync.expires_after(nDelay);
+    m_timerTimeSync.async_wait([this](std::error_code ec) {
+      if (!ec && m_socket.is_open()) {
+        WriteTimeSyncRequest();
+        ScheduleTimeSync();
+      }
+    });
+  }
+
+  void HandleTimeSync(int64_t nArrival) {
+    if (m_msgTemporaryIn.body.size() != sizeof(time_sync_packet)) return;
+
+    time_sync_packet packet;
+    m_msgTemporaryIn >> packet;
+
+    if (m_nOwnerType == owner::server) {
+      // The client echoed our previous reply, which closes a round trip as
+      // seen from this side.
+      if (packet.nEchoServerSend != 0)
+        m_clock.AddSample(nArrival - packet.nEchoServerSend - packet.nEchoHold);
+
+      message<T> reply;
+      reply.header.id = m_timeSyncID;
+      packet.nServerRecv = nArrival;
+      packet.nServerSend = SteadyMicroseconds();
+      reply << packet;
+      QueueMessage(std::move(reply), priority::high);
+    } else {
+      // Classic NTP four timestamp exchange.
+      int64_t nRTT = (nArrival - packet.nClientSend) -
+                     (packet.nServerSend - packet.nServerRecv);
+      int64_t nOffset = ((packet.nServerRecv - packet.nClientSend) +
+                         (packet.nServerSend - nArrival)) /
+                        2;
+      m_clock.AddSample(nRTT, nOffset);
+
+      m_nLastServerSend = packet.nServerSend;
+      m_nLastReplyArrival = nArrival;
+    }
+  }
+
+  // ASYNC - Prime context ready to read a frame header.
   void ReadHeader() {
     asio::async_read(
-        m_socket,
-        asio::buffer(&m_msgTemporaryIn.header, sizeof(message_header<T>)),
+        m_socket, asio::buffer(&m_frameIn, sizeof(message_header<T>)),
         [this](std::error_code ec, std::size_t length) {
           if (!ec) {
-            if (m_msgTemporaryIn.header.size > 0) {
-              m_msgTemporaryIn.body.resize(m_msgTemporaryIn.header.size);
-              ReadBody();
+            if (!AcceptFrame()) {
+              m_socket.close();
+              return;
+            }
+
+            if (m_pReceivePolicy->StreamSink(m_frameIn.id)) {
+              ReadStreamBody();
+              return;
+            }
+
+            // Frames of one message arrive in order on their lane, so each
+            // lane reassembles at most one message at a time.
+            message<T> &msg = m_msgPartialIn[m_frameIn.lane];
+            size_t nOffset = msg.body.size();
+            if (nOffset == 0) msg.header = m_frameIn;
+
+            if (m_frameIn.size > 0) {
+              msg.body.resize(nOffset + m_frameIn.size);
+              ReadBody(nOffset);
             } else {
-              AddToIncomingMessageQueue();
+              FrameComplete();
             }
           } else {
             std::cout << "[" << id << "] Read header Fail.\n";
@@ -115,14 +272,44 @@ private:
         });
   }
 
-  // ASYNC - Prime context ready to read a message body.
-  void ReadBody() {
+  // Never trust the sizes a remote sends us. A frame is bounded by
+  // nMaxFrameBody and a whole message, however it is framed, by the limit for
+  // its ID, so nothing is allocated before it is known to be acceptable.
+  bool AcceptFrame() {
+    if (m_frameIn.lane >= nPriorityLanes || m_frameIn.size > nMaxFrameBody) {
+      std::cout << "[" << id << "] Malformed frame.\n";
+      return false;
+    }
+
+    size_t nLane = m_frameIn.lane;
+    if (m_bLaneInProgress[nLane] && m_laneIDIn[nLane] != m_frameIn.id) {
+      std::cout << "[" << id << "] Interleaved frame on lane.\n";
+      return false;
+    }
+
+    size_t nTotal = m_nLaneReceived[nLane] + m_frameIn.size;
+    if (nTotal > m_pReceivePolicy->MaxMessageSize(m_frameIn.id)) {
+      std::cout << "[" << id << "] Message too large (" << nTotal
+                << " bytes).\n";
+      return false;
+    }
+
+    bool bLast = !(m_frameIn.flags & nFrameMore);
+    m_bLaneInProgress[nLane] = !bLast;
+    m_laneIDIn[nLane] = m_frameIn.id;
+    m_nLaneReceived[nLane] = bLast ? 0 : nTotal;
+    return true;
+  }
+
+  // ASYNC - Prime context ready to read a frame body, straight into the tail
+  // of the message being reassembled.
+  void ReadBody(size_t nOffset) {
+    message<T> &msg = m_msgPartialIn[m_frameIn.lane];
     asio::async_read(m_socket,
-                     asio::buffer(m_msgTemporaryIn.body.data(),
-                                  m_msgTemporaryIn.body.size()),
+                     asio::buffer(msg.body.data() + nOffset, m_frameIn.size),
                      [this](std::error_code ec, std::size_t length) {
                        if (!ec) {
-                         AddToIncomingMessageQueue();
+                         FrameComplete();
                        } else {
                          std::cout << "[" << id << "] Read Body Fail.\n";
                          m_socket.close();
@@ -130,49 +317,110 @@ private:
                      });
   }
 
-  void AddToIncomingMessageQueue() {
+  void FrameComplete() {
+    if (m_frameIn.flags & nFrameMore) {
+      ReadHeader();
+      return;
+    }
+
+    m_msgTemporaryIn = std::move(m_msgPartialIn[m_frameIn.lane]);
+    m_msgPartialIn[m_frameIn.lane] = message<T>();
+    m_msgTemporaryIn.header.size = uint32_t(m_msgTemporaryIn.body.size());
+    m_msgTemporaryIn.header.lane = 0;
+    m_msgTemporaryIn.header.flags = 0;
+    AddToIncomingMessageQueue();
+  }
+
+  // ASYNC - Read a frame of a streamed message into the one frame sized
+  // buffer this connection owns, and pass it straight on to the sink.
+  void ReadStreamBody() {
+    if (m_frameIn.size == 0) {
+      StreamFrameComplete();
+      return;
+    }
+
+    if (m_vStreamBuffer.empty()) m_vStreamBuffer.resize(nMaxFrameBody);
+    asio::async_read(m_socket,
+                     asio::buffer(m_vStreamBuffer.data(), m_frameIn.size),
+                     [this](std::error_code ec, std::size_t length) {
+                       if (!ec) {
+                         StreamFrameComplete();
+                       } else {
+                         std::cout << "[" << id << "] Read Stream Fail.\n";
+                         m_socket.close();
+                       }
+                     });
+  }
+
+  void StreamFrameComplete() {
+    size_t nLane = m_frameIn.lane;
+
+    stream_chunk<T> chunk;
+    chunk.id = m_frameIn.id;
+    chunk.data = m_vStreamBuffer.data();
+    chunk.size = m_frameIn.size;
+    chunk.bLast = !(m_frameIn.flags & nFrameMore);
+    chunk.offset = m_nStreamOffset[nLane];
+    m_nStreamOffset[nLane] = chunk.bLast ? 0 : chunk.offset + chunk.size;
+
+    const stream_sink<T> *sink = m_pReceivePolicy->StreamSink(chunk.id);
     if (m_nOwnerType == owner::server)
-      m_qMessagesIn.push_back({this->shared_from_this(), m_msgTemporaryIn});
+      (*sink)(this->shared_from_this(), chunk);
     else
-      m_qMessagesIn.push_back({nullptr, m_msgTemporaryIn});
+      (*sink)(nullptr, chunk);
 
     ReadHeader();
   }
 
-  void WriteHeader() {
-    asio::async_write(
-        m_socket,
-        asio::buffer(&m_qMessagesOut.front().header, sizeof(message_header<T>)),
-        [this](std::error_code ec, std::size_t length) {
-          if (!ec) {
-            if (m_qMessagesOut.front().body.size() > 0) {
-              WriteBody();
-            } else {
-              m_qMessagesOut.pop_front();
+  void AddToIncomingMessageQueue() {
+    if (m_bTimeSync && m_msgTemporaryIn.header.id == m_timeSyncID)
+      HandleTimeSync(SteadyMicroseconds());
+    else if (m_nOwnerType == owner::server)
+      m_qMessagesIn.push_back(
+          {this->shared_from_this(), std::move(m_msgTemporaryIn)});
+    else
+      m_qMessagesIn.push_back({nullptr, std::move(m_msgTemporaryIn)});
 
-              if (!m_qMessagesOut.empty()) {
-                WriteHeader();
-              }
-            }
-          } else {
-            std::cout << "[" << id << "] Write header fail.\n";
-            m_socket.close();
-          }
-        });
+    ReadHeader();
   }
 
-  void WriteBody() {
-    asio::async_write(m_socket,
-                      asio::buffer(m_qMessagesOut.front().body.data(),
-                                   m_qMessagesOut.front().body.size()),
-                      [this](std::error_code ec, std::size_t length) {
+  // ASYNC - Write the next frame chosen by the lane scheduler, header and
+  // body slice in a single gathered write.
+  void WriteFrame() {
+    size_t nLane = PickLane();
+    if (nLane == nPriorityLanes) {
+      m_bWritingFrame = false;
+      return;
+    }
+    m_bWritingFrame = true;
+
+    const message<T> &msg = m_qMessagesOut[nLane].front();
+    size_t nBody = NextFrameBody(nLane);
+    bool bLast = m_nLaneOffset[nLane] + nBody >= msg.body.size();
+
+    m_frameOut = msg.header;
+    m_frameOut.size = uint32_t(nBody);
+    m_frameOut.lane = uint8_t(nLane);
+    m_frameOut.flags = bLast ? 0 : nFrameMore;
+
+    std::array<asio::const_buffer, 2> buffers = {
+        asio::buffer(&m_frameOut, sizeof(message_header<T>)),
+        asio::buffer(msg.body.data() + m_nLaneOffset[nLane], nBody)};
+
+    asio::async_write(m_socket, buffers,
+                      [this, nLane, nBody, bLast](std::error_code ec,
+                                                  std::size_t length) {
                         if (!ec) {
-                          m_qMessagesOut.pop_front();
-                          if (!m_qMessagesOut.empty()) {
-                            WriteHeader();
+                          if (bLast) {
+                            m_qMessagesOut[nLane].pop_front();
+                            m_nLaneOffset[nLane] = 0;
+                          } else {
+                            m_nLaneOffset[nLane] += nBody;
                           }
+                          WriteFrame();
                         } else {
-                          std::cout << "[" << id << "] Write body fail.\n";
+                          std::cout << "[" << id << "] Write frame fail.\n";
+                          m_bWritingFrame = false;
                           m_socket.close();
                         }
                       });
@@ -190,6 +438,7 @@ private:
                         if (!ec) {
                           if (m_nOwnerType == client) {
                             ReadHeader();
+                            if (m_bTimeSync) ScheduleTimeSync();
                           }
                         } else {
                           m_socket.close();
@@ -200,7 +449,7 @@ private:
   void readValidation(olc::net::server_interface<T> *server = nullptr) {
     asio::async_read(
         m_socket,
-        asio::buffer(&m_handshakeIn, sizeof(uint64_t),
+        asio::buffer(&m_handshakeIn, sizeof(uint64_t)),
                      [this, server](std::error_code ec, std::size_t length) {
                        if (!ec) {
                          if (m_nOwnerType == owner::server) {
@@ -225,7 +474,7 @@ private:
                          std::cout << "Client disconnected (ReadValidation)\n";
                          m_socket.close();
                        }
-                     }));
+                     });
   }
 
 protected:
@@ -235,9 +484,15 @@ protected:
   // This context is shared with the whole asio instance
   asio::io_context &m_asioContext;
 
-  // This queue holds all messages to be sent to the remote side of this
-  // connection
-  threadSafeQueue<message<T>> m_qMessagesOut;
+  // These queues hold all messages to be sent to the remote side of this
+  // connection, one per priority lane. They are only ever touched from the
+  // asio thread.
+  std::array<std::deque<message<T>>, nPriorityLanes> m_qMessagesOut;
+  std::array<size_t, nPriorityLanes> m_nLaneOffset{};
+  lane_scheduler<nPriorityLanes> m_laneScheduler{
+      {8 * nMaxFrameBody, 4 * nMaxFrameBody, 1 * nMaxFrameBody}};
+  bool m_bWritingFrame = false;
+  message_header<T> m_frameOut;
 
   // This queue holds all messages that have been received from the remote side
   // of this connection. Note it is a reference as the "owner" of this
@@ -245,6 +500,18 @@ protected:
   threadSafeQueue<owned_message<T>> &m_qMessagesIn;
   message<T> m_msgTemporaryIn;
 
+  // Incoming frames are reassembled per lane, or streamed out through a
+  // single frame sized buffer when the policy has a sink for the ID.
+  message_header<T> m_frameIn;
+  std::array<message<T>, nPriorityLanes> m_msgPartialIn;
+  std::array<bool, nPriorityLanes> m_bLaneInProgress{};
+  std::array<T, nPriorityLanes> m_laneIDIn{};
+  std::array<size_t, nPriorityLanes> m_nLaneReceived{};
+  std::array<size_t, nPriorityLanes> m_nStreamOffset{};
+  std::vector<uint8_t> m_vStreamBuffer;
+  std::shared_ptr<const receive_policy<T>> m_pReceivePolicy =
+      std::make_shared<receive_policy<T>>();
+
   // The owner decides how some of the connection behaves.
   owner m_nOwnerType = owner::server;
   uint32_t id = 0;
@@ -253,6 +520,15 @@ protected:
   uint64_t m_handshakeOut = 0;
   uint64_t m_handshakeIn = 0;
   uint64_t m_handshakeCheck = 0;
+
+  // Time sync
+  bool m_bTimeSync = false;
+  T m_timeSyncID{};
+  std::chrono::milliseconds m_nTimeSyncInterval{1000};
+  asio::steady_timer m_timerTimeSync;
+  clock_estimator m_clock;
+  int64_t m_nLastServerSend = 0;
+  int64_t m_nLastReplyArrival = 0;
 };
 } // namespace net
 } // namespace olc
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace olc {
+namespace net {
+
+// Deficit round robin over the outgoing lanes of a connection. Each visit to
+// a lane adds its quantum to the lane's credit once, and the lane may send
+// frames while that credit covers the frame at its head. Then the cursor
+// moves on and the remainder carries over to the lane's next visit, so a
+// backlogged lane gives up the wire after one quantum and no lane waits
+// longer than one round. A lane that runs empty loses its credit.
+template <size_t nLanes> class lane_scheduler {
+ public:
+  explicit lane_scheduler(const std::array<int64_t, nLanes> &nQuantum)
+      : m_nQuantum(nQuantum) {}
+
+  // nFrame holds the size of the frame at the head of each lane, or 0 if
+  // the lane is empty. Returns the lane to send from, and charges it for the
+  // frame, or nLanes when there is nothing left to send.
+  size_t Pick(const std::array<size_t, nLanes> &nFrame) {
+    bool bAnyQueued = false;
+    for (size_t i = 0; i < nLanes; i++) {
+      if (nFrame[i] == 0) {
+        m_nDeficit[i] = 0;
+        if (i == m_nCursor) m_bVisited = false;
+      } else {
+        bAnyQueued = true;
+      }
+    }
+    if (!bAnyQueued) return nLanes;
+
+    // Credit only grows, so every queued lane is served within a few rounds.
+    while (true) {
+      size_t nLane = m_nCursor;
+      if (nFrame[nLane] != 0) {
+        if (!m_bVisited) {
+          m_nDeficit[nLane] += m_nQuantum[nLane];
+          m_bVisited = true;
+        }
+        if (m_nDeficit[nLane] >= int64_t(nFrame[nLane])) {
+          m_nDeficit[nLane] -= int64_t(nFrame[nLane]);
+          return nLane;
+        }
+      }
+      m_nCursor = (m_nCursor + 1) % nLanes;
+      m_bVisited = false;
+    }
+  }
+
+ private:
+  std::array<int64_t, nLanes> m_nQuantum;
+  std::array<int64_t, nLanes> m_nDeficit{};
+  size_t m_nCursor = 0;
+  // Whether the lane under the cursor has had its quantum for this visit
+  bool m_bVisited = false;
+};
+
+}  // namespace net
+}  // namespace olc
@@ -13,11 +13,29 @@ namespace olc {
 
 namespace net {
 
+// Outgoing messages are queued into one of these lanes on each connection.
+// Lanes are served by deficit round robin, so a bulk transfer can not hold
+// back pings or player updates for longer than one round of the lanes.
+enum class priority : uint8_t { high = 0, normal = 1, bulk = 2 };
+constexpr size_t nPriorityLanes = 3;
+
+// Bodies larger than this are split into several frames on the wire, which
+// frames from other lanes may interleave with.
+constexpr uint32_t nMaxFrameBody = 16 * 1024;
+
+// Set on every frame of a message except the last one.
+constexpr uint8_t nFrameMore = 0x01;
+
 // Message Header is sent at start of all messages. The templates allows us to
 // use "enum class to ensure that the messages are valid at compile time.
+// On the wire it heads each frame, in which case size is the size of that
+// frame's slice of the body.
 template <typename T> struct message_header {
   T id{};
-  uint32_t size;
+  uint32_t size = 0;
+  uint8_t lane = 0;
+  uint8_t flags = 0;
+  uint16_t reserved = 0;
 };
 
 template <typename T> struct message {
@@ -51,7 +69,7 @@ template <typename T> struct message {
     std::memcpy(msg.body.data() + i, &data, sizeof(DataType));
 
     // Recalculate the message size
-    msg.header.size = msg.size();
+    msg.header.size = uint32_t(msg.body.size());
 
     // Return the target message so it can be chained
     return msg;
@@ -66,6 +84,18 @@ template <typename T> struct message {
     // Cache the location towards the end of the vector where the pulled data
     // starts.
     size_t i = msg.body.size() - sizeof(DataType);
+
+    // Physically copy the data from the vector into the user variable.
+    std::memcpy(&data, msg.body.data() + i, sizeof(DataType));
+
+    // Shrink the vector to remove read bytes, and reset end position.
+    msg.body.resize(i);
+
+    // Recalculate the message size
+    msg.header.size = uint32_t(msg.body.size());
+
+    // Return the target message so it can be chained
+    return msg;
   }
 };
 
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "net_common.h"
+#include "net_message.h"
+
+namespace olc {
+namespace net {
+
+// One slice of a streamed message body, handed to a stream_sink as soon as
+// its frame has arrived. offset is where this slice starts within the whole
+// body, and bLast marks the final slice.
+template <typename T> struct stream_chunk {
+  T id{};
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  size_t offset = 0;
+  bool bLast = false;
+};
+
+// Receives the body of a streamed message piece by piece. Called on the asio
+// thread, so it must not block; remote is nullptr on the client side. The
+// data pointer is only valid for the duration of the call.
+template <typename T>
+using stream_sink = std::function<void(std::shared_ptr<connection<T>> remote,
+                                       const stream_chunk<T> &chunk)>;
+
+// How a connection treats incoming bodies: the largest body it will accept
+// for each message ID, and which IDs are streamed to a sink rather than
+// assembled in memory. Set this up before connections are made, it is shared
+// by them read-only afterwards.
+template <typename T> class receive_policy {
+ public:
+  // Any message larger than its limit drops the connection.
+  void SetDefaultMaxMessageSize(size_t nBytes) { m_nDefaultMaxSize = nBytes; }
+
+  void SetMaxMessageSize(T msgID, size_t nBytes) {
+    m_mapMaxSize[msgID] = nBytes;
+  }
+
+  size_t MaxMessageSize(T msgID) const {
+    auto it = m_mapMaxSize.find(msgID);
+    return it != m_mapMaxSize.end() ? it->second : m_nDefaultMaxSize;
+  }
+
+  // Messages with this ID are never assembled, their frames go to the sink
+  // as they arrive, so peak memory is one frame no matter the body size.
+  void SetStreamSink(T msgID, stream_sink<T> sink) {
+    m_mapSinks[msgID] = std::move(sink);
+  }
+
+  const stream_sink<T> *StreamSink(T msgID) const {
+    auto it = m_mapSinks.find(msgID);
+    return it != m_mapSinks.end() ? &it->second : nullptr;
+  }
+
+ private:
+  size_t m_nDefaultMaxSize = 1024 * 1024;
+  std::unordered_map<T, size_t> m_mapMaxSize;
+  std::unordered_map<T, stream_sink<T>> m_mapSinks;
+};
+
+}  // namespace net
+}  // namespace olc
@@ -27,6 +27,29 @@ class server_interface {
 
   virtual ~server_interface() { Stop(); }
 
+  // Nominate a message ID that carries the built in time sync protocol. Set
+  // before Start(), it applies to every connection accepted afterwards.
+  void SetTimeSyncMessage(T msgID) {
+    m_bTimeSync = true;
+    m_timeSyncID = msgID;
+  }
+
+  // Largest body accepted from clients for a message ID, a client sending
+  // more is disconnected. Set before Start().
+  void SetMaxMessageSize(T msgID, size_t nBytes) {
+    m_pReceivePolicy->SetMaxMessageSize(msgID, nBytes);
+  }
+
+  void SetDefaultMaxMessageSize(size_t nBytes) {
+    m_pReceivePolicy->SetDefaultMaxMessageSize(nBytes);
+  }
+
+  // Stream the bodies of messages with this ID to sink as they arrive
+  // instead of queuing them whole. Set before Start().
+  void SetStreamSink(T msgID, stream_sink<T> sink) {
+    m_pReceivePolicy->SetStreamSink(msgID, std::move(sink));
+  }
+
   bool Start() {
     try {
       WaitForClientConnection();
@@ -59,6 +82,8 @@ class server_interface {
             std::make_shared<connection<T>>(connection<T>::owner::server,
                                             m_asioContext, std::move(socket),
                                             m_qMessagesIn);
+        if (m_bTimeSync) newConnection->SetTimeSyncMessage(m_timeSyncID);
+        newConnection->SetReceivePolicy(m_pReceivePolicy);
 
         // Give the user server a chance to deny connection
         if (OnClientConnect(newConnection)) {
@@ -81,27 +106,28 @@ class server_interface {
   }
 
   // Send a message to a specific client
-  void MessageClient(std::shared_ptr<connection<T>> client,
-                     const message<T> &msg) {
+  void MessageClient(std::shared_ptr<connection<T>> client, message<T> msg,
+                     priority lane = priority::normal) {
     if (client && client->IsConnected()) {
-      client->Send();
+      client->Send(std::move(msg), lane);
     } else {
       OnClientDisconnect(client);
-      client.reset();
       m_deqConnections.erase(std::remove(m_deqConnections.begin(),
-                                         m_deqConnections.end(), client));
+                                         m_deqConnections.end(), client),
+                             m_deqConnections.end());
     }
   }
 
   void MessageAllClients(
       const message<T> &msg,
-      std::shared_ptr<connection<T>> pIgnoreClient = nullptr) {
+      std::shared_ptr<connection<T>> pIgnoreClient = nullptr,
+      priority lane = priority::normal) {
     bool bInvalidClientsExist = false;
 
     for (auto &client : m_deqConnections) {
       if (client && client->IsConnected()) {
         if (client != pIgnoreClient) {
-          client->Send();
+          client->Send(msg, lane);
         }
       } else {
         OnClientDisconnect(client);
@@ -116,6 +142,25 @@ class server_interface {
     }
   }
 
+  // Clients are otherwise only noticed to be gone when sending to them
+  // fails. Call this regularly if some clients may go a while without being
+  // sent anything.
+  void RemoveDisconnectedClients() {
+    bool bInvalidClientsExist = false;
+    for (auto &client : m_deqConnections) {
+      if (!client || !client->IsConnected()) {
+        OnClientDisconnect(client);
+        client.reset();
+        bInvalidClientsExist = true;
+      }
+    }
+    if (bInvalidClientsExist) {
+      m_deqConnections.erase(std::remove(m_deqConnections.begin(),
+                                         m_deqConnections.end(), nullptr),
+                             m_deqConnections.end());
+    }
+  }
+
   void Update(size_t nMaxMessages = -1, bool wait = false) {
     if (wait) m_qMessagesIn.wait();
 
@@ -159,6 +204,12 @@ class server_interface {
 
   // Clients will be identified in the "wider system" via an ID
   uint32_t nIDCounter = 10000;
+
+  bool m_bTimeSync = false;
+  T m_timeSyncID{};
+
+  std::shared_ptr<receive_policy<T>> m_pReceivePolicy =
+      std::make_shared<receive_policy<T>>();
 };
 }  // namespace net
 }  // namespace olc
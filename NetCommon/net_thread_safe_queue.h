@@ -31,7 +31,15 @@ class threadSafeQueue {
     std::scoped_lock lock(muxQueue);
     deqQueue.emplace_back(std::move(item));
     std::unique_lock<std::mutex> ul(muxBlocking);
-    cvBlocking.notify_one(ul);
+    cvBlocking.notify_one();
+  }
+
+  // Adds item to the back of the queue, taking ownership of its contents
+  void push_back(T &&item) {
+    std::scoped_lock lock(muxQueue);
+    deqQueue.emplace_back(std::move(item));
+    std::unique_lock<std::mutex> ul(muxBlocking);
+    cvBlocking.notify_one();
   }
 
   // Adds item to the front of the queue
@@ -39,7 +47,7 @@ class threadSafeQueue {
     std::scoped_lock lock(muxQueue);
     deqQueue.emplace_front(std::move(item));
     std::unique_lock<std::mutex> ul(muxBlocking);
-    cvBlocking.notify_one(ul);
+    cvBlocking.notify_one();
   }
 
   // Returns true if the queue is empty
@@ -14,7 +14,11 @@ enum class CustomMessageTypes : uint32_t {
 class CustomServer : public olc::net::server_interface<CustomMessageTypes> {
 public:
   CustomServer(uint16_t nPort)
-      : olc::net::server_interface<CustomMessageTypes>(nPort){};
+      : olc::net::server_interface<CustomMessageTypes>(nPort) {
+    // ServerPing messages are answered inside the connection, which also
+    // keeps a running RTT estimate for every client.
+    SetTimeSyncMessage(CustomMessageTypes::ServerPing);
+  };
 
 protected:
   virtual bool OnClientConnect(
@@ -29,9 +33,12 @@ protected:
   OnMessage(std::shared_ptr<olc::net::connection<CustomMessageTypes>> client,
             olc::net::message<CustomMessageTypes> msg) {
     switch (msg.header.id) {
-    case CustomMessageTypes::ServerPing:
-      std::cout << "[" << client->GetID() << "]: Server Ping\n";
-      client->Send(msg);
+    case CustomMessageTypes::MessageAll:
+      std::cout << "[" << client->GetID()
+                << "]: Message All (RTT " << client->GetRTT() << "us)\n";
+      break;
+    default:
+      break;
     }
   }
 };
@@ -0,0 +1,79 @@
+// Checks the deficit round robin that picks which lane of a connection sends
+// its next frame. A high lane message queued behind backlogged normal and
+// bulk lanes must go out within one round, and backlogged lanes must share
+// the wire by their quanta.
+
+#include "../NetCommon/net_lane_scheduler.h"
+
+#include <cstdio>
+
+using olc::net::lane_scheduler;
+
+static constexpr size_t nLanes = 3;
+static constexpr size_t nHigh = 0, nNormal = 1, nBulk = 2;
+static constexpr int64_t nMaxFrameBody = 16 * 1024;
+// A full frame on the wire, body slice and header
+static constexpr size_t nFullFrame = nMaxFrameBody + 12;
+static constexpr std::array<int64_t, nLanes> nQuantum = {
+    8 * nMaxFrameBody, 4 * nMaxFrameBody, 1 * nMaxFrameBody};
+
+// Queues a high lane ping after nWarmup frames of normal and bulk backlog,
+// and returns how many bytes went out before the ping did.
+static int64_t BytesBeforeHigh(int nWarmup) {
+  lane_scheduler<nLanes> scheduler(nQuantum);
+  std::array<size_t, nLanes> nFrame = {0, nFullFrame, nFullFrame};
+  for (int i = 0; i < nWarmup; i++) scheduler.Pick(nFrame);
+
+  nFrame[nHigh] = 64;
+  int64_t nBytes = 0;
+  for (int i = 0; i < 1000; i++) {
+    size_t nLane = scheduler.Pick(nFrame);
+    if (nLane == nHigh) return nBytes;
+    nBytes += int64_t(nFrame[nLane]);
+  }
+  return -1;
+}
+
+int main() {
+  int nFailed = 0;
+
+  // One round lets the normal and bulk lanes spend their quanta plus the
+  // remainders they carry, which are each less than a frame.
+  const int64_t nRound = nQuantum[nNormal] + nQuantum[nBulk] + 2 * nFullFrame;
+  for (int nWarmup = 0; nWarmup < 64; nWarmup++) {
+    int64_t nBytes = BytesBeforeHigh(nWarmup);
+    if (nBytes < 0 || nBytes > nRound) {
+      std::printf("high lane waited behind %lld bytes after %d frames, "
+                  "more than a round of %lld\n",
+                  (long long)nBytes, nWarmup, (long long)nRound);
+      nFailed++;
+    }
+  }
+
+  // Backlogged lanes share the wire in proportion to their quanta.
+  lane_scheduler<nLanes> scheduler(nQuantum);
+  std::array<size_t, nLanes> nFrame = {nFullFrame, nFullFrame, nFullFrame};
+  std::array<int64_t, nLanes> nSent{};
+  for (int i = 0; i < 13000; i++) {
+    size_t nLane = scheduler.Pick(nFrame);
+    nSent[nLane] += int64_t(nFrame[nLane]);
+  }
+  for (size_t i = 1; i < nLanes; i++) {
+    double fShare = double(nSent[0]) / double(nSent[i]);
+    double fExpected = double(nQuantum[0]) / double(nQuantum[i]);
+    if (fShare < fExpected * 0.95 || fShare > fExpected * 1.05) {
+      std::printf("lane 0 sent %.2fx lane %zu, expected %.2fx\n", fShare, i,
+                  fExpected);
+      nFailed++;
+    }
+  }
+
+  // Nothing queued, nothing to send
+  if (scheduler.Pick({0, 0, 0}) != nLanes) {
+    std::printf("picked a lane with nothing queued\n");
+    nFailed++;
+  }
+
+  if (nFailed == 0) std::printf("lanes are served within one round\n");
+  return nFailed;
+}
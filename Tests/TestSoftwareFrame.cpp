@@ -0,0 +1,111 @@
+// Pixel-exact checks of frames composited by the software renderer. Each
+// case draws a frame of decals and compares it, pixel for pixel, with the
+// same picture drawn on the CPU into a sprite.
+
+#define OLC_PGE_APPLICATION
+#define OLC_PGE_HEADLESS
+#define OLC_GFX_SOFTWARE
+#include "../include/olcPixelGameEngine.h"
+
+#include <cstdio>
+#include <functional>
+
+class FrameTest : public olc::PixelGameEngine {
+ public:
+  explicit FrameTest(std::function<void(FrameTest&)> fnDraw)
+      : fnDraw(std::move(fnDraw)) {}
+
+  bool OnUserCreate() override { return true; }
+
+  bool OnUserUpdate(float) override {
+    fnDraw(*this);
+    return false;
+  }
+
+ private:
+  std::function<void(FrameTest&)> fnDraw;
+};
+
+static constexpr int32_t nWidth = 64, nHeight = 48;
+
+static void Fill(olc::Sprite& spr, int32_t x0, int32_t y0, int32_t w,
+                 int32_t h, olc::Pixel p) {
+  for (int32_t y = y0; y < y0 + h; y++)
+    for (int32_t x = x0; x < x0 + w; x++) spr.SetPixel(x, y, p);
+}
+
+// Counts the pixels of the rendered frame that differ from the reference
+static int Compare(const char* sName, std::function<void(FrameTest&)> fnDraw,
+                   std::function<void(olc::Sprite&)> fnReference) {
+  FrameTest test(std::move(fnDraw));
+  if (!test.Construct(nWidth, nHeight, 1, 1)) {
+    std::printf("%s: could not construct the engine\n", sName);
+    return 1;
+  }
+  test.Start();
+
+  olc::Sprite sprExpected(nWidth, nHeight);
+  fnReference(sprExpected);
+
+  const olc::Sprite& sprFrame = test.GetSoftwareFrame();
+  if (sprFrame.width != nWidth || sprFrame.height != nHeight) {
+    std::printf("%s: frame is %dx%d\n", sName, sprFrame.width,
+                sprFrame.height);
+    return 1;
+  }
+  int nDiffs = 0;
+  for (int32_t y = 0; y < nHeight; y++)
+    for (int32_t x = 0; x < nWidth; x++) {
+      olc::Pixel p = sprFrame.GetPixel(x, y);
+      olc::Pixel q = sprExpected.GetPixel(x, y);
+      if (p == q) continue;
+      if (nDiffs++ < 8)
+        std::printf("%s: (%d, %d) is %08x, expected %08x\n", sName, x, y,
+                    p.n, q.n);
+    }
+  if (nDiffs > 0) std::printf("%s: %d pixels differ\n", sName, nDiffs);
+  return nDiffs > 0;
+}
+
+int main() {
+  int nFailed = 0;
+
+  // Overlapping rects are merged into one batch, which must keep their order
+  nFailed += Compare(
+      "merged rects",
+      [](FrameTest& pge) {
+        pge.Clear(olc::BLACK);
+        pge.FillRectDecal({4, 4}, {20, 12}, olc::RED);
+        pge.FillRectDecal({14, 8}, {20, 12}, olc::BLUE);
+        pge.FillRectDecal({8, 6}, {4, 4}, olc::GREEN);
+      },
+      [](olc::Sprite& spr) {
+        Fill(spr, 0, 0, nWidth, nHeight, olc::BLACK);
+        Fill(spr, 4, 4, 20, 12, olc::RED);
+        Fill(spr, 14, 8, 20, 12, olc::BLUE);
+        Fill(spr, 8, 6, 4, 4, olc::GREEN);
+      });
+
+  // A textured decal over the cleared screen, copied texel for texel
+  olc::Renderable gfx;
+  nFailed += Compare(
+      "sprite decal",
+      [&gfx](FrameTest& pge) {
+        gfx.Create(8, 8);
+        for (int32_t y = 0; y < 8; y++)
+          for (int32_t x = 0; x < 8; x++)
+            gfx.Sprite()->SetPixel(x, y, olc::Pixel(x * 32, y * 32, 128));
+        gfx.Decal()->Update();
+        pge.Clear(olc::DARK_GREY);
+        pge.DrawDecal({20, 10}, gfx.Decal());
+      },
+      [](olc::Sprite& spr) {
+        Fill(spr, 0, 0, nWidth, nHeight, olc::DARK_GREY);
+        for (int32_t y = 0; y < 8; y++)
+          for (int32_t x = 0; x < 8; x++)
+            spr.SetPixel(20 + x, 10 + y, olc::Pixel(x * 32, y * 32, 128));
+      });
+
+  if (nFailed == 0) std::printf("all frames match\n");
+  return nFailed;
+}
@@ -399,13 +399,16 @@ int main()
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <list>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <streambuf>
 #include <string>
@@ -455,13 +458,24 @@ namespace _gfs = std::filesystem;
 
 #define UNUSED(x) (void)(x)
 
+// SIMD span kernels are built for x86 unless OLC_DISABLE_SIMD is defined,
+// and chosen at runtime by what the CPU supports. Other targets use the
+// plain loops, which the compiler vectorizes as best it can.
+#if !defined(OLC_DISABLE_SIMD) &&                                   \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+     defined(_M_IX86))
+#define OLC_SIMD_X86
+#endif
+
 // O------------------------------------------------------------------------------O
 // | PLATFORM SELECTION CODE, Thanks slavka! |
 // O------------------------------------------------------------------------------O
 
 #if defined(OLC_PGE_HEADLESS)
 #define OLC_PLATFORM_HEADLESS
+#if !defined(OLC_GFX_SOFTWARE)
 #define OLC_GFX_HEADLESS
+#endif
 #if !defined(OLC_IMAGE_STB) && !defined(OLC_IMAGE_GDI) && \
     !defined(OLC_IMAGE_LIBPNG)
 #define OLC_IMAGE_HEADLESS
@@ -496,7 +510,8 @@ namespace _gfs = std::filesystem;
 
 // Renderer
 #if !defined(OLC_GFX_OPENGL10) && !defined(OLC_GFX_OPENGL33) && \
-    !defined(OLC_GFX_DIRECTX10) && !defined(OLC_GFX_HEADLESS)
+    !defined(OLC_GFX_DIRECTX10) && !defined(OLC_GFX_HEADLESS) &&  \
+    !defined(OLC_GFX_SOFTWARE)
 #if !defined(OLC_GFX_CUSTOM_EX)
 #if defined(OLC_PLATFORM_EMSCRIPTEN)
 #define OLC_GFX_OPENGL33
@@ -655,6 +670,83 @@ static const Pixel GREY(192, 192, 192), DARK_GREY(128, 128, 128),
     VERY_DARK_MAGENTA(64, 0, 64), WHITE(255, 255, 255), BLACK(0, 0, 0),
     BLANK(0, 0, 0, 0);
 #endif
+
+// O------------------------------------------------------------------------------O
+// | olc::simd - Span kernels for the software drawing routines |
+// O------------------------------------------------------------------------------O
+namespace simd {
+enum class Level { Scalar, SSE2, AVX2 };
+// Widest level this CPU can run
+Level Supported();
+// Level in use, Supported() unless narrowed by SetLevel()
+Level Active();
+// Use at most this level, e.g. to compare them
+void SetLevel(Level level);
+
+// Set n pixels to p
+void Fill(Pixel* pDst, size_t n, Pixel p);
+// Copy the n pixels of pSrc that are fully opaque to pDst
+void CopyMasked(Pixel* pDst, const Pixel* pSrc, size_t n);
+// Blend n pixels of pSrc over pDst by their alpha, scaled by
+// nWeight / 32768. Results are opaque.
+void Blend(Pixel* pDst, const Pixel* pSrc, size_t n, uint32_t nWeight = 32768);
+// Blend p over n pixels of pDst by p.a
+void BlendFill(Pixel* pDst, size_t n, Pixel p);
+// Sample n points bilinearly from an nWidth by nHeight image, starting at
+// (u, v) in normalised coordinates and stepping by (du, dv). Points beyond
+// the edges take the edge texels.
+void SampleBL(Pixel* pDst, size_t n, const Pixel* pTex, int32_t nWidth,
+              int32_t nHeight, float u, float v, float du, float dv);
+}  // namespace simd
+
+// O------------------------------------------------------------------------------O
+// | olc::profile - Frame profiler, compiled in by OLC_PGE_PROFILE |
+// O------------------------------------------------------------------------------O
+// The engine times each phase of a frame, and OLC_PROFILE_ZONE("name") times
+// the rest of the enclosing scope on any thread. Zone names are kept by
+// pointer, so must be string literals or otherwise outlive the profiler.
+// Without OLC_PGE_PROFILE the zones compile to nothing.
+#if defined(OLC_PGE_PROFILE)
+namespace profile {
+// A finished zone, times in nanoseconds since the profiler started
+struct Event {
+  const char* sName = nullptr;
+  uint64_t nStart = 0;
+  uint64_t nEnd = 0;
+  uint32_t nThread = 0;
+};
+
+uint64_t Now();
+// Small number naming the calling thread in events
+uint32_t ThreadID();
+// Adds a zone to the ring of recent events. Lock-free, any thread may call.
+void Record(const char* sName, uint64_t nStart, uint64_t nEnd);
+// Copies up to the nMax most recent events out of the ring, oldest first
+void ReadEvents(std::vector<Event>& vEvents, size_t nMax = SIZE_MAX);
+// Writes the events in the ring as a Chrome trace, for chrome://tracing or
+// Perfetto
+bool SaveChromeTrace(const std::string& sFile);
+
+class Zone {
+ public:
+  explicit Zone(const char* sName) : sName(sName), nStart(Now()) {}
+  ~Zone() { Record(sName, nStart, Now()); }
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+ private:
+  const char* sName;
+  uint64_t nStart;
+};
+}  // namespace profile
+
+#define OLC_PROFILE_CONCAT_(a, b) a##b
+#define OLC_PROFILE_CONCAT(a, b) OLC_PROFILE_CONCAT_(a, b)
+#define OLC_PROFILE_ZONE(name) \
+  olc::profile::Zone OLC_PROFILE_CONCAT(olc_profile_zone_, __LINE__)(name)
+#else
+#define OLC_PROFILE_ZONE(name) ((void)0)
+#endif
 // Thanks to scripticuk and others for updating the key maps
 // NOTE: The GLUT platform will need updating, open to contributions ;)
 enum Key {
@@ -977,6 +1069,12 @@ class ImageLoader {
                                        const std::string& sImageFile) = 0;
 };
 
+// A changed area of a sprite, from pos to pos + size
+struct DirtyRect {
+  olc::vi2d pos;
+  olc::vi2d size;
+};
+
 // O------------------------------------------------------------------------------O
 // | olc::Sprite - An image represented by a 2D array of olc::Pixel |
 // O------------------------------------------------------------------------------O
@@ -1017,6 +1115,22 @@ class Sprite {
   Mode modeSample = Mode::NORMAL;
 
   static std::unique_ptr<olc::ImageLoader> loader;
+
+ public:
+  // Areas changed since the sprite was last uploaded to its decal. The
+  // drawing routines mark what they touch; writes through GetData() need
+  // marking by hand.
+  void MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h);
+  void MarkDirty();
+  const std::vector<olc::DirtyRect>& GetDirtyRects() const;
+  void ClearDirty();
+
+ private:
+  // Beyond this many areas the closest ones are merged
+  static constexpr size_t nMaxDirtyRects = 8;
+  std::vector<olc::DirtyRect> vDirty;
+  // Where the last mark landed, checked first by the next
+  size_t nLastDirty = 0;
 };
 
 // O------------------------------------------------------------------------------O
@@ -1028,6 +1142,8 @@ class Decal {
   Decal(const uint32_t nExistingTextureResource, olc::Sprite* spr);
   virtual ~Decal();
   void Update();
+  // Uploads only the areas of the sprite marked dirty since the last upload
+  void UpdateDirty();
   void UpdateSprite();
 
  public:  // But dont touch
@@ -1047,6 +1163,13 @@ enum class DecalMode {
 
 enum class DecalStructure { LINE, FAN, STRIP, LIST };
 
+// A corner of a triangle drawn by FillTexturedTriangles()
+struct TexturedVertex {
+  olc::vf2d pos;
+  olc::vf2d uv;
+  olc::Pixel col = olc::WHITE;
+};
+
 // O------------------------------------------------------------------------------O
 // | olc::Renderable - Convenience class to keep a sprite and decal together |
 // O------------------------------------------------------------------------------O
@@ -1072,19 +1195,42 @@ class Renderable {
 // | Auxilliary components internal to engine |
 // O------------------------------------------------------------------------------O
 
-struct DecalInstance {
-  olc::Decal* decal = nullptr;
+// Vertices of all the decals drawn to a layer in a frame. Emptied, not
+// freed, once the layer is drawn, so decals stop allocating once it has grown.
+struct DecalArena {
   std::vector<olc::vf2d> pos;
   std::vector<olc::vf2d> uv;
   std::vector<float> w;
   std::vector<float> z;
   std::vector<olc::Pixel> tint;
+};
+
+struct DecalInstance {
+  olc::Decal* decal = nullptr;
+  // points vertices each. Decals in a layer point into its arena, from
+  // vertex onwards; the pointers are only refreshed before drawing, as the
+  // arena moves when it grows.
+  olc::vf2d* pos = nullptr;
+  olc::vf2d* uv = nullptr;
+  float* w = nullptr;
+  float* z = nullptr;
+  olc::Pixel* tint = nullptr;
   olc::DecalMode mode = olc::DecalMode::NORMAL;
   olc::DecalStructure structure = olc::DecalStructure::FAN;
   uint32_t points = 0;
+  uint32_t vertex = 0;
   bool depth = false;
 };
 
+// Decals queued in a frame, and the renderer calls that drew them
+struct DecalBatchStats {
+  uint32_t nDecals = 0;
+  uint32_t nDrawCalls = 0;
+};
+
+// Fills batches of triangles by screen tile, across threads
+class TriangleRasterizer;
+
 struct LayerDesc {
   olc::vf2d vOffset = {0, 0};
   olc::vf2d vScale = {1, 1};
@@ -1093,6 +1239,7 @@ struct LayerDesc {
   olc::Renderable pDrawTarget;
   uint32_t nResID = 0;
   std::vector<DecalInstance> vecDecalInstance;
+  DecalArena decalArena;
   olc::Pixel tint = olc::WHITE;
   std::function<void()> funcHook = nullptr;
 };
@@ -1110,16 +1257,42 @@ class Renderer {
   virtual void DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale,
                              const olc::Pixel tint) = 0;
   virtual void DrawDecal(const olc::DecalInstance& decal) = 0;
+  // Draws a triangle LIST merged from decals sharing a texture and mode.
+  // It may hold far more points than any single decal.
+  virtual void DrawDecalBatch(const olc::DecalInstance& batch) {
+    DrawDecal(batch);
+  }
   virtual uint32_t CreateTexture(const uint32_t width, const uint32_t height,
                                  const bool filtered = false,
                                  const bool clamp = true) = 0;
   virtual void UpdateTexture(uint32_t id, olc::Sprite* spr) = 0;
+  // Uploads one area of spr to the texture. Renderers without it return
+  // FAIL, and are sent the whole sprite instead.
+  virtual olc::rcode UpdateTextureRegion(uint32_t id, olc::Sprite* spr,
+                                         const olc::vi2d& pos,
+                                         const olc::vi2d& size) {
+    return olc::FAIL;
+  }
   virtual void ReadTexture(uint32_t id, olc::Sprite* spr) = 0;
   virtual uint32_t DeleteTexture(const uint32_t id) = 0;
   virtual void ApplyTexture(uint32_t id) = 0;
   virtual void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) = 0;
   virtual void ClearBuffer(olc::Pixel p, bool bDepth) = 0;
   static olc::PixelGameEngine* ptrPGE;
+
+ protected:
+  // Clips an area of spr to a texture of vTexture pixels before it is
+  // uploaded. Returns false if the sprite no longer matches the texture,
+  // which then needs the whole sprite sent by UpdateTexture instead.
+  static bool ClipTextureRegion(const olc::Sprite* spr,
+                                const olc::vi2d& vTexture, olc::vi2d& pos,
+                                olc::vi2d& size) {
+    if (spr->width != vTexture.x || spr->height != vTexture.y) return false;
+    olc::vi2d vEnd = (pos + size).min(vTexture);
+    pos = pos.max({0, 0});
+    size = (vEnd - pos).max({0, 0});
+    return true;
+  }
 };
 
 class Platform {
@@ -1223,6 +1396,16 @@ class PixelGameEngine {
   uint32_t GetFPS() const;
   // Gets last update of elapsed time
   float GetElapsedTime() const;
+  // Gets how many decals the last frame drew, in how many draw calls
+  const olc::DecalBatchStats& GetDecalBatchStats() const;
+#if defined(OLC_PGE_PROFILE)
+  // Shows the timed zones of the last frame over the screen
+  void SetProfilerOverlay(bool bShow);
+#endif
+#if defined(OLC_GFX_SOFTWARE)
+  // Gets the last frame composited by the software renderer
+  const olc::Sprite& GetSoftwareFrame() const;
+#endif
   // Gets Actual Window size
   const olc::vi2d& GetWindowSize() const;
   // Gets Actual Window position
@@ -1311,14 +1494,28 @@ class PixelGameEngine {
   void FillTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2,
                     const olc::vi2d& pos3, Pixel p = olc::WHITE);
   // Fill a textured and coloured triangle
-  void FillTexturedTriangle(std::vector<olc::vf2d> vPoints,
-                            std::vector<olc::vf2d> vTex,
-                            std::vector<olc::Pixel> vColour,
+  void FillTexturedTriangle(const std::vector<olc::vf2d>& vPoints,
+                            const std::vector<olc::vf2d>& vTex,
+                            const std::vector<olc::Pixel>& vColour,
                             olc::Sprite* sprTex);
   void FillTexturedPolygon(
       const std::vector<olc::vf2d>& vPoints, const std::vector<olc::vf2d>& vTex,
       const std::vector<olc::Pixel>& vColour, olc::Sprite* sprTex,
       olc::DecalStructure structure = olc::DecalStructure::LIST);
+  // Fill a batch of textured and coloured triangles in one pass, split into
+  // screen tiles that are filled in parallel. The texture is sampled
+  // bilinearly if bFilter is set.
+  void FillTexturedTriangles(
+      const olc::TexturedVertex* pVertices, size_t nVertices,
+      olc::Sprite* sprTex,
+      olc::DecalStructure structure = olc::DecalStructure::LIST,
+      bool bFilter = false);
+  void FillTexturedTriangles(
+      const std::vector<olc::TexturedVertex>& vVertices, olc::Sprite* sprTex,
+      olc::DecalStructure structure = olc::DecalStructure::LIST,
+      bool bFilter = false);
+  // Threads that fill triangles, counting the caller. 0 uses every core.
+  void SetRasterThreads(uint32_t nThreads = 0);
   // Draws an entire sprite at location (x,y)
   void DrawSprite(int32_t x, int32_t y, Sprite* sprite, uint32_t scale = 1,
                   uint8_t flip = olc::Sprite::NONE);
@@ -1487,6 +1684,21 @@ class PixelGameEngine {
  private:
   void UpdateTextEntry();
   void UpdateConsole();
+  // Fills x1 to x2 inclusive of row y, clipped to the draw target
+  void FillSpan(int32_t x1, int32_t x2, int32_t y, Pixel p);
+  // Draws a region of a sprite a row at a time, clipped once up front.
+  // Returns false if it cannot, leaving it to the per pixel path.
+  bool BlitSprite(int32_t x, int32_t y, Sprite* sprite, int32_t ox, int32_t oy,
+                  int32_t w, int32_t h, uint32_t scale, uint8_t flip);
+  // Draws the first nWidth columns of the font glyph at (ox, oy) as spans
+  void DrawGlyph(int32_t x, int32_t y, int32_t ox, int32_t oy, int32_t nWidth,
+                 uint32_t scale, Pixel col);
+  // Queues a decal of nPoints vertices on the target layer, in the current
+  // decal mode and structure. Its vertices are white with w of 1, and may
+  // only be written until the next decal is added.
+  olc::DecalInstance& AddDecal(olc::Decal* decal, uint32_t nPoints);
+  // Draws the layer's queued decals, then empties its queue and arena
+  void DrawLayerDecals(LayerDesc& layer);
 
  public:
   // Experimental Lightweight 3D Routines ================
@@ -1533,6 +1745,8 @@ class PixelGameEngine {
   olc::Sprite* pDrawTarget = nullptr;
   Pixel::Mode nPixelMode = Pixel::NORMAL;
   float fBlendFactor = 1.0f;
+  // fBlendFactor in fixed point, out of 32768
+  uint32_t nBlendWeight = 32768;
   olc::vi2d vScreenSize = {256, 240};
   olc::vf2d vInvScreenSize = {1.0f / 256.0f, 1.0f / 240.0f};
   olc::vi2d vPixelSize = {4, 4};
@@ -1558,6 +1772,12 @@ class PixelGameEngine {
   float fLastElapsed = 0.0f;
   int nFrameCount = 0;
   bool bSuspendTextureTransfer = false;
+  // Sprite rows scaled or flipped ready for BlitSprite
+  std::vector<Pixel> vBlitRow;
+  // Created on first use by FillTexturedTriangles
+  std::unique_ptr<TriangleRasterizer> pRasterizer;
+  uint32_t nRasterThreads = 0;
+  std::vector<TexturedVertex> vRasterVertices;
   Renderable fontRenderable;
   std::vector<LayerDesc> vLayers;
   uint8_t nTargetLayer = 0;
@@ -1566,6 +1786,24 @@ class PixelGameEngine {
   bool bPixelCohesion = false;
   DecalMode nDecalMode = DecalMode::NORMAL;
   DecalStructure nDecalStructure = DecalStructure::FAN;
+  // Decals drawn in one call, with the screen area they cover
+  struct sDecalBatch {
+    uint32_t nFirst = 0;
+    uint32_t nDecals = 0;
+    uint32_t nPoints = 0;
+    uint32_t nVertex = 0;
+    bool bMergeable = false;
+    olc::vf2d vMin, vMax;
+  };
+  std::vector<sDecalBatch> vDecalBatches;
+  std::vector<uint32_t> vDecalBatchOf;
+  DecalArena decalBatchArena;
+  DecalBatchStats decalStats, decalStatsLast;
+#if defined(OLC_PGE_PROFILE)
+  bool bProfilerOverlay = false;
+  std::vector<profile::Event> vProfileEvents;
+  void DrawProfilerOverlay();
+#endif
   std::function<olc::Pixel(const int x, const int y, const olc::Pixel&,
                            const olc::Pixel&)>
       funcPixelMode;
@@ -1791,6 +2029,21 @@ typedef void CALLSTYLE locShaderSource_t(GLuint shader, GLsizei count,
 // | olcPixelGameEngine INTERFACE IMPLEMENTATION (CORE) | | Note: The core
 // implementation is platform independent                        |
 // O------------------------------------------------------------------------------O
+#if defined(OLC_SIMD_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Compiles one function for an instruction set beyond the build's baseline.
+// MSVC needs nothing, it allows any intrinsic anywhere.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define OLC_TARGET(isa)
+#else
+#define OLC_TARGET(isa) __attribute__((target(isa)))
+#endif
+
 #pragma region pge_implementation
 namespace olc {
 // O------------------------------------------------------------------------------O
@@ -1911,6 +2164,958 @@ Pixel PixelLerp(const olc::Pixel& p1, const olc::Pixel& p2, float t) {
   return (p2 * t) + p1 * (1.0f - t);
 }
 #endif
+
+// O------------------------------------------------------------------------------O
+// | olc::simd IMPLEMENTATION |
+// O------------------------------------------------------------------------------O
+namespace simd {
+static void FillScalar(Pixel* pDst, size_t n, Pixel p) {
+  for (size_t i = 0; i < n; i++) pDst[i] = p;
+}
+
+#if defined(OLC_SIMD_X86)
+// Spans end with one store overlapping the previous one rather than a
+// pixel at a time.
+static OLC_TARGET("sse2") void FillSSE2(Pixel* pDst, size_t n, Pixel p) {
+  if (n < 4) return FillScalar(pDst, n, p);
+  const __m128i v = _mm_set1_epi32(int(p.n));
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm_storeu_si128((__m128i*)(pDst + i), v);
+    _mm_storeu_si128((__m128i*)(pDst + i + 4), v);
+    _mm_storeu_si128((__m128i*)(pDst + i + 8), v);
+    _mm_storeu_si128((__m128i*)(pDst + i + 12), v);
+  }
+  for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(pDst + i), v);
+  _mm_storeu_si128((__m128i*)(pDst + n - 4), v);
+}
+
+static OLC_TARGET("avx2") void FillAVX2(Pixel* pDst, size_t n, Pixel p) {
+  if (n < 8) return FillSSE2(pDst, n, p);
+  const __m256i v = _mm256_set1_epi32(int(p.n));
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    _mm256_storeu_si256((__m256i*)(pDst + i), v);
+    _mm256_storeu_si256((__m256i*)(pDst + i + 8), v);
+    _mm256_storeu_si256((__m256i*)(pDst + i + 16), v);
+    _mm256_storeu_si256((__m256i*)(pDst + i + 24), v);
+  }
+  for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i*)(pDst + i), v);
+  _mm256_storeu_si256((__m256i*)(pDst + n - 8), v);
+}
+#endif
+
+static void CopyMaskedScalar(Pixel* pDst, const Pixel* pSrc, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    if (pSrc[i].a == 255) pDst[i] = pSrc[i];
+}
+
+#if defined(OLC_SIMD_X86)
+// Opaque lanes take the source, the rest keep the destination
+static OLC_TARGET("sse2") void CopyMaskedSSE2(Pixel* pDst, const Pixel* pSrc,
+                                              size_t n) {
+  const __m128i vAlpha = _mm_set1_epi32(int(0xFF000000));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+    __m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+    __m128i m = _mm_cmpeq_epi32(_mm_and_si128(s, vAlpha), vAlpha);
+    _mm_storeu_si128((__m128i*)(pDst + i),
+                     _mm_or_si128(_mm_and_si128(m, s), _mm_andnot_si128(m, d)));
+  }
+  CopyMaskedScalar(pDst + i, pSrc + i, n - i);
+}
+
+static OLC_TARGET("avx2") void CopyMaskedAVX2(Pixel* pDst, const Pixel* pSrc,
+                                              size_t n) {
+  const __m256i vAlpha = _mm256_set1_epi32(int(0xFF000000));
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i s = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(pDst + i));
+    __m256i m = _mm256_cmpeq_epi32(_mm256_and_si256(s, vAlpha), vAlpha);
+    _mm256_storeu_si256((__m256i*)(pDst + i), _mm256_blendv_epi8(d, s, m));
+  }
+  // Not handed to the SSE2 version: calling legacy SSE code with the upper
+  // halves of the ymm registers dirty stalls badly on some CPUs.
+  for (; i < n; i++)
+    if (pSrc[i].a == 255) pDst[i] = pSrc[i];
+}
+#endif
+
+// Blending is fixed point, (a * s + (255 - a) * d + 128) * 257 >> 16 per
+// channel, which is s and d mixed by a / 255 and rounded.
+static inline uint8_t BlendChannel(uint32_t s, uint32_t d, uint32_t a) {
+  uint32_t t = s * a + d * (255 - a) + 128;
+  return uint8_t((t + (t >> 8)) >> 8);
+}
+
+// Alpha scaled by a blend weight out of 32768, rounded
+static inline uint32_t ScaleAlpha(uint32_t a, uint32_t nWeight) {
+  return (a * nWeight + 16384) >> 15;
+}
+
+static inline Pixel BlendPixel(Pixel s, Pixel d, uint32_t a) {
+  return Pixel(BlendChannel(s.r, d.r, a), BlendChannel(s.g, d.g, a),
+               BlendChannel(s.b, d.b, a));
+}
+
+static void BlendScalar(Pixel* pDst, const Pixel* pSrc, size_t n,
+                        uint32_t nWeight) {
+  for (size_t i = 0; i < n; i++)
+    pDst[i] = BlendPixel(pSrc[i], pDst[i], ScaleAlpha(pSrc[i].a, nWeight));
+}
+
+static void BlendFillScalar(Pixel* pDst, size_t n, Pixel p) {
+  for (size_t i = 0; i < n; i++) pDst[i] = BlendPixel(p, pDst[i], p.a);
+}
+
+#if defined(OLC_SIMD_X86)
+// BlendChannel() on 16 bit lanes
+static OLC_TARGET("sse2") inline __m128i Mix16(__m128i s, __m128i d,
+                                               __m128i a) {
+  __m128i t = _mm_add_epi16(
+      _mm_add_epi16(_mm_mullo_epi16(s, a),
+                    _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a))),
+      _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static OLC_TARGET("avx2") inline __m256i Mix16(__m256i s, __m256i d,
+                                               __m256i a) {
+  __m256i t = _mm256_add_epi16(
+      _mm256_add_epi16(
+          _mm256_mullo_epi16(s, a),
+          _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a))),
+      _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// Pixels are widened to 16 bits a channel, two per 128 bits, with the
+// weight of each pixel (a32, one per 32 bit lane) in all four channels.
+static OLC_TARGET("sse2") inline __m128i Blend4(__m128i s, __m128i d,
+                                                __m128i a32) {
+  const __m128i vZero = _mm_setzero_si128();
+  __m128i a = _mm_or_si128(a32, _mm_slli_epi32(a32, 16));
+  __m128i lo = Mix16(_mm_unpacklo_epi8(s, vZero), _mm_unpacklo_epi8(d, vZero),
+                     _mm_unpacklo_epi32(a, a));
+  __m128i hi = Mix16(_mm_unpackhi_epi8(s, vZero), _mm_unpackhi_epi8(d, vZero),
+                     _mm_unpackhi_epi32(a, a));
+  return _mm_or_si128(_mm_packus_epi16(lo, hi),
+                      _mm_set1_epi32(int(0xFF000000)));
+}
+
+static OLC_TARGET("avx2") inline __m256i Blend8(__m256i s, __m256i d,
+                                                __m256i a32) {
+  const __m256i vZero = _mm256_setzero_si256();
+  __m256i a = _mm256_or_si256(a32, _mm256_slli_epi32(a32, 16));
+  __m256i lo =
+      Mix16(_mm256_unpacklo_epi8(s, vZero), _mm256_unpacklo_epi8(d, vZero),
+            _mm256_unpacklo_epi32(a, a));
+  __m256i hi =
+      Mix16(_mm256_unpackhi_epi8(s, vZero), _mm256_unpackhi_epi8(d, vZero),
+            _mm256_unpackhi_epi32(a, a));
+  return _mm256_or_si256(_mm256_packus_epi16(lo, hi),
+                         _mm256_set1_epi32(int(0xFF000000)));
+}
+
+// ScaleAlpha() is done with madd: each 32 bit lane holds the alpha and a 1
+// as 16 bit halves, multiplied by the weight and 16384 and summed. A full
+// weight would not fit a signed 16 bit factor, but needs no scaling anyway.
+static OLC_TARGET("sse2") void BlendSSE2(Pixel* pDst, const Pixel* pSrc,
+                                         size_t n, uint32_t nWeight) {
+  const bool bScale = nWeight < 32768;
+  const __m128i vOne = _mm_set1_epi32(1 << 16);
+  const __m128i vWeight = _mm_set1_epi32(int((16384u << 16) | nWeight));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+    __m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+    __m128i a = _mm_srli_epi32(s, 24);
+    if (bScale)
+      a = _mm_srli_epi32(_mm_madd_epi16(_mm_or_si128(a, vOne), vWeight), 15);
+    _mm_storeu_si128((__m128i*)(pDst + i), Blend4(s, d, a));
+  }
+  BlendScalar(pDst + i, pSrc + i, n - i, nWeight);
+}
+
+static OLC_TARGET("avx2") void BlendAVX2(Pixel* pDst, const Pixel* pSrc,
+                                         size_t n, uint32_t nWeight) {
+  const bool bScale = nWeight < 32768;
+  const __m256i vOne = _mm256_set1_epi32(1 << 16);
+  const __m256i vWeight = _mm256_set1_epi32(int((16384u << 16) | nWeight));
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i s = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(pDst + i));
+    __m256i a = _mm256_srli_epi32(s, 24);
+    if (bScale)
+      a = _mm256_srli_epi32(
+          _mm256_madd_epi16(_mm256_or_si256(a, vOne), vWeight), 15);
+    _mm256_storeu_si256((__m256i*)(pDst + i), Blend8(s, d, a));
+  }
+  for (; i < n; i++)
+    pDst[i] = BlendPixel(pSrc[i], pDst[i], ScaleAlpha(pSrc[i].a, nWeight));
+}
+
+static OLC_TARGET("sse2") void BlendFillSSE2(Pixel* pDst, size_t n, Pixel p) {
+  const __m128i s = _mm_set1_epi32(int(p.n));
+  const __m128i a = _mm_set1_epi32(p.a);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+    _mm_storeu_si128((__m128i*)(pDst + i), Blend4(s, d, a));
+  }
+  BlendFillScalar(pDst + i, n - i, p);
+}
+
+static OLC_TARGET("avx2") void BlendFillAVX2(Pixel* pDst, size_t n, Pixel p) {
+  const __m256i s = _mm256_set1_epi32(int(p.n));
+  const __m256i a = _mm256_set1_epi32(p.a);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i d = _mm256_loadu_si256((const __m256i*)(pDst + i));
+    _mm256_storeu_si256((__m256i*)(pDst + i), Blend8(s, d, a));
+  }
+  for (; i < n; i++) pDst[i] = BlendPixel(p, pDst[i], p.a);
+}
+#endif
+
+// Bilinear samples are fixed point too. Points step along in texels with
+// 16 fraction bits; the top 8 of those mix the texel pairs above and below,
+// then the two results, each step rounded.
+struct sTexelWalk {
+  int64_t nU, nV, nStepU, nStepV;
+  int32_t nWidth, nHeight;
+
+  sTexelWalk(float u, float v, float du, float dv, int32_t w, int32_t h)
+      : nWidth(w), nHeight(h) {
+    // Held well inside int64 however far off the texture the points are
+    auto Fixed = [](double t) {
+      return int64_t(std::floor(std::max(-1e12, std::min(t, 1e12)) * 65536.0));
+    };
+    nU = Fixed(double(u) * w - 0.5);
+    nV = Fixed(double(v) * h - 0.5);
+    nStepU = Fixed(double(du) * w);
+    nStepV = Fixed(double(dv) * h);
+  }
+
+  // Texel columns and rows either side of the point, clamped to the image,
+  // and the fractions between them
+  void Next(int32_t& x0, int32_t& x1, int32_t& y0, int32_t& y1, uint32_t& fx,
+            uint32_t& fy) {
+    int64_t x = nU >> 16, y = nV >> 16;
+    fx = uint32_t(nU >> 8) & 255;
+    fy = uint32_t(nV >> 8) & 255;
+    x0 = int32_t(std::max<int64_t>(0, std::min<int64_t>(x, nWidth - 1)));
+    x1 = int32_t(std::max<int64_t>(0, std::min<int64_t>(x + 1, nWidth - 1)));
+    y0 = int32_t(std::max<int64_t>(0, std::min<int64_t>(y, nHeight - 1)));
+    y1 = int32_t(std::max<int64_t>(0, std::min<int64_t>(y + 1, nHeight - 1)));
+    nU += nStepU;
+    nV += nStepV;
+  }
+};
+
+static inline uint32_t Lerp8(uint32_t a, uint32_t b, uint32_t f) {
+  return (a * (256 - f) + b * f + 128) >> 8;
+}
+
+static void SampleBLScalar(Pixel* pDst, size_t n, const Pixel* pTex,
+                           int32_t nWidth, int32_t nHeight, float u, float v,
+                           float du, float dv) {
+  sTexelWalk walk(u, v, du, dv, nWidth, nHeight);
+  for (size_t i = 0; i < n; i++) {
+    int32_t x0, x1, y0, y1;
+    uint32_t fx, fy;
+    walk.Next(x0, x1, y0, y1, fx, fy);
+    const Pixel* pRow0 = pTex + size_t(y0) * nWidth;
+    const Pixel* pRow1 = pTex + size_t(y1) * nWidth;
+    uint32_t nOut = 0;
+    for (uint32_t nShift = 0; nShift < 32; nShift += 8) {
+      uint32_t c0 = Lerp8((pRow0[x0].n >> nShift) & 255,
+                          (pRow1[x0].n >> nShift) & 255, fy);
+      uint32_t c1 = Lerp8((pRow0[x1].n >> nShift) & 255,
+                          (pRow1[x1].n >> nShift) & 255, fy);
+      nOut |= Lerp8(c0, c1, fx) << nShift;
+    }
+    pDst[i].n = nOut;
+  }
+}
+
+#if defined(OLC_SIMD_X86)
+// One point at a time, the left and right texels side by side in 16 bit
+// lanes. Also used at the AVX2 level: the cost is in the gathers, which
+// wider registers would not help.
+static OLC_TARGET("sse2") void SampleBLSSE2(Pixel* pDst, size_t n,
+                                            const Pixel* pTex, int32_t nWidth,
+                                            int32_t nHeight, float u, float v,
+                                            float du, float dv) {
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128i vRound = _mm_set1_epi16(128);
+  const __m128i v256 = _mm_set1_epi16(256);
+  sTexelWalk walk(u, v, du, dv, nWidth, nHeight);
+  for (size_t i = 0; i < n; i++) {
+    int32_t x0, x1, y0, y1;
+    uint32_t fx, fy;
+    walk.Next(x0, x1, y0, y1, fx, fy);
+    const Pixel* pRow0 = pTex + size_t(y0) * nWidth;
+    const Pixel* pRow1 = pTex + size_t(y1) * nWidth;
+    __m128i t, b;
+    if (x1 == x0 + 1) {
+      t = _mm_loadl_epi64((const __m128i*)(pRow0 + x0));
+      b = _mm_loadl_epi64((const __m128i*)(pRow1 + x0));
+    } else {
+      t = _mm_set_epi32(0, 0, int(pRow0[x1].n), int(pRow0[x0].n));
+      b = _mm_set_epi32(0, 0, int(pRow1[x1].n), int(pRow1[x0].n));
+    }
+    t = _mm_unpacklo_epi8(t, vZero);
+    b = _mm_unpacklo_epi8(b, vZero);
+
+    __m128i wy = _mm_set1_epi16(short(fy));
+    __m128i c = _mm_srli_epi16(
+        _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(t, _mm_sub_epi16(v256, wy)),
+                                    _mm_mullo_epi16(b, wy)),
+                      vRound),
+        8);
+
+    __m128i wx = _mm_set1_epi16(short(fx));
+    __m128i r = _mm_srli_epi16(
+        _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(c, _mm_sub_epi16(v256, wx)),
+                          _mm_mullo_epi16(_mm_unpackhi_epi64(c, c), wx)),
+            vRound),
+        8);
+    pDst[i].n = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(r, r)));
+  }
+}
+#endif
+
+// Multiplies n pixels by a colour that changes along the span, each channel
+// as 16.16 fixed point starting at nTint and moving by nStep a pixel
+static void TintScalar(Pixel* pDst, size_t n, const int32_t* nTint,
+                       const int32_t* nStep) {
+  int32_t t[4] = {nTint[0], nTint[1], nTint[2], nTint[3]};
+  for (size_t i = 0; i < n; i++) {
+    uint32_t nOut = 0;
+    for (int c = 0; c < 4; c++) {
+      uint32_t m = ((pDst[i].n >> (c * 8)) & 255) *
+                       uint32_t(std::max(0, std::min(t[c] >> 16, 255))) +
+                   128;
+      nOut |= ((m + (m >> 8)) >> 8) << (c * 8);
+      t[c] += nStep[c];
+    }
+    pDst[i].n = nOut;
+  }
+}
+
+#if defined(OLC_SIMD_X86)
+// Two pixels at a time in 16 bit lanes
+static OLC_TARGET("sse2") void TintSSE2(Pixel* pDst, size_t n,
+                                        const int32_t* nTint,
+                                        const int32_t* nStep) {
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128i v255 = _mm_set1_epi16(255);
+  const __m128i vStep = _mm_loadu_si128((const __m128i*)nStep);
+  const __m128i vStep2 = _mm_add_epi32(vStep, vStep);
+  __m128i t0 = _mm_loadu_si128((const __m128i*)nTint);
+  __m128i t1 = _mm_add_epi32(t0, vStep);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i t = _mm_packs_epi32(_mm_srai_epi32(t0, 16), _mm_srai_epi32(t1, 16));
+    t = _mm_min_epi16(_mm_max_epi16(t, vZero), v255);
+    __m128i p = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i*)(pDst + i)), vZero);
+    __m128i m = _mm_add_epi16(_mm_mullo_epi16(p, t), _mm_set1_epi16(128));
+    m = _mm_srli_epi16(_mm_add_epi16(m, _mm_srli_epi16(m, 8)), 8);
+    _mm_storel_epi64((__m128i*)(pDst + i), _mm_packus_epi16(m, m));
+    t0 = _mm_add_epi32(t0, vStep2);
+    t1 = _mm_add_epi32(t1, vStep2);
+  }
+  if (i < n) {
+    alignas(16) int32_t nLast[4];
+    _mm_store_si128((__m128i*)nLast, t0);
+    TintScalar(pDst + i, n - i, nLast, nStep);
+  }
+}
+#endif
+
+struct Kernels {
+  void (*Fill)(Pixel*, size_t, Pixel);
+  void (*CopyMasked)(Pixel*, const Pixel*, size_t);
+  void (*Blend)(Pixel*, const Pixel*, size_t, uint32_t);
+  void (*BlendFill)(Pixel*, size_t, Pixel);
+  void (*SampleBL)(Pixel*, size_t, const Pixel*, int32_t, int32_t, float,
+                   float, float, float);
+  void (*Tint)(Pixel*, size_t, const int32_t*, const int32_t*);
+};
+
+static Kernels KernelsFor(Level level) {
+#if defined(OLC_SIMD_X86)
+  if (level == Level::AVX2)
+    return {FillAVX2,      CopyMaskedAVX2, BlendAVX2,
+            BlendFillAVX2, SampleBLSSE2,   TintSSE2};
+  if (level == Level::SSE2)
+    return {FillSSE2,      CopyMaskedSSE2, BlendSSE2,
+            BlendFillSSE2, SampleBLSSE2,   TintSSE2};
+#endif
+  return {FillScalar,      CopyMaskedScalar, BlendScalar,
+          BlendFillScalar, SampleBLScalar,   TintScalar};
+}
+
+static Level& ActiveLevel() {
+  static Level level = Supported();
+  return level;
+}
+
+static Kernels& ActiveKernels() {
+  static Kernels kernels = KernelsFor(ActiveLevel());
+  return kernels;
+}
+
+Level Supported() {
+  static const Level level = []() {
+#if defined(OLC_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int nMaxLeaf = info[0];
+    __cpuid(info, 1);
+    bool bSSE2 = (info[3] & (1 << 26)) != 0;
+    // AVX state must be enabled by the OS as well as present in the CPU
+    bool bAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                (_xgetbv(0) & 6) == 6;
+    bool bAVX2 = false;
+    if (bAVX && nMaxLeaf >= 7) {
+      __cpuidex(info, 7, 0);
+      bAVX2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool bSSE2 = __builtin_cpu_supports("sse2");
+    bool bAVX2 = __builtin_cpu_supports("avx2");
+#endif
+    if (bAVX2) return Level::AVX2;
+    if (bSSE2) return Level::SSE2;
+#endif
+    return Level::Scalar;
+  }();
+  return level;
+}
+
+Level Active() { return ActiveLevel(); }
+
+void SetLevel(Level level) {
+  ActiveLevel() = std::min(level, Supported());
+  ActiveKernels() = KernelsFor(ActiveLevel());
+}
+
+void Fill(Pixel* pDst, size_t n, Pixel p) { ActiveKernels().Fill(pDst, n, p); }
+
+void CopyMasked(Pixel* pDst, const Pixel* pSrc, size_t n) {
+  ActiveKernels().CopyMasked(pDst, pSrc, n);
+}
+
+void Blend(Pixel* pDst, const Pixel* pSrc, size_t n, uint32_t nWeight) {
+  ActiveKernels().Blend(pDst, pSrc, n, nWeight);
+}
+
+void BlendFill(Pixel* pDst, size_t n, Pixel p) {
+  ActiveKernels().BlendFill(pDst, n, p);
+}
+
+void SampleBL(Pixel* pDst, size_t n, const Pixel* pTex, int32_t nWidth,
+              int32_t nHeight, float u, float v, float du, float dv) {
+  ActiveKernels().SampleBL(pDst, n, pTex, nWidth, nHeight, u, v, du, dv);
+}
+}  // namespace simd
+
+// O------------------------------------------------------------------------------O
+// | olc::profile IMPLEMENTATION |
+// O------------------------------------------------------------------------------O
+// Zones are recorded when they end into a fixed ring of slots. A writer claims
+// the next slot with one atomic add and marks it busy while filling it in; a
+// reader keeps a slot only if its sequence number is the one expected both
+// before and after copying it, so slots being rewritten are skipped.
+#if defined(OLC_PGE_PROFILE)
+namespace profile {
+namespace {
+constexpr uint64_t nRingSize = uint64_t(1) << 16;
+constexpr uint64_t nSlotBusy = ~uint64_t(0);
+
+struct sSlot {
+  std::atomic<uint64_t> nSeq{nSlotBusy};
+  std::atomic<const char*> sName{nullptr};
+  std::atomic<uint64_t> nStart{0};
+  std::atomic<uint64_t> nEnd{0};
+  std::atomic<uint32_t> nThread{0};
+};
+
+sSlot ring[nRingSize];
+std::atomic<uint64_t> nNextSlot{0};
+std::atomic<uint32_t> nNextThread{0};
+const std::chrono::steady_clock::time_point tpStart =
+    std::chrono::steady_clock::now();
+
+// Trace timestamps are in microseconds
+std::string Micros(uint64_t nNanos) {
+  std::string s = std::to_string(nNanos / 1000) + ".000";
+  std::string sFrac = std::to_string(nNanos % 1000);
+  s.replace(s.size() - sFrac.size(), sFrac.size(), sFrac);
+  return s;
+}
+}  // namespace
+
+uint64_t Now() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - tpStart)
+                      .count());
+}
+
+uint32_t ThreadID() {
+  thread_local uint32_t nThread = nNextThread.fetch_add(1);
+  return nThread;
+}
+
+void Record(const char* sName, uint64_t nStart, uint64_t nEnd) {
+  uint64_t n = nNextSlot.fetch_add(1, std::memory_order_relaxed);
+  sSlot& slot = ring[n & (nRingSize - 1)];
+  slot.nSeq.store(nSlotBusy, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.sName.store(sName, std::memory_order_relaxed);
+  slot.nStart.store(nStart, std::memory_order_relaxed);
+  slot.nEnd.store(nEnd, std::memory_order_relaxed);
+  slot.nThread.store(ThreadID(), std::memory_order_relaxed);
+  slot.nSeq.store(n, std::memory_order_release);
+}
+
+void ReadEvents(std::vector<Event>& vEvents, size_t nMax) {
+  vEvents.clear();
+  uint64_t nEnd = nNextSlot.load(std::memory_order_acquire);
+  uint64_t nCount = std::min({nEnd, nRingSize, uint64_t(nMax)});
+  for (uint64_t n = nEnd - nCount; n < nEnd; n++) {
+    const sSlot& slot = ring[n & (nRingSize - 1)];
+    if (slot.nSeq.load(std::memory_order_acquire) != n) continue;
+    Event e;
+    e.sName = slot.sName.load(std::memory_order_relaxed);
+    e.nStart = slot.nStart.load(std::memory_order_relaxed);
+    e.nEnd = slot.nEnd.load(std::memory_order_relaxed);
+    e.nThread = slot.nThread.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.nSeq.load(std::memory_order_relaxed) != n) continue;
+    vEvents.push_back(e);
+  }
+}
+
+bool SaveChromeTrace(const std::string& sFile) {
+  std::vector<Event> vEvents;
+  ReadEvents(vEvents);
+
+  std::ofstream ofs(sFile, std::ofstream::out | std::ofstream::trunc);
+  if (!ofs.is_open()) return false;
+  ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i < vEvents.size(); i++) {
+    const Event& e = vEvents[i];
+    std::string sName;
+    for (const char* c = e.sName; *c; c++) {
+      if (*c == '"' || *c == '\\') sName += '\\';
+      if (uint8_t(*c) >= 0x20) sName += *c;
+    }
+    ofs << (i ? ",\n" : "\n") << "{\"name\":\"" << sName
+        << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.nThread
+        << ",\"ts\":" << Micros(e.nStart)
+        << ",\"dur\":" << Micros(e.nEnd - e.nStart) << "}";
+  }
+  ofs << "\n]}\n";
+  return ofs.good();
+}
+}  // namespace profile
+#endif
+
+// O------------------------------------------------------------------------------O
+// | olc::TriangleRasterizer IMPLEMENTATION |
+// O------------------------------------------------------------------------------O
+// A batch of triangles is set up once, sorted into 64x64 screen tiles by
+// bounding box and then filled a tile at a time. Tiles share no pixels, so
+// any number of threads can fill them at once, while within a tile the
+// triangles still go down in the order given.
+//
+// Vertices are snapped to 1/16 of a pixel and coverage is tested with
+// integer edge functions at pixel centres, stepped by addition along a row.
+// Pixels on an edge belong to the triangle only if it is a top or left
+// edge, so triangles sharing an edge cover every pixel along it once.
+class TriangleRasterizer {
+ public:
+  static constexpr int32_t nTileSize = 64;
+
+  // nThreads counts the caller; 0 means one per core
+  explicit TriangleRasterizer(uint32_t nThreads) {
+    if (nThreads == 0)
+      nThreads = std::max(1u, std::thread::hardware_concurrency());
+    nWorkers = nThreads - 1;
+  }
+
+  ~TriangleRasterizer() {
+    {
+      std::scoped_lock lock(mux);
+      bStop = true;
+    }
+    cvWork.notify_all();
+    for (auto& thread : vThreads) thread.join();
+  }
+
+  TriangleRasterizer(const TriangleRasterizer&) = delete;
+  TriangleRasterizer& operator=(const TriangleRasterizer&) = delete;
+
+  void Draw(PixelGameEngine* pge, Sprite* pTarget, const TexturedVertex* pVerts,
+            size_t nVerts, DecalStructure structure, Sprite* sprTex,
+            bool bFilter, Pixel::Mode mode, uint32_t nBlendWeight) {
+    this->pge = pge;
+    this->pTarget = pTarget;
+    this->sprTex = sprTex;
+    this->bFilter = bFilter && sprTex != nullptr && sprTex->width > 0 &&
+                    sprTex->height > 0;
+    this->mode = mode;
+    this->nBlendWeight = nBlendWeight;
+
+    vTriangles.clear();
+    if (structure == DecalStructure::LIST) {
+      for (size_t i = 0; i + 2 < nVerts; i += 3)
+        Setup(pVerts[i], pVerts[i + 1], pVerts[i + 2]);
+    } else if (structure == DecalStructure::STRIP) {
+      for (size_t i = 2; i < nVerts; i++)
+        Setup(pVerts[i - 2], pVerts[i - 1], pVerts[i]);
+    } else if (structure == DecalStructure::FAN) {
+      for (size_t i = 2; i < nVerts; i++)
+        Setup(pVerts[0], pVerts[i - 1], pVerts[i]);
+    }
+    if (vTriangles.empty()) return;
+
+    // Marked as one area, tiles are written without further bookkeeping
+    olc::vi2d vMin = {pTarget->width, pTarget->height}, vMax = {-1, -1};
+    for (const sTriangle& tri : vTriangles) {
+      vMin = vMin.min({tri.x0, tri.y0});
+      vMax = vMax.max({tri.x1, tri.y1});
+    }
+    pTarget->MarkDirty(vMin.x, vMin.y, vMax.x - vMin.x + 1,
+                       vMax.y - vMin.y + 1);
+
+    uint64_t nArea = Bin();
+
+    // Custom pixel modes call back into user code, which may not expect
+    // other threads; small batches are not worth waking anyone for.
+    if (nWorkers == 0 || mode == Pixel::CUSTOM || vActiveTiles.size() < 2 ||
+        nArea < uint64_t(nTileSize * nTileSize * 4)) {
+      for (uint32_t nTile : vActiveTiles) FillTile(nTile);
+    } else {
+      RunParallel();
+    }
+
+    for (uint32_t nTile : vActiveTiles) vBins[nTile].clear();
+  }
+
+ private:
+  struct sTriangle {
+    // Covered pixels lie within these, inclusive and clipped to the target
+    int32_t x0, y0, x1, y1;
+    // Edge functions at the centre of pixel (x0, y0), their steps, and
+    // 1 / |dex| to find where a row crosses them
+    int64_t e[3], dex[3], dey[3];
+    double inv[3];
+    // u, v, r, g, b, a at the centre of pixel (x0, y0), and their steps
+    float f[6], dfx[6], dfy[6];
+    bool bTint;
+  };
+
+  static int64_t FloorDiv16(int64_t n) {
+    return n >= 0 ? n / 16 : -((15 - n) / 16);
+  }
+
+  void Setup(const TexturedVertex& v0, const TexturedVertex& v1,
+             const TexturedVertex& v2) {
+    const TexturedVertex* v[3] = {&v0, &v1, &v2};
+    int64_t X[3], Y[3];
+    for (int i = 0; i < 3; i++) {
+      // Also rejects NaN. Past a million pixels the edge functions could
+      // overflow, and such a triangle is nonsense anyway.
+      if (!(std::abs(v[i]->pos.x) < 1048576.0f) ||
+          !(std::abs(v[i]->pos.y) < 1048576.0f))
+        return;
+      X[i] = std::llround(v[i]->pos.x * 16.0f);
+      Y[i] = std::llround(v[i]->pos.y * 16.0f);
+    }
+
+    int64_t nArea =
+        (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+    if (nArea == 0) return;
+    if (nArea < 0) {
+      std::swap(v[1], v[2]);
+      std::swap(X[1], X[2]);
+      std::swap(Y[1], Y[2]);
+    }
+
+    sTriangle tri;
+    // Pixel centres are at 16 * x + 8
+    tri.x0 = int32_t(std::max<int64_t>(
+        0, FloorDiv16(std::min({X[0], X[1], X[2]}) + 7)));
+    tri.y0 = int32_t(std::max<int64_t>(
+        0, FloorDiv16(std::min({Y[0], Y[1], Y[2]}) + 7)));
+    tri.x1 = int32_t(std::min<int64_t>(
+        pTarget->width - 1, FloorDiv16(std::max({X[0], X[1], X[2]}) - 8)));
+    tri.y1 = int32_t(std::min<int64_t>(
+        pTarget->height - 1, FloorDiv16(std::max({Y[0], Y[1], Y[2]}) - 8)));
+    if (tri.x0 > tri.x1 || tri.y0 > tri.y1) return;
+
+    int64_t nCentreX = int64_t(tri.x0) * 16 + 8;
+    int64_t nCentreY = int64_t(tri.y0) * 16 + 8;
+    for (int i = 0; i < 3; i++) {
+      int j = (i + 1) % 3, k = (i + 2) % 3;
+      int64_t dx = X[k] - X[j], dy = Y[k] - Y[j];
+      bool bTopLeft = dy < 0 || (dy == 0 && dx > 0);
+      tri.e[i] = dx * (nCentreY - Y[j]) - dy * (nCentreX - X[j]) -
+                 (bTopLeft ? 0 : 1);
+      tri.dex[i] = -dy * 16;
+      tri.dey[i] = dx * 16;
+      tri.inv[i] = dy != 0 ? 1.0 / double(std::abs(dy * 16)) : 0.0;
+    }
+
+    // Attributes are planes over the screen, not perspective corrected
+    float x[3], y[3], a[3][6];
+    for (int i = 0; i < 3; i++) {
+      x[i] = float(X[i]) / 16.0f;
+      y[i] = float(Y[i]) / 16.0f;
+      a[i][0] = v[i]->uv.x;
+      a[i][1] = v[i]->uv.y;
+      a[i][2] = v[i]->col.r;
+      a[i][3] = v[i]->col.g;
+      a[i][4] = v[i]->col.b;
+      a[i][5] = v[i]->col.a;
+    }
+    float fDet = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    float fX = tri.x0 + 0.5f - x[0], fY = tri.y0 + 0.5f - y[0];
+    for (int n = 0; n < 6; n++) {
+      float d1 = a[1][n] - a[0][n], d2 = a[2][n] - a[0][n];
+      tri.dfx[n] = (d1 * (y[2] - y[0]) - d2 * (y[1] - y[0])) / fDet;
+      tri.dfy[n] = (d2 * (x[1] - x[0]) - d1 * (x[2] - x[0])) / fDet;
+      tri.f[n] = a[0][n] + tri.dfx[n] * fX + tri.dfy[n] * fY;
+    }
+    tri.bTint = v0.col != WHITE || v1.col != WHITE || v2.col != WHITE;
+    vTriangles.push_back(tri);
+  }
+
+  // Sorts the triangles into the tiles they touch, skipping tiles wholly
+  // outside an edge. Returns the pixels covered by their bounds.
+  uint64_t Bin() {
+    nTilesX = (pTarget->width + nTileSize - 1) / nTileSize;
+    int32_t nTilesY = (pTarget->height + nTileSize - 1) / nTileSize;
+    if (vBins.size() < size_t(nTilesX * nTilesY))
+      vBins.resize(nTilesX * nTilesY);
+
+    vActiveTiles.clear();
+    uint64_t nArea = 0;
+    for (uint32_t t = 0; t < uint32_t(vTriangles.size()); t++) {
+      const sTriangle& tri = vTriangles[t];
+      nArea += uint64_t(tri.x1 - tri.x0 + 1) * uint64_t(tri.y1 - tri.y0 + 1);
+      for (int32_t ty = tri.y0 / nTileSize; ty <= tri.y1 / nTileSize; ty++)
+        for (int32_t tx = tri.x0 / nTileSize; tx <= tri.x1 / nTileSize; tx++) {
+          // Test the corner of the tile, within the bounds, furthest inside
+          // each edge
+          int32_t nLeft = std::max(tri.x0, tx * nTileSize) - tri.x0;
+          int32_t nRight =
+              std::min(tri.x1, (tx + 1) * nTileSize - 1) - tri.x0;
+          int32_t nTop = std::max(tri.y0, ty * nTileSize) - tri.y0;
+          int32_t nBottom =
+              std::min(tri.y1, (ty + 1) * nTileSize - 1) - tri.y0;
+          bool bOutside = false;
+          for (int i = 0; i < 3 && !bOutside; i++)
+            bOutside = tri.e[i] +
+                           tri.dex[i] * (tri.dex[i] > 0 ? nRight : nLeft) +
+                           tri.dey[i] * (tri.dey[i] > 0 ? nBottom : nTop) <
+                       0;
+          if (bOutside) continue;
+
+          auto& vBin = vBins[ty * nTilesX + tx];
+          if (vBin.empty()) vActiveTiles.push_back(ty * nTilesX + tx);
+          vBin.push_back(t);
+        }
+    }
+    return nArea;
+  }
+
+  void FillTile(uint32_t nTile) {
+    int32_t tx0 = int32_t(nTile % nTilesX) * nTileSize;
+    int32_t ty0 = int32_t(nTile / nTilesX) * nTileSize;
+    int32_t tx1 = std::min(tx0 + nTileSize, pTarget->width) - 1;
+    int32_t ty1 = std::min(ty0 + nTileSize, pTarget->height) - 1;
+    Pixel vRow[nTileSize];
+
+    for (uint32_t t : vBins[nTile]) {
+      const sTriangle& tri = vTriangles[t];
+      int32_t x0 = std::max(tri.x0, tx0), x1 = std::min(tri.x1, tx1);
+      int32_t y0 = std::max(tri.y0, ty0), y1 = std::min(tri.y1, ty1);
+      int64_t e[3];
+      for (int i = 0; i < 3; i++)
+        e[i] = tri.e[i] + tri.dex[i] * (x0 - tri.x0) +
+               tri.dey[i] * (y0 - tri.y0);
+
+      const int64_t nSpan = x1 - x0 + 1;
+      for (int32_t y = y0; y <= y1; y++) {
+        // Triangles are convex, so the covered pixels of a row are one run:
+        // where all three edges are >= 0. Each edge bounds it on one side
+        // by how many steps it takes to cross zero.
+        int64_t nFirst = 0, nLast = nSpan - 1;
+        for (int i = 0; i < 3 && nFirst <= nLast; i++) {
+          const int64_t w = e[i], d = tri.dex[i];
+          if (d > 0) {
+            if (w >= 0) continue;
+            // The estimate may be a step out either way
+            int64_t k =
+                int64_t(std::min(double(nSpan), double(-w) * tri.inv[i]));
+            while (k < nSpan && w + k * d < 0) k++;
+            while (k > 0 && w + (k - 1) * d >= 0) k--;
+            nFirst = std::max(nFirst, k);
+          } else if (w < 0) {
+            nLast = -1;
+          } else if (d < 0) {
+            int64_t k =
+                int64_t(std::min(double(nSpan - 1), double(w) * tri.inv[i]));
+            while (k < nSpan - 1 && w + (k + 1) * d >= 0) k++;
+            while (k >= 0 && w + k * d < 0) k--;
+            nLast = std::min(nLast, k);
+          }
+        }
+        if (nFirst <= nLast)
+          ShadeSpan(tri, x0 + int32_t(nFirst), int32_t(nLast - nFirst + 1), y,
+                    vRow);
+        for (int i = 0; i < 3; i++) e[i] += tri.dey[i];
+      }
+    }
+  }
+
+  void ShadeSpan(const sTriangle& tri, int32_t x, int32_t n, int32_t y,
+                 Pixel* pRow) {
+    // The tint is only needed if it is not plain white
+    float f[6];
+    for (int i = 0; i < (tri.bTint ? 6 : 2); i++)
+      f[i] = tri.f[i] + tri.dfx[i] * (x - tri.x0) + tri.dfy[i] * (y - tri.y0);
+
+    if (sprTex == nullptr) {
+      for (int32_t i = 0; i < n; i++) pRow[i] = WHITE;
+    } else if (bFilter) {
+      simd::SampleBL(pRow, n, sprTex->GetData(), sprTex->width, sprTex->height,
+                     f[0], f[1], tri.dfx[0], tri.dfx[1]);
+    } else if (sprTex->modeSample == Sprite::Mode::NORMAL) {
+      // Sprite::Sample() inlined for the common mode. Spans that stay on
+      // the texture step through it in 16.16 fixed point.
+      const Pixel* pTex = sprTex->GetData();
+      const int32_t w = sprTex->width, h = sprTex->height;
+      int64_t nU = int64_t(double(f[0]) * w * 65536.0);
+      int64_t nV = int64_t(double(f[1]) * h * 65536.0);
+      int64_t nStepU = int64_t(double(tri.dfx[0]) * w * 65536.0);
+      int64_t nStepV = int64_t(double(tri.dfx[1]) * h * 65536.0);
+      int64_t nEndU = nU + nStepU * (n - 1), nEndV = nV + nStepV * (n - 1);
+      if (std::min(nU, nEndU) >= 0 && std::min(nV, nEndV) >= 0 &&
+          std::max(nU, nEndU) < (int64_t(w) << 16) &&
+          std::max(nV, nEndV) < (int64_t(h) << 16)) {
+        for (int32_t i = 0; i < n; i++, nU += nStepU, nV += nStepV)
+          pRow[i] = pTex[(nV >> 16) * w + (nU >> 16)];
+      } else {
+        for (int32_t i = 0; i < n; i++) {
+          int32_t sx = std::min(int32_t((f[0] + tri.dfx[0] * i) * w), w - 1);
+          int32_t sy = std::min(int32_t((f[1] + tri.dfx[1] * i) * h), h - 1);
+          pRow[i] = sx >= 0 && sy >= 0 ? pTex[sy * w + sx] : BLANK;
+        }
+      }
+    } else {
+      for (int32_t i = 0; i < n; i++)
+        pRow[i] = sprTex->Sample(f[0] + tri.dfx[0] * i, f[1] + tri.dfx[1] * i);
+    }
+
+    if (tri.bTint) {
+      int32_t nTint[4], nStep[4];
+      for (int c = 0; c < 4; c++) {
+        nTint[c] = int32_t(f[2 + c] * 65536.0f) + 32768;
+        nStep[c] = int32_t(tri.dfx[2 + c] * 65536.0f);
+      }
+      simd::ActiveKernels().Tint(pRow, n, nTint, nStep);
+    }
+
+    Pixel* pDst = pTarget->GetData() + size_t(y) * pTarget->width + x;
+    switch (mode) {
+      case Pixel::NORMAL:
+        std::memcpy(pDst, pRow, n * sizeof(Pixel));
+        break;
+      case Pixel::MASK:
+        simd::CopyMasked(pDst, pRow, n);
+        break;
+      case Pixel::ALPHA:
+        simd::Blend(pDst, pRow, n, nBlendWeight);
+        break;
+      case Pixel::CUSTOM:
+        for (int32_t i = 0; i < n; i++) pge->Draw(x + i, y, pRow[i]);
+        break;
+    }
+  }
+
+  // The caller and the workers take tiles until none are left
+  void RunParallel() {
+    nNextTile = 0;
+    {
+      std::scoped_lock lock(mux);
+      if (vThreads.empty())
+        for (uint32_t i = 0; i < nWorkers; i++)
+          vThreads.emplace_back([this]() { WorkerLoop(); });
+      nGeneration++;
+      nBusy = nWorkers;
+    }
+    cvWork.notify_all();
+    TakeTiles();
+    std::unique_lock lock(mux);
+    cvDone.wait(lock, [this]() { return nBusy == 0; });
+  }
+
+  void TakeTiles() {
+    for (size_t n = nNextTile++; n < vActiveTiles.size(); n = nNextTile++)
+      FillTile(vActiveTiles[n]);
+  }
+
+  void WorkerLoop() {
+    uint64_t nSeen = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mux);
+        cvWork.wait(lock, [&]() { return bStop || nGeneration != nSeen; });
+        if (bStop) return;
+        nSeen = nGeneration;
+      }
+      TakeTiles();
+      std::scoped_lock lock(mux);
+      if (--nBusy == 0) cvDone.notify_one();
+    }
+  }
+
+  // The batch being drawn
+  PixelGameEngine* pge = nullptr;
+  Sprite* pTarget = nullptr;
+  Sprite* sprTex = nullptr;
+  bool bFilter = false;
+  Pixel::Mode mode = Pixel::NORMAL;
+  uint32_t nBlendWeight = 32768;
+  std::vector<sTriangle> vTriangles;
+
+  // Triangle indices per tile, and the tiles that have any
+  int32_t nTilesX = 0;
+  std::vector<std::vector<uint32_t>> vBins;
+  std::vector<uint32_t> vActiveTiles;
+
+  uint32_t nWorkers = 0;
+  std::vector<std::thread> vThreads;
+  std::atomic<size_t> nNextTile{0};
+  std::mutex mux;
+  std::condition_variable cvWork, cvDone;
+  uint64_t nGeneration = 0;
+  uint32_t nBusy = 0;
+  bool bStop = false;
+};
 // O------------------------------------------------------------------------------O
 // | olc::Sprite IMPLEMENTATION |
 // O------------------------------------------------------------------------------O
@@ -1929,6 +3134,7 @@ void Sprite::SetSize(int32_t w, int32_t h) {
   width = w;
   height = h;
   pColData.resize(width * height, nDefaultPixel);
+  MarkDirty();
 }
 
 Sprite::~Sprite() { pColData.clear(); }
@@ -1959,6 +3165,12 @@ Pixel Sprite::GetPixel(int32_t x, int32_t y) const {
 bool Sprite::SetPixel(int32_t x, int32_t y, Pixel p) {
   if (x >= 0 && x < width && y >= 0 && y < height) {
     pColData[y * width + x] = p;
+    // Plotting is hot enough to skip the call when the pixel is covered
+    if (nLastDirty >= vDirty.size() || x < vDirty[nLastDirty].pos.x ||
+        y < vDirty[nLastDirty].pos.y ||
+        x >= vDirty[nLastDirty].pos.x + vDirty[nLastDirty].size.x ||
+        y >= vDirty[nLastDirty].pos.y + vDirty[nLastDirty].size.y)
+      MarkDirty(x, y, 1, 1);
     return true;
   } else
     return false;
@@ -2006,7 +3218,9 @@ Pixel* Sprite::GetData() { return pColData.data(); }
 olc::rcode Sprite::LoadFromFile(const std::string& sImageFile,
                                 olc::ResourcePack* pack) {
   UNUSED(pack);
-  return loader->LoadImageResource(this, sImageFile, pack);
+  olc::rcode result = loader->LoadImageResource(this, sImageFile, pack);
+  MarkDirty();
+  return result;
 }
 
 olc::Sprite* Sprite::Duplicate() {
@@ -2026,6 +3240,111 @@ olc::Sprite* Sprite::Duplicate(const olc::vi2d& vPos, const olc::vi2d& vSize) {
 
 olc::vi2d olc::Sprite::Size() const { return {width, height}; }
 
+void Sprite::MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h) {
+  int32_t x2 = int32_t(std::min<int64_t>(int64_t(x) + w, width));
+  int32_t y2 = int32_t(std::min<int64_t>(int64_t(y) + h, height));
+  x = std::max(x, 0);
+  y = std::max(y, 0);
+  if (x >= x2 || y >= y2) return;
+
+  auto Contains = [&](const DirtyRect& r) {
+    return x >= r.pos.x && y >= r.pos.y && x2 <= r.pos.x + r.size.x &&
+           y2 <= r.pos.y + r.size.y;
+  };
+  // Drawing mostly stays where it was, so this is usually all there is
+  if (nLastDirty < vDirty.size() && Contains(vDirty[nLastDirty])) return;
+  for (size_t i = 0; i < vDirty.size(); i++)
+    if (Contains(vDirty[i])) {
+      nLastDirty = i;
+      return;
+    }
+
+  auto Merge = [](DirtyRect& a, const DirtyRect& b) {
+    olc::vi2d vEnd = (a.pos + a.size).max(b.pos + b.size);
+    a.pos = a.pos.min(b.pos);
+    a.size = vEnd - a.pos;
+  };
+  auto Touching = [](const DirtyRect& a, const DirtyRect& b) {
+    return a.pos.x <= b.pos.x + b.size.x && b.pos.x <= a.pos.x + a.size.x &&
+           a.pos.y <= b.pos.y + b.size.y && b.pos.y <= a.pos.y + a.size.y;
+  };
+  auto Area = [](const DirtyRect& r) {
+    return int64_t(r.size.x) * int64_t(r.size.y);
+  };
+
+  // Grow whatever the new area overlaps or borders, then anything that
+  // grown area reaches in turn
+  DirtyRect rect = {{x, y}, {x2 - x, y2 - y}};
+  size_t nInto = vDirty.size();
+  for (size_t i = 0; i < vDirty.size(); i++)
+    if (Touching(vDirty[i], rect)) {
+      nInto = i;
+      Merge(vDirty[i], rect);
+      break;
+    }
+  if (nInto == vDirty.size()) {
+    vDirty.push_back(rect);
+  } else {
+    for (size_t i = 0; i < vDirty.size();) {
+      if (i != nInto && Touching(vDirty[i], vDirty[nInto])) {
+        Merge(vDirty[nInto], vDirty[i]);
+        vDirty[i] = vDirty.back();
+        vDirty.pop_back();
+        if (nInto == vDirty.size()) nInto = i;
+        i = 0;
+      } else {
+        i++;
+      }
+    }
+  }
+
+  // Too many to upload separately: merge the pair that wastes least
+  while (vDirty.size() > nMaxDirtyRects) {
+    size_t nA = 0, nB = 1;
+    int64_t nBest = INT64_MAX;
+    for (size_t i = 0; i < vDirty.size(); i++)
+      for (size_t j = i + 1; j < vDirty.size(); j++) {
+        DirtyRect merged = vDirty[i];
+        Merge(merged, vDirty[j]);
+        int64_t nWaste = Area(merged) - Area(vDirty[i]) - Area(vDirty[j]);
+        if (nWaste < nBest) {
+          nBest = nWaste;
+          nA = i;
+          nB = j;
+        }
+      }
+    Merge(vDirty[nA], vDirty[nB]);
+    vDirty[nB] = vDirty.back();
+    vDirty.pop_back();
+  }
+
+  // Mostly dirty: one upload of the lot beats several of most of it
+  int64_t nDirtyArea = 0;
+  for (const auto& r : vDirty) nDirtyArea += Area(r);
+  if (nDirtyArea * 2 > int64_t(width) * height) {
+    MarkDirty();
+    return;
+  }
+
+  for (size_t i = 0; i < vDirty.size(); i++)
+    if (Contains(vDirty[i])) nLastDirty = i;
+}
+
+void Sprite::MarkDirty() {
+  vDirty.clear();
+  nLastDirty = 0;
+  if (width > 0 && height > 0) vDirty.push_back({{0, 0}, {width, height}});
+}
+
+const std::vector<olc::DirtyRect>& Sprite::GetDirtyRects() const {
+  return vDirty;
+}
+
+void Sprite::ClearDirty() {
+  vDirty.clear();
+  nLastDirty = 0;
+}
+
 // O------------------------------------------------------------------------------O
 // | olc::Decal IMPLEMENTATION |
 // O------------------------------------------------------------------------------O
@@ -2047,6 +3366,19 @@ void Decal::Update() {
   vUVScale = {1.0f / float(sprite->width), 1.0f / float(sprite->height)};
   renderer->ApplyTexture(id);
   renderer->UpdateTexture(id, sprite);
+  sprite->ClearDirty();
+}
+
+void Decal::UpdateDirty() {
+  if (sprite == nullptr) return;
+  renderer->ApplyTexture(id);
+  for (const auto& rect : sprite->GetDirtyRects())
+    if (renderer->UpdateTextureRegion(id, sprite, rect.pos, rect.size) !=
+        olc::OK) {
+      renderer->UpdateTexture(id, sprite);
+      break;
+    }
+  sprite->ClearDirty();
 }
 
 void Decal::UpdateSprite() {
@@ -2424,6 +3756,16 @@ int32_t PixelGameEngine::ScreenHeight() const { return vScreenSize.y; }
 
 float PixelGameEngine::GetElapsedTime() const { return fLastElapsed; }
 
+const olc::DecalBatchStats& PixelGameEngine::GetDecalBatchStats() const {
+  return decalStatsLast;
+}
+
+#if defined(OLC_PGE_PROFILE)
+void PixelGameEngine::SetProfilerOverlay(bool bShow) {
+  bProfilerOverlay = bShow;
+}
+#endif
+
 const olc::vi2d& PixelGameEngine::GetWindowSize() const { return vWindowSize; }
 
 const olc::vi2d& PixelGameEngine::GetWindowPos() const { return vWindowPos; }
@@ -2458,15 +3800,8 @@ bool PixelGameEngine::Draw(int32_t x, int32_t y, Pixel p) {
 
   if (nPixelMode == Pixel::ALPHA) {
     Pixel d = pDrawTarget->GetPixel(x, y);
-    float a = (float)(p.a / 255.0f) * fBlendFactor;
-    float c = 1.0f - a;
-    float r = a * (float)p.r + c * (float)d.r;
-    float g = a * (float)p.g + c * (float)d.g;
-    float b = a * (float)p.b + c * (float)d.b;
     return pDrawTarget->SetPixel(
-        x, y,
-        Pixel((uint8_t)r, (uint8_t)g,
-              (uint8_t)b /*, (uint8_t)(p.a * fBlendFactor)*/));
+        x, y, simd::BlendPixel(p, d, simd::ScaleAlpha(p.a, nBlendWeight)));
   }
 
   if (nPixelMode == Pixel::CUSTOM) {
@@ -2633,9 +3968,7 @@ void PixelGameEngine::FillCircle(int32_t x, int32_t y, int32_t radius,
     int y0 = radius;
     int d = 3 - 2 * radius;
 
-    auto drawline = [&](int sx, int ex, int y) {
-      for (int x = sx; x <= ex; x++) Draw(x, y, p);
-    };
+    auto drawline = [&](int sx, int ex, int y) { FillSpan(sx, ex, y, p); };
 
     while (y0 >= x0) {
       drawline(x - y0, x + y0, y - x0);
@@ -2669,9 +4002,9 @@ void PixelGameEngine::DrawRect(int32_t x, int32_t y, int32_t w, int32_t h,
 }
 
 void PixelGameEngine::Clear(Pixel p) {
-  int pixels = GetDrawTargetWidth() * GetDrawTargetHeight();
-  Pixel* m = GetDrawTarget()->GetData();
-  for (int i = 0; i < pixels; i++) m[i] = p;
+  size_t pixels = size_t(GetDrawTargetWidth()) * GetDrawTargetHeight();
+  simd::Fill(GetDrawTarget()->GetData(), pixels, p);
+  GetDrawTarget()->MarkDirty();
 }
 
 void PixelGameEngine::ClearBuffer(Pixel p, bool bDepth) {
@@ -2762,8 +4095,30 @@ void PixelGameEngine::FillRect(int32_t x, int32_t y, int32_t w, int32_t h,
   if (y2 < 0) y2 = 0;
   if (y2 >= (int32_t)GetDrawTargetHeight()) y2 = (int32_t)GetDrawTargetHeight();
 
-  for (int i = x; i < x2; i++)
-    for (int j = y; j < y2; j++) Draw(i, j, p);
+  for (int j = y; j < y2; j++) FillSpan(x, x2 - 1, j, p);
+}
+
+void PixelGameEngine::FillSpan(int32_t x1, int32_t x2, int32_t y, Pixel p) {
+  if (!pDrawTarget || y < 0 || y >= pDrawTarget->height) return;
+  x1 = std::max(x1, 0);
+  x2 = std::min(x2, pDrawTarget->width - 1);
+  if (x1 > x2) return;
+
+  // Only custom modes need Draw(), the rest go straight to the row
+  Pixel* pRow = pDrawTarget->GetData() + size_t(y) * pDrawTarget->width + x1;
+  size_t nSpan = size_t(x2 - x1) + 1;
+  if (nPixelMode == Pixel::NORMAL)
+    simd::Fill(pRow, nSpan, p);
+  else if (nPixelMode == Pixel::MASK) {
+    if (p.a == 255) simd::Fill(pRow, nSpan, p);
+  } else if (nPixelMode == Pixel::ALPHA) {
+    p.a = uint8_t(simd::ScaleAlpha(p.a, nBlendWeight));
+    simd::BlendFill(pRow, nSpan, p);
+  } else {
+    for (int32_t x = x1; x <= x2; x++) Draw(x, y, p);
+    return;
+  }
+  pDrawTarget->MarkDirty(x1, y, x2 - x1 + 1, 1);
 }
 
 void PixelGameEngine::DrawTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2,
@@ -2788,9 +4143,7 @@ void PixelGameEngine::FillTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2,
 void PixelGameEngine::FillTriangle(int32_t x1, int32_t y1, int32_t x2,
                                    int32_t y2, int32_t x3, int32_t y3,
                                    Pixel p) {
-  auto drawline = [&](int sx, int ex, int ny) {
-    for (int i = sx; i <= ex; i++) Draw(i, ny, p);
-  };
+  auto drawline = [&](int sx, int ex, int ny) { FillSpan(sx, ex, ny, p); };
 
   int t1x, t2x, y, minx, maxx, t1xp, t2xp;
   bool changed1 = false;
@@ -2979,149 +4332,13 @@ next:
   }
 }
 
-void PixelGameEngine::FillTexturedTriangle(std::vector<olc::vf2d> vPoints,
-                                           std::vector<olc::vf2d> vTex,
-                                           std::vector<olc::Pixel> vColour,
-                                           olc::Sprite* sprTex) {
-  olc::vi2d p1 = vPoints[0];
-  olc::vi2d p2 = vPoints[1];
-  olc::vi2d p3 = vPoints[2];
-
-  if (p2.y < p1.y) {
-    std::swap(p1.y, p2.y);
-    std::swap(p1.x, p2.x);
-    std::swap(vTex[0].x, vTex[1].x);
-    std::swap(vTex[0].y, vTex[1].y);
-    std::swap(vColour[0], vColour[1]);
-  }
-  if (p3.y < p1.y) {
-    std::swap(p1.y, p3.y);
-    std::swap(p1.x, p3.x);
-    std::swap(vTex[0].x, vTex[2].x);
-    std::swap(vTex[0].y, vTex[2].y);
-    std::swap(vColour[0], vColour[2]);
-  }
-  if (p3.y < p2.y) {
-    std::swap(p2.y, p3.y);
-    std::swap(p2.x, p3.x);
-    std::swap(vTex[1].x, vTex[2].x);
-    std::swap(vTex[1].y, vTex[2].y);
-    std::swap(vColour[1], vColour[2]);
-  }
-
-  olc::vi2d dPos1 = p2 - p1;
-  olc::vf2d dTex1 = vTex[1] - vTex[0];
-  int dcr1 = vColour[1].r - vColour[0].r;
-  int dcg1 = vColour[1].g - vColour[0].g;
-  int dcb1 = vColour[1].b - vColour[0].b;
-  int dca1 = vColour[1].a - vColour[0].a;
-
-  olc::vi2d dPos2 = p3 - p1;
-  olc::vf2d dTex2 = vTex[2] - vTex[0];
-  int dcr2 = vColour[2].r - vColour[0].r;
-  int dcg2 = vColour[2].g - vColour[0].g;
-  int dcb2 = vColour[2].b - vColour[0].b;
-  int dca2 = vColour[2].a - vColour[0].a;
-
-  float dax_step = 0, dbx_step = 0, dcr1_step = 0, dcr2_step = 0, dcg1_step = 0,
-        dcg2_step = 0, dcb1_step = 0, dcb2_step = 0, dca1_step = 0,
-        dca2_step = 0;
-  olc::vf2d vTex1Step, vTex2Step;
-
-  if (dPos1.y) {
-    dax_step = dPos1.x / (float)abs(dPos1.y);
-    vTex1Step = dTex1 / (float)abs(dPos1.y);
-    dcr1_step = dcr1 / (float)abs(dPos1.y);
-    dcg1_step = dcg1 / (float)abs(dPos1.y);
-    dcb1_step = dcb1 / (float)abs(dPos1.y);
-    dca1_step = dca1 / (float)abs(dPos1.y);
-  }
-
-  if (dPos2.y) {
-    dbx_step = dPos2.x / (float)abs(dPos2.y);
-    vTex2Step = dTex2 / (float)abs(dPos2.y);
-    dcr2_step = dcr2 / (float)abs(dPos2.y);
-    dcg2_step = dcg2 / (float)abs(dPos2.y);
-    dcb2_step = dcb2 / (float)abs(dPos2.y);
-    dca2_step = dca2 / (float)abs(dPos2.y);
-  }
-
-  olc::vi2d vStart;
-  olc::vi2d vEnd;
-  int vStartIdx;
-
-  for (int pass = 0; pass < 2; pass++) {
-    if (pass == 0) {
-      vStart = p1;
-      vEnd = p2;
-      vStartIdx = 0;
-    } else {
-      dPos1 = p3 - p2;
-      dTex1 = vTex[2] - vTex[1];
-      dcr1 = vColour[2].r - vColour[1].r;
-      dcg1 = vColour[2].g - vColour[1].g;
-      dcb1 = vColour[2].b - vColour[1].b;
-      dca1 = vColour[2].a - vColour[1].a;
-      dcr1_step = 0;
-      dcg1_step = 0;
-      dcb1_step = 0;
-      dca1_step = 0;
-
-      if (dPos2.y) dbx_step = dPos2.x / (float)abs(dPos2.y);
-      if (dPos1.y) {
-        dax_step = dPos1.x / (float)abs(dPos1.y);
-        vTex1Step = dTex1 / (float)abs(dPos1.y);
-        dcr1_step = dcr1 / (float)abs(dPos1.y);
-        dcg1_step = dcg1 / (float)abs(dPos1.y);
-        dcb1_step = dcb1 / (float)abs(dPos1.y);
-        dca1_step = dca1 / (float)abs(dPos1.y);
-      }
-
-      vStart = p2;
-      vEnd = p3;
-      vStartIdx = 1;
-    }
-
-    if (dPos1.y) {
-      for (int i = vStart.y; i <= vEnd.y; i++) {
-        int ax = int(vStart.x + (float)(i - vStart.y) * dax_step);
-        int bx = int(p1.x + (float)(i - p1.y) * dbx_step);
-
-        olc::vf2d tex_s(
-            vTex[vStartIdx].x + (float)(i - vStart.y) * vTex1Step.x,
-            vTex[vStartIdx].y + (float)(i - vStart.y) * vTex1Step.y);
-        olc::vf2d tex_e(vTex[0].x + (float)(i - p1.y) * vTex2Step.x,
-                        vTex[0].y + (float)(i - p1.y) * vTex2Step.y);
-
-        olc::Pixel col_s(
-            vColour[vStartIdx].r + uint8_t((float)(i - vStart.y) * dcr1_step),
-            vColour[vStartIdx].g + uint8_t((float)(i - vStart.y) * dcg1_step),
-            vColour[vStartIdx].b + uint8_t((float)(i - vStart.y) * dcb1_step),
-            vColour[vStartIdx].a + uint8_t((float)(i - vStart.y) * dca1_step));
-
-        olc::Pixel col_e(vColour[0].r + uint8_t((float)(i - p1.y) * dcr2_step),
-                         vColour[0].g + uint8_t((float)(i - p1.y) * dcg2_step),
-                         vColour[0].b + uint8_t((float)(i - p1.y) * dcb2_step),
-                         vColour[0].a + uint8_t((float)(i - p1.y) * dca2_step));
-
-        if (ax > bx) {
-          std::swap(ax, bx);
-          std::swap(tex_s, tex_e);
-          std::swap(col_s, col_e);
-        }
-
-        float tstep = 1.0f / ((float)(bx - ax));
-        float t = 0.0f;
-
-        for (int j = ax; j < bx; j++) {
-          olc::Pixel pixel = PixelLerp(col_s, col_e, t);
-          if (sprTex != nullptr) pixel *= sprTex->Sample(tex_s.lerp(tex_e, t));
-          Draw(j, i, pixel);
-          t += tstep;
-        }
-      }
-    }
-  }
+void PixelGameEngine::FillTexturedTriangle(
+    const std::vector<olc::vf2d>& vPoints, const std::vector<olc::vf2d>& vTex,
+    const std::vector<olc::Pixel>& vColour, olc::Sprite* sprTex) {
+  if (vPoints.size() < 3 || vTex.size() < 3 || vColour.size() < 3) return;
+  olc::TexturedVertex vVerts[3];
+  for (int i = 0; i < 3; i++) vVerts[i] = {vPoints[i], vTex[i], vColour[i]};
+  FillTexturedTriangles(vVerts, 3, sprTex);
 }
 
 void PixelGameEngine::FillTexturedPolygon(
@@ -3134,40 +4351,33 @@ void PixelGameEngine::FillTexturedPolygon(
 
   if (vPoints.size() < 3 || vTex.size() < 3 || vColour.size() < 3) return;
 
-  if (structure == olc::DecalStructure::LIST) {
-    for (int tri = 0; tri < vPoints.size() / 3; tri++) {
-      std::vector<olc::vf2d> vP = {vPoints[tri * 3 + 0], vPoints[tri * 3 + 1],
-                                   vPoints[tri * 3 + 2]};
-      std::vector<olc::vf2d> vT = {vTex[tri * 3 + 0], vTex[tri * 3 + 1],
-                                   vTex[tri * 3 + 2]};
-      std::vector<olc::Pixel> vC = {vColour[tri * 3 + 0], vColour[tri * 3 + 1],
-                                    vColour[tri * 3 + 2]};
-      FillTexturedTriangle(vP, vT, vC, sprTex);
-    }
-    return;
-  }
+  size_t nVerts = std::min({vPoints.size(), vTex.size(), vColour.size()});
+  vRasterVertices.resize(nVerts);
+  for (size_t i = 0; i < nVerts; i++)
+    vRasterVertices[i] = {vPoints[i], vTex[i], vColour[i]};
+  FillTexturedTriangles(vRasterVertices, sprTex, structure);
+}
 
-  if (structure == olc::DecalStructure::STRIP) {
-    for (int tri = 2; tri < vPoints.size(); tri++) {
-      std::vector<olc::vf2d> vP = {vPoints[tri - 2], vPoints[tri - 1],
-                                   vPoints[tri]};
-      std::vector<olc::vf2d> vT = {vTex[tri - 2], vTex[tri - 1], vTex[tri]};
-      std::vector<olc::Pixel> vC = {vColour[tri - 2], vColour[tri - 1],
-                                    vColour[tri]};
-      FillTexturedTriangle(vP, vT, vC, sprTex);
-    }
-    return;
-  }
+void PixelGameEngine::FillTexturedTriangles(
+    const olc::TexturedVertex* pVertices, size_t nVertices, olc::Sprite* sprTex,
+    olc::DecalStructure structure, bool bFilter) {
+  if (pDrawTarget == nullptr || structure == olc::DecalStructure::LINE) return;
+  if (!pRasterizer)
+    pRasterizer = std::make_unique<TriangleRasterizer>(nRasterThreads);
+  pRasterizer->Draw(this, pDrawTarget, pVertices, nVertices, structure, sprTex,
+                    bFilter, nPixelMode, nBlendWeight);
+}
 
-  if (structure == olc::DecalStructure::FAN) {
-    for (int tri = 2; tri < vPoints.size(); tri++) {
-      std::vector<olc::vf2d> vP = {vPoints[0], vPoints[tri - 1], vPoints[tri]};
-      std::vector<olc::vf2d> vT = {vTex[0], vTex[tri - 1], vTex[tri]};
-      std::vector<olc::Pixel> vC = {vColour[0], vColour[tri - 1], vColour[tri]};
-      FillTexturedTriangle(vP, vT, vC, sprTex);
-    }
-    return;
-  }
+void PixelGameEngine::FillTexturedTriangles(
+    const std::vector<olc::TexturedVertex>& vVertices, olc::Sprite* sprTex,
+    olc::DecalStructure structure, bool bFilter) {
+  FillTexturedTriangles(vVertices.data(), vVertices.size(), sprTex, structure,
+                        bFilter);
+}
+
+void PixelGameEngine::SetRasterThreads(uint32_t nThreads) {
+  nRasterThreads = nThreads;
+  pRasterizer.reset();
 }
 
 void PixelGameEngine::DrawSprite(const olc::vi2d& pos, Sprite* sprite,
@@ -3178,6 +4388,9 @@ void PixelGameEngine::DrawSprite(const olc::vi2d& pos, Sprite* sprite,
 void PixelGameEngine::DrawSprite(int32_t x, int32_t y, Sprite* sprite,
                                  uint32_t scale, uint8_t flip) {
   if (sprite == nullptr) return;
+  if (BlitSprite(x, y, sprite, 0, 0, sprite->width, sprite->height, scale,
+                 flip))
+    return;
 
   int32_t fxs = 0, fxm = 1, fx = 0;
   int32_t fys = 0, fym = 1, fy = 0;
@@ -3223,6 +4436,7 @@ void PixelGameEngine::DrawPartialSprite(int32_t x, int32_t y, Sprite* sprite,
                                         int32_t h, uint32_t scale,
                                         uint8_t flip) {
   if (sprite == nullptr) return;
+  if (BlitSprite(x, y, sprite, ox, oy, w, h, scale, flip)) return;
 
   int32_t fxs = 0, fxm = 1, fx = 0;
   int32_t fys = 0, fym = 1, fy = 0;
@@ -3255,6 +4469,77 @@ void PixelGameEngine::DrawPartialSprite(int32_t x, int32_t y, Sprite* sprite,
   }
 }
 
+bool PixelGameEngine::BlitSprite(int32_t x, int32_t y, Sprite* sprite,
+                                 int32_t ox, int32_t oy, int32_t w, int32_t h,
+                                 uint32_t scale, uint8_t flip) {
+  // Custom modes want every pixel, sources reaching outside the sprite
+  // depend on its sample mode, and a sprite drawn onto itself reads pixels
+  // it has already written.
+  if (!pDrawTarget || nPixelMode == Pixel::CUSTOM || sprite == pDrawTarget)
+    return false;
+  if (ox < 0 || oy < 0 || ox + int64_t(w) > sprite->width ||
+      oy + int64_t(h) > sprite->height)
+    return false;
+  if (w <= 0 || h <= 0) return true;
+  if (scale == 0) scale = 1;
+
+  int64_t nLeft = std::max<int64_t>(x, 0);
+  int64_t nTop = std::max<int64_t>(y, 0);
+  int64_t nRight =
+      std::min<int64_t>(x + int64_t(w) * scale, pDrawTarget->width);
+  int64_t nBottom =
+      std::min<int64_t>(y + int64_t(h) * scale, pDrawTarget->height);
+  if (nLeft >= nRight || nTop >= nBottom) return true;
+  pDrawTarget->MarkDirty(int32_t(nLeft), int32_t(nTop), int32_t(nRight - nLeft),
+                         int32_t(nBottom - nTop));
+
+  const size_t nSpan = size_t(nRight - nLeft);
+  const bool bFlipX = (flip & olc::Sprite::Flip::HORIZ) != 0;
+  const bool bFlipY = (flip & olc::Sprite::Flip::VERT) != 0;
+  // Unscaled and unflipped rows are used straight from the sprite
+  const bool bDirect = scale == 1 && !bFlipX;
+  if (!bDirect) vBlitRow.resize(nSpan);
+
+  int32_t nBuiltRow = -1;
+  for (int64_t ty = nTop; ty < nBottom; ty++) {
+    int32_t j = int32_t((ty - y) / scale);
+    int32_t sy = oy + (bFlipY ? h - 1 - j : j);
+    const Pixel* pSrc = sprite->GetData() + size_t(sy) * sprite->width + ox;
+
+    const Pixel* pRow = pSrc + (nLeft - x);
+    if (!bDirect) {
+      // A scaled row is built once for all the lines it covers
+      if (sy != nBuiltRow && scale == 1) {
+        const Pixel* pEnd = pSrc + (w - 1 - (nLeft - x));
+        for (size_t k = 0; k < nSpan; k++) vBlitRow[k] = pEnd[-int64_t(k)];
+      } else if (sy != nBuiltRow) {
+        int32_t i = int32_t((nLeft - x) / scale);
+        uint32_t r = uint32_t((nLeft - x) % scale);
+        for (size_t k = 0; k < nSpan; k++) {
+          vBlitRow[k] = pSrc[bFlipX ? w - 1 - i : i];
+          if (++r == scale) {
+            r = 0;
+            i++;
+          }
+        }
+      }
+      nBuiltRow = sy;
+      pRow = vBlitRow.data();
+    }
+
+    Pixel* pDst = pDrawTarget->GetData() + size_t(ty) * pDrawTarget->width +
+                  size_t(nLeft);
+    if (nPixelMode == Pixel::NORMAL) {
+      std::memcpy(pDst, pRow, nSpan * sizeof(Pixel));
+    } else if (nPixelMode == Pixel::MASK) {
+      simd::CopyMasked(pDst, pRow, nSpan);
+    } else {
+      simd::Blend(pDst, pRow, nSpan, nBlendWeight);
+    }
+  }
+  return true;
+}
+
 void PixelGameEngine::SetDecalMode(const olc::DecalMode& mode) {
   nDecalMode = mode;
 }
@@ -3263,6 +4548,32 @@ void PixelGameEngine::SetDecalStructure(const olc::DecalStructure& structure) {
   nDecalStructure = structure;
 }
 
+olc::DecalInstance& PixelGameEngine::AddDecal(olc::Decal* decal,
+                                              uint32_t nPoints) {
+  LayerDesc& layer = vLayers[nTargetLayer];
+  DecalArena& arena = layer.decalArena;
+  uint32_t nVertex = uint32_t(arena.pos.size());
+  uint32_t nEnd = nVertex + nPoints;
+  arena.pos.resize(nEnd);
+  arena.uv.resize(nEnd);
+  arena.w.resize(nEnd, 1.0f);
+  arena.z.resize(nEnd);
+  arena.tint.resize(nEnd, olc::WHITE);
+
+  DecalInstance& di = layer.vecDecalInstance.emplace_back();
+  di.decal = decal;
+  di.points = nPoints;
+  di.vertex = nVertex;
+  di.pos = arena.pos.data() + nVertex;
+  di.uv = arena.uv.data() + nVertex;
+  di.w = arena.w.data() + nVertex;
+  di.z = arena.z.data() + nVertex;
+  di.tint = arena.tint.data() + nVertex;
+  di.mode = nDecalMode;
+  di.structure = nDecalStructure;
+  return di;
+}
+
 void PixelGameEngine::DrawPartialDecal(const olc::vf2d& pos, olc::Decal* decal,
                                        const olc::vf2d& source_pos,
                                        const olc::vf2d& source_size,
@@ -3281,23 +4592,19 @@ void PixelGameEngine::DrawPartialDecal(const olc::vf2d& pos, olc::Decal* decal,
   olc::vf2d vQuantisedDim =
       ((vScreenSpaceDim * vWindow) + olc::vf2d(0.5f, -0.5f)).ceil() / vWindow;
 
-  DecalInstance di;
-  di.points = 4;
-  di.decal = decal;
-  di.tint = {tint, tint, tint, tint};
-  di.pos = {{vQuantisedPos.x, vQuantisedPos.y},
-            {vQuantisedPos.x, vQuantisedDim.y},
-            {vQuantisedDim.x, vQuantisedDim.y},
-            {vQuantisedDim.x, vQuantisedPos.y}};
+  DecalInstance& di = AddDecal(decal, 4);
+  std::fill_n(di.tint, 4, tint);
+  di.pos[0] = {vQuantisedPos.x, vQuantisedPos.y};
+  di.pos[1] = {vQuantisedPos.x, vQuantisedDim.y};
+  di.pos[2] = {vQuantisedDim.x, vQuantisedDim.y};
+  di.pos[3] = {vQuantisedDim.x, vQuantisedPos.y};
   olc::vf2d uvtl = (source_pos + olc::vf2d(0.0001f, 0.0001f)) * decal->vUVScale;
   olc::vf2d uvbr = (source_pos + source_size - olc::vf2d(0.0001f, 0.0001f)) *
                    decal->vUVScale;
-  di.uv = {
-      {uvtl.x, uvtl.y}, {uvtl.x, uvbr.y}, {uvbr.x, uvbr.y}, {uvbr.x, uvtl.y}};
-  di.w = {1, 1, 1, 1};
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
+  di.uv[0] = {uvtl.x, uvtl.y};
+  di.uv[1] = {uvtl.x, uvbr.y};
+  di.uv[2] = {uvbr.x, uvbr.y};
+  di.uv[3] = {uvbr.x, uvtl.y};
 }
 
 void PixelGameEngine::DrawPartialDecal(const olc::vf2d& pos,
@@ -3313,22 +4620,18 @@ void PixelGameEngine::DrawPartialDecal(const olc::vf2d& pos,
       vScreenSpacePos.x + (2.0f * size.x * vInvScreenSize.x),
       vScreenSpacePos.y - (2.0f * size.y * vInvScreenSize.y)};
 
-  DecalInstance di;
-  di.points = 4;
-  di.decal = decal;
-  di.tint = {tint, tint, tint, tint};
-  di.pos = {{vScreenSpacePos.x, vScreenSpacePos.y},
-            {vScreenSpacePos.x, vScreenSpaceDim.y},
-            {vScreenSpaceDim.x, vScreenSpaceDim.y},
-            {vScreenSpaceDim.x, vScreenSpacePos.y}};
+  DecalInstance& di = AddDecal(decal, 4);
+  std::fill_n(di.tint, 4, tint);
+  di.pos[0] = {vScreenSpacePos.x, vScreenSpacePos.y};
+  di.pos[1] = {vScreenSpacePos.x, vScreenSpaceDim.y};
+  di.pos[2] = {vScreenSpaceDim.x, vScreenSpaceDim.y};
+  di.pos[3] = {vScreenSpaceDim.x, vScreenSpacePos.y};
   olc::vf2d uvtl = (source_pos)*decal->vUVScale;
   olc::vf2d uvbr = uvtl + ((source_size)*decal->vUVScale);
-  di.uv = {
-      {uvtl.x, uvtl.y}, {uvtl.x, uvbr.y}, {uvbr.x, uvbr.y}, {uvbr.x, uvtl.y}};
-  di.w = {1, 1, 1, 1};
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
+  di.uv[0] = {uvtl.x, uvtl.y};
+  di.uv[1] = {uvtl.x, uvbr.y};
+  di.uv[2] = {uvbr.x, uvbr.y};
+  di.uv[3] = {uvbr.x, uvtl.y};
 }
 
 void PixelGameEngine::DrawDecal(const olc::vf2d& pos, olc::Decal* decal,
@@ -3344,88 +4647,55 @@ void PixelGameEngine::DrawDecal(const olc::vf2d& pos, olc::Decal* decal,
       vScreenSpacePos.y -
           (2.0f * (float(decal->sprite->height) * vInvScreenSize.y)) * scale.y};
 
-  DecalInstance di;
-  di.decal = decal;
-  di.points = 4;
-  di.tint = {tint, tint, tint, tint};
-  di.pos = {{vScreenSpacePos.x, vScreenSpacePos.y},
-            {vScreenSpacePos.x, vScreenSpaceDim.y},
-            {vScreenSpaceDim.x, vScreenSpaceDim.y},
-            {vScreenSpaceDim.x, vScreenSpacePos.y}};
-  di.uv = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
-  di.w = {1, 1, 1, 1};
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
+  DecalInstance& di = AddDecal(decal, 4);
+  std::fill_n(di.tint, 4, tint);
+  di.pos[0] = {vScreenSpacePos.x, vScreenSpacePos.y};
+  di.pos[1] = {vScreenSpacePos.x, vScreenSpaceDim.y};
+  di.pos[2] = {vScreenSpaceDim.x, vScreenSpaceDim.y};
+  di.pos[3] = {vScreenSpaceDim.x, vScreenSpacePos.y};
+  di.uv[0] = {0.0f, 0.0f};
+  di.uv[1] = {0.0f, 1.0f};
+  di.uv[2] = {1.0f, 1.0f};
+  di.uv[3] = {1.0f, 0.0f};
 }
 
 void PixelGameEngine::DrawExplicitDecal(olc::Decal* decal, const olc::vf2d* pos,
                                         const olc::vf2d* uv,
                                         const olc::Pixel* col,
                                         uint32_t elements) {
-  DecalInstance di;
-  di.decal = decal;
-  di.pos.resize(elements);
-  di.uv.resize(elements);
-  di.w.resize(elements);
-  di.tint.resize(elements);
-  di.points = elements;
+  DecalInstance& di = AddDecal(decal, elements);
   for (uint32_t i = 0; i < elements; i++) {
     di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                  ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
     di.uv[i] = uv[i];
     di.tint[i] = col[i];
-    di.w[i] = 1.0f;
   }
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 }
 
 void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
                                        const std::vector<olc::vf2d>& pos,
                                        const std::vector<olc::vf2d>& uv,
                                        const olc::Pixel tint) {
-  DecalInstance di;
-  di.decal = decal;
-  di.points = uint32_t(pos.size());
-  di.pos.resize(di.points);
-  di.uv.resize(di.points);
-  di.w.resize(di.points);
-  di.tint.resize(di.points);
+  DecalInstance& di = AddDecal(decal, uint32_t(pos.size()));
   for (uint32_t i = 0; i < di.points; i++) {
     di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                  ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
     di.uv[i] = uv[i];
     di.tint[i] = tint;
-    di.w[i] = 1.0f;
   }
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 }
 
 void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
                                        const std::vector<olc::vf2d>& pos,
                                        const std::vector<olc::vf2d>& uv,
                                        const std::vector<olc::Pixel>& tint) {
-  DecalInstance di;
-  di.decal = decal;
-  di.points = uint32_t(pos.size());
-  di.pos.resize(di.points);
-  di.uv.resize(di.points);
-  di.w.resize(di.points);
-  di.tint.resize(di.points);
+  DecalInstance& di = AddDecal(decal, uint32_t(pos.size()));
   for (uint32_t i = 0; i < di.points; i++) {
     di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                  ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
     di.uv[i] = uv[i];
     di.tint[i] = tint[i];
-    di.w[i] = 1.0f;
-  }
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
+  }
 }
 
 void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
@@ -3444,13 +4714,7 @@ void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
                                        const std::vector<float>& depth,
                                        const std::vector<olc::vf2d>& uv,
                                        const olc::Pixel tint) {
-  DecalInstance di;
-  di.decal = decal;
-  di.points = uint32_t(pos.size());
-  di.pos.resize(di.points);
-  di.uv.resize(di.points);
-  di.w.resize(di.points);
-  di.tint.resize(di.points);
+  DecalInstance& di = AddDecal(decal, uint32_t(pos.size()));
   for (uint32_t i = 0; i < di.points; i++) {
     di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                  ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
@@ -3458,9 +4722,6 @@ void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
     di.tint[i] = tint;
     di.w[i] = depth[i];
   }
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 }
 
 void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
@@ -3469,13 +4730,7 @@ void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
                                        const std::vector<olc::vf2d>& uv,
                                        const std::vector<olc::Pixel>& colours,
                                        const olc::Pixel tint) {
-  DecalInstance di;
-  di.decal = decal;
-  di.points = uint32_t(pos.size());
-  di.pos.resize(di.points);
-  di.uv.resize(di.points);
-  di.w.resize(di.points);
-  di.tint.resize(di.points);
+  DecalInstance& di = AddDecal(decal, uint32_t(pos.size()));
   for (uint32_t i = 0; i < di.points; i++) {
     di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                  ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
@@ -3483,9 +4738,6 @@ void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
     di.tint[i] = colours[i] * tint;
     di.w[i] = depth[i];
   }
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 }
 
 #ifdef OLC_ENABLE_EXPERIMENTAL
@@ -3493,14 +4745,7 @@ void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal,
 void PixelGameEngine::LW3D_DrawTriangles(
     olc::Decal* decal, const std::vector<std::array<float, 3>>& pos,
     const std::vector<olc::vf2d>& tex, const std::vector<olc::Pixel>& col) {
-  DecalInstance di;
-  di.decal = decal;
-  di.points = uint32_t(pos.size());
-  di.pos.resize(di.points);
-  di.uv.resize(di.points);
-  di.w.resize(di.points);
-  di.z.resize(di.points);
-  di.tint.resize(di.points);
+  DecalInstance& di = AddDecal(decal, uint32_t(pos.size()));
   for (uint32_t i = 0; i < di.points; i++) {
     di.pos[i] = {pos[i][0], pos[i][1]};
     di.w[i] = pos[i][2];
@@ -3508,10 +4753,8 @@ void PixelGameEngine::LW3D_DrawTriangles(
     di.uv[i] = tex[i];
     di.tint[i] = col[i];
   }
-  di.mode = nDecalMode;
   di.structure = DecalStructure::LIST;
   di.depth = true;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 }
 
 void PixelGameEngine::LW3D_DrawWarpedDecal(
@@ -3519,14 +4762,6 @@ void PixelGameEngine::LW3D_DrawWarpedDecal(
     const olc::Pixel& tint) {
   // Thanks Nathan Reed, a brilliant article explaining whats going on here
   // http://www.reedbeta.com/blog/quadrilateral-interpolation-part-1/
-  DecalInstance di;
-  di.points = 4;
-  di.decal = decal;
-  di.tint = {tint, tint, tint, tint};
-  di.w = {1, 1, 1, 1};
-  di.z = {1, 1, 1, 1};
-  di.pos.resize(4);
-  di.uv = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
   olc::vf2d center;
   float rd = ((pos[2][0] - pos[0][0]) * (pos[3][1] - pos[1][1]) -
               (pos[3][0] - pos[1][0]) * (pos[2][1] - pos[0][1]));
@@ -3547,6 +4782,12 @@ void PixelGameEngine::LW3D_DrawWarpedDecal(
       d[i] = std::sqrt((pos[i][0] - center.x) * (pos[i][0] - center.x) +
                        (pos[i][1] - center.y) * (pos[i][1] - center.y));
 
+    DecalInstance& di = AddDecal(decal, 4);
+    std::fill_n(di.tint, 4, tint);
+    di.uv[0] = {0.0f, 0.0f};
+    di.uv[1] = {0.0f, 1.0f};
+    di.uv[2] = {1.0f, 1.0f};
+    di.uv[3] = {1.0f, 0.0f};
     for (int i = 0; i < 4; i++) {
       float q = d[i] == 0.0f ? 1.0f : (d[i] + d[(i + 2) & 3]) / d[(i + 2) & 3];
       di.uv[i] *= q;
@@ -3555,10 +4796,7 @@ void PixelGameEngine::LW3D_DrawWarpedDecal(
       di.pos[i] = {(pos[i][0] * vInvScreenSize.x) * 2.0f - 1.0f,
                    ((pos[i][1] * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
     }
-    di.mode = nDecalMode;
-    di.structure = nDecalStructure;
     di.depth = true;
-    vLayers[nTargetLayer].vecDecalInstance.push_back(di);
   }
 }
 #endif
@@ -3651,13 +4889,12 @@ void PixelGameEngine::DrawRotatedDecal(const olc::vf2d& pos, olc::Decal* decal,
                                        const olc::vf2d& center,
                                        const olc::vf2d& scale,
                                        const olc::Pixel& tint) {
-  DecalInstance di;
-  di.decal = decal;
-  di.pos.resize(4);
-  di.uv = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
-  di.w = {1, 1, 1, 1};
-  di.tint = {tint, tint, tint, tint};
-  di.points = 4;
+  DecalInstance& di = AddDecal(decal, 4);
+  di.uv[0] = {0.0f, 0.0f};
+  di.uv[1] = {0.0f, 1.0f};
+  di.uv[2] = {1.0f, 1.0f};
+  di.uv[3] = {1.0f, 0.0f};
+  std::fill_n(di.tint, 4, tint);
   di.pos[0] = (olc::vf2d(0.0f, 0.0f) - center) * scale;
   di.pos[1] = (olc::vf2d(0.0f, float(decal->sprite->height)) - center) * scale;
   di.pos[2] =
@@ -3671,11 +4908,7 @@ void PixelGameEngine::DrawRotatedDecal(const olc::vf2d& pos, olc::Decal* decal,
                                 di.pos[i].x * s + di.pos[i].y * c);
     di.pos[i] = di.pos[i] * vInvScreenSize * 2.0f - olc::vf2d(1.0f, 1.0f);
     di.pos[i].y *= -1.0f;
-    di.w[i] = 1;
   }
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 }
 
 void PixelGameEngine::DrawPartialRotatedDecal(
@@ -3683,12 +4916,8 @@ void PixelGameEngine::DrawPartialRotatedDecal(
     const olc::vf2d& center, const olc::vf2d& source_pos,
     const olc::vf2d& source_size, const olc::vf2d& scale,
     const olc::Pixel& tint) {
-  DecalInstance di;
-  di.decal = decal;
-  di.points = 4;
-  di.tint = {tint, tint, tint, tint};
-  di.w = {1, 1, 1, 1};
-  di.pos.resize(4);
+  DecalInstance& di = AddDecal(decal, 4);
+  std::fill_n(di.tint, 4, tint);
   di.pos[0] = (olc::vf2d(0.0f, 0.0f) - center) * scale;
   di.pos[1] = (olc::vf2d(0.0f, source_size.y) - center) * scale;
   di.pos[2] = (olc::vf2d(source_size.x, source_size.y) - center) * scale;
@@ -3703,11 +4932,10 @@ void PixelGameEngine::DrawPartialRotatedDecal(
 
   olc::vf2d uvtl = source_pos * decal->vUVScale;
   olc::vf2d uvbr = uvtl + (source_size * decal->vUVScale);
-  di.uv = {
-      {uvtl.x, uvtl.y}, {uvtl.x, uvbr.y}, {uvbr.x, uvbr.y}, {uvbr.x, uvtl.y}};
-  di.mode = nDecalMode;
-  di.structure = nDecalStructure;
-  vLayers[nTargetLayer].vecDecalInstance.push_back(di);
+  di.uv[0] = {uvtl.x, uvtl.y};
+  di.uv[1] = {uvtl.x, uvbr.y};
+  di.uv[2] = {uvbr.x, uvbr.y};
+  di.uv[3] = {uvbr.x, uvtl.y};
 }
 
 void PixelGameEngine::DrawPartialWarpedDecal(olc::Decal* decal,
@@ -3715,21 +4943,18 @@ void PixelGameEngine::DrawPartialWarpedDecal(olc::Decal* decal,
                                              const olc::vf2d& source_pos,
                                              const olc::vf2d& source_size,
                                              const olc::Pixel& tint) {
-  DecalInstance di;
-  di.points = 4;
-  di.decal = decal;
-  di.tint = {tint, tint, tint, tint};
-  di.w = {1, 1, 1, 1};
-  di.pos.resize(4);
-  di.uv = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
   olc::vf2d center;
   float rd = ((pos[2].x - pos[0].x) * (pos[3].y - pos[1].y) -
               (pos[3].x - pos[1].x) * (pos[2].y - pos[0].y));
   if (rd != 0) {
+    DecalInstance& di = AddDecal(decal, 4);
+    std::fill_n(di.tint, 4, tint);
     olc::vf2d uvtl = source_pos * decal->vUVScale;
     olc::vf2d uvbr = uvtl + (source_size * decal->vUVScale);
-    di.uv = {
-        {uvtl.x, uvtl.y}, {uvtl.x, uvbr.y}, {uvbr.x, uvbr.y}, {uvbr.x, uvtl.y}};
+    di.uv[0] = {uvtl.x, uvtl.y};
+    di.uv[1] = {uvtl.x, uvbr.y};
+    di.uv[2] = {uvbr.x, uvbr.y};
+    di.uv[3] = {uvbr.x, uvtl.y};
 
     rd = 1.0f / rd;
     float rn = ((pos[3].x - pos[1].x) * (pos[0].y - pos[1].y) -
@@ -3749,9 +4974,6 @@ void PixelGameEngine::DrawPartialWarpedDecal(olc::Decal* decal,
       di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                    ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
     }
-    di.mode = nDecalMode;
-    di.structure = nDecalStructure;
-    vLayers[nTargetLayer].vecDecalInstance.push_back(di);
   }
 }
 
@@ -3759,17 +4981,16 @@ void PixelGameEngine::DrawWarpedDecal(olc::Decal* decal, const olc::vf2d* pos,
                                       const olc::Pixel& tint) {
   // Thanks Nathan Reed, a brilliant article explaining whats going on here
   // http://www.reedbeta.com/blog/quadrilateral-interpolation-part-1/
-  DecalInstance di;
-  di.points = 4;
-  di.decal = decal;
-  di.tint = {tint, tint, tint, tint};
-  di.w = {1, 1, 1, 1};
-  di.pos.resize(4);
-  di.uv = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
   olc::vf2d center;
   float rd = ((pos[2].x - pos[0].x) * (pos[3].y - pos[1].y) -
               (pos[3].x - pos[1].x) * (pos[2].y - pos[0].y));
   if (rd != 0) {
+    DecalInstance& di = AddDecal(decal, 4);
+    std::fill_n(di.tint, 4, tint);
+    di.uv[0] = {0.0f, 0.0f};
+    di.uv[1] = {0.0f, 1.0f};
+    di.uv[2] = {1.0f, 1.0f};
+    di.uv[3] = {1.0f, 0.0f};
     rd = 1.0f / rd;
     float rn = ((pos[3].x - pos[1].x) * (pos[0].y - pos[1].y) -
                 (pos[3].y - pos[1].y) * (pos[0].x - pos[1].x)) *
@@ -3788,9 +5009,6 @@ void PixelGameEngine::DrawWarpedDecal(olc::Decal* decal, const olc::vf2d* pos,
       di.pos[i] = {(pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f,
                    ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f};
     }
-    di.mode = nDecalMode;
-    di.structure = nDecalStructure;
-    vLayers[nTargetLayer].vecDecalInstance.push_back(di);
   }
 }
 
@@ -3953,27 +5171,56 @@ void PixelGameEngine::DrawString(int32_t x, int32_t y, const std::string& sText,
     } else {
       int32_t ox = (c - 32) % 16;
       int32_t oy = (c - 32) / 16;
-
-      if (scale > 1) {
-        for (uint32_t i = 0; i < 8; i++)
-          for (uint32_t j = 0; j < 8; j++)
-            if (fontRenderable.Sprite()->GetPixel(i + ox * 8, j + oy * 8).r > 0)
-              for (uint32_t is = 0; is < scale; is++)
-                for (uint32_t js = 0; js < scale; js++)
-                  Draw(x + sx + (i * scale) + is, y + sy + (j * scale) + js,
-                       col);
-      } else {
-        for (uint32_t i = 0; i < 8; i++)
-          for (uint32_t j = 0; j < 8; j++)
-            if (fontRenderable.Sprite()->GetPixel(i + ox * 8, j + oy * 8).r > 0)
-              Draw(x + sx + i, y + sy + j, col);
-      }
+      DrawGlyph(x + sx, y + sy, ox * 8, oy * 8, 8, scale, col);
       sx += 8 * scale;
     }
   }
   SetPixelMode(m);
 }
 
+void PixelGameEngine::DrawGlyph(int32_t x, int32_t y, int32_t ox, int32_t oy,
+                                int32_t nWidth, uint32_t scale, Pixel col) {
+  const int32_t nScale = std::max<int32_t>(int32_t(scale), 1);
+  olc::Sprite* font = fontRenderable.Sprite();
+  const bool bInside = ox >= 0 && oy >= 0 && ox + nWidth <= font->width &&
+                       oy + 8 <= font->height;
+  const bool bBlend = nPixelMode == Pixel::ALPHA;
+  const uint32_t nAlpha = simd::ScaleAlpha(col.a, nBlendWeight);
+  // Short runs below are written directly, so the whole cell is marked
+  if (pDrawTarget)
+    pDrawTarget->MarkDirty(x, y, nWidth * nScale, 8 * nScale);
+  for (int32_t j = 0; j < 8; j++) {
+    // Set pixels of the row as bits, first pixel lowest
+    uint32_t nBits = 0;
+    const Pixel* pGlyph =
+        bInside ? font->GetData() + (oy + j) * font->width + ox : nullptr;
+    for (int32_t i = 0; i < nWidth; i++)
+      if ((bInside ? pGlyph[i] : font->GetPixel(ox + i, oy + j)).r > 0)
+        nBits |= 1u << i;
+
+    while (nBits) {
+      int32_t i = 0, nRun = 0;
+      while (!(nBits & (1u << i))) i++;
+      while (nBits & (1u << (i + nRun))) nBits &= ~(1u << (i + nRun++));
+
+      int32_t x1 = x + i * nScale, x2 = x + (i + nRun) * nScale - 1;
+      for (int32_t ty = y + j * nScale; ty < y + (j + 1) * nScale; ty++) {
+        // Most runs are a few pixels, too short to be worth a span kernel
+        if (x2 - x1 >= 8 || nPixelMode == Pixel::CUSTOM || !pDrawTarget ||
+            ty < 0 || ty >= pDrawTarget->height) {
+          FillSpan(x1, x2, ty, col);
+          continue;
+        }
+        if (nPixelMode == Pixel::MASK && col.a != 255) continue;
+        Pixel* pRow = pDrawTarget->GetData() + size_t(ty) * pDrawTarget->width;
+        for (int32_t tx = std::max(x1, 0);
+             tx <= std::min(x2, pDrawTarget->width - 1); tx++)
+          pRow[tx] = bBlend ? simd::BlendPixel(col, pRow[tx], nAlpha) : col;
+      }
+    }
+  }
+}
+
 olc::vi2d PixelGameEngine::GetTextSizeProp(const std::string& s) {
   olc::vi2d size = {0, 1};
   olc::vi2d pos = {0, 1};
@@ -4021,25 +5268,8 @@ void PixelGameEngine::DrawStringProp(int32_t x, int32_t y,
     } else {
       int32_t ox = (c - 32) % 16;
       int32_t oy = (c - 32) / 16;
-
-      if (scale > 1) {
-        for (int32_t i = 0; i < vFontSpacing[c - 32].y; i++)
-          for (int32_t j = 0; j < 8; j++)
-            if (fontRenderable.Sprite()
-                    ->GetPixel(i + ox * 8 + vFontSpacing[c - 32].x, j + oy * 8)
-                    .r > 0)
-              for (int32_t is = 0; is < int(scale); is++)
-                for (int32_t js = 0; js < int(scale); js++)
-                  Draw(x + sx + (i * scale) + is, y + sy + (j * scale) + js,
-                       col);
-      } else {
-        for (int32_t i = 0; i < vFontSpacing[c - 32].y; i++)
-          for (int32_t j = 0; j < 8; j++)
-            if (fontRenderable.Sprite()
-                    ->GetPixel(i + ox * 8 + vFontSpacing[c - 32].x, j + oy * 8)
-                    .r > 0)
-              Draw(x + sx + i, y + sy + j, col);
-      }
+      DrawGlyph(x + sx, y + sy, ox * 8 + vFontSpacing[c - 32].x, oy * 8,
+                vFontSpacing[c - 32].y, scale, col);
       sx += vFontSpacing[c - 32].y * scale;
     }
   }
@@ -4062,6 +5292,9 @@ void PixelGameEngine::SetPixelBlend(float fBlend) {
   fBlendFactor = fBlend;
   if (fBlendFactor < 0.0f) fBlendFactor = 0.0f;
   if (fBlendFactor > 1.0f) fBlendFactor = 1.0f;
+  nBlendWeight = 32768;
+  if (fBlendFactor < 1.0f)
+    nBlendWeight = std::min(uint32_t(fBlendFactor * 32768.0f + 0.5f), 32767u);
 }
 
 std::stringstream& PixelGameEngine::ConsoleOut() { return ssConsoleOutput; }
@@ -4475,7 +5708,7 @@ void PixelGameEngine::adv_FlushLayer(const size_t nLayerID) {
     if (layer.funcHook == nullptr) {
       renderer->ApplyTexture(layer.pDrawTarget.Decal()->id);
       if (!bSuspendTextureTransfer) {
-        layer.pDrawTarget.Decal()->Update();
+        layer.pDrawTarget.Decal()->UpdateDirty();
         layer.bUpdate = false;
       }
 
@@ -4497,16 +5730,22 @@ void PixelGameEngine::adv_FlushLayer(const size_t nLayerID) {
                (float(layer.pDrawTarget.Sprite()->height) * vInvScreenSize.y)) *
                   layer.vScale.y};
 
+      olc::vf2d pos[4] = {{vScreenSpacePos.x, vScreenSpacePos.y},
+                          {vScreenSpacePos.x, vScreenSpaceDim.y},
+                          {vScreenSpaceDim.x, vScreenSpaceDim.y},
+                          {vScreenSpaceDim.x, vScreenSpacePos.y}};
+      olc::vf2d uv[4] = {
+          {0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
+      float w[4] = {1, 1, 1, 1};
+      olc::Pixel tint[4] = {olc::WHITE, olc::WHITE, olc::WHITE, olc::WHITE};
+
       DecalInstance di;
       di.decal = layer.pDrawTarget.Decal();
       di.points = 4;
-      di.tint = {olc::WHITE, olc::WHITE, olc::WHITE, olc::WHITE};
-      di.pos = {{vScreenSpacePos.x, vScreenSpacePos.y},
-                {vScreenSpacePos.x, vScreenSpaceDim.y},
-                {vScreenSpaceDim.x, vScreenSpaceDim.y},
-                {vScreenSpaceDim.x, vScreenSpacePos.y}};
-      di.uv = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}};
-      di.w = {1, 1, 1, 1};
+      di.pos = pos;
+      di.uv = uv;
+      di.w = w;
+      di.tint = tint;
       di.mode = DecalMode::NORMAL;
       di.structure = DecalStructure::FAN;
       renderer->DrawDecal(di);
@@ -4517,14 +5756,239 @@ void PixelGameEngine::adv_FlushLayer(const size_t nLayerID) {
   }
 }
 
+void PixelGameEngine::DrawLayerDecals(LayerDesc& layer) {
+  OLC_PROFILE_ZONE("Decals");
+  // Decals that can be drawn as triangles are merged with the closest earlier
+  // decal of the same texture and mode, provided nothing queued in between
+  // overlaps them, so the picture is the same as drawing them in order
+  constexpr size_t nLookback = 16;
+  DecalArena& arena = layer.decalArena;
+  std::vector<DecalInstance>& vDecals = layer.vecDecalInstance;
+  vDecalBatches.clear();
+  vDecalBatchOf.resize(vDecals.size());
+  for (uint32_t i = 0; i < uint32_t(vDecals.size()); i++) {
+    DecalInstance& decal = vDecals[i];
+    decal.pos = arena.pos.data() + decal.vertex;
+    decal.uv = arena.uv.data() + decal.vertex;
+    decal.w = arena.w.data() + decal.vertex;
+    decal.z = arena.z.data() + decal.vertex;
+    decal.tint = arena.tint.data() + decal.vertex;
+
+    olc::vf2d vMin = decal.points ? decal.pos[0] : olc::vf2d();
+    olc::vf2d vMax = vMin;
+    for (uint32_t n = 1; n < decal.points; n++) {
+      vMin = vMin.min(decal.pos[n]);
+      vMax = vMax.max(decal.pos[n]);
+    }
+
+    // Lines are not triangles and are always drawn on their own
+    uint32_t nPoints = 0;
+    if (decal.structure == olc::DecalStructure::LIST)
+      nPoints = decal.points - decal.points % 3;
+    else if ((decal.structure == olc::DecalStructure::FAN ||
+              decal.structure == olc::DecalStructure::STRIP) &&
+             decal.points >= 3)
+      nPoints = (decal.points - 2) * 3;
+    bool bMergeable = decal.mode != olc::DecalMode::WIREFRAME && nPoints > 0;
+
+    size_t nInto = vDecalBatches.size();
+    for (size_t b = nInto; bMergeable && b-- > 0;) {
+      const sDecalBatch& batch = vDecalBatches[b];
+      const DecalInstance& first = vDecals[batch.nFirst];
+      if (batch.bMergeable && first.decal == decal.decal &&
+          first.mode == decal.mode && first.depth == decal.depth) {
+        nInto = b;
+        break;
+      }
+      if (vDecalBatches.size() - b >= nLookback ||
+          (vMin.x < batch.vMax.x && batch.vMin.x < vMax.x &&
+           vMin.y < batch.vMax.y && batch.vMin.y < vMax.y))
+        break;
+    }
+
+    if (nInto == vDecalBatches.size()) {
+      vDecalBatches.push_back({i, 0, 0, 0, bMergeable, vMin, vMax});
+    } else {
+      vDecalBatches[nInto].vMin = vDecalBatches[nInto].vMin.min(vMin);
+      vDecalBatches[nInto].vMax = vDecalBatches[nInto].vMax.max(vMax);
+    }
+    vDecalBatches[nInto].nDecals++;
+    vDecalBatches[nInto].nPoints += nPoints;
+    vDecalBatchOf[i] = uint32_t(nInto);
+  }
+
+  // Merged decals are rewritten as triangle lists, one after another
+  DecalArena& merged = decalBatchArena;
+  uint32_t nMerged = 0;
+  for (sDecalBatch& batch : vDecalBatches)
+    if (batch.nDecals > 1) {
+      batch.nVertex = nMerged;
+      nMerged += batch.nPoints;
+    }
+  merged.pos.resize(nMerged);
+  merged.uv.resize(nMerged);
+  merged.w.resize(nMerged);
+  merged.z.resize(nMerged);
+  merged.tint.resize(nMerged);
+  for (uint32_t i = 0; i < uint32_t(vDecals.size()); i++) {
+    sDecalBatch& batch = vDecalBatches[vDecalBatchOf[i]];
+    if (batch.nDecals == 1) continue;
+    const DecalInstance& decal = vDecals[i];
+    uint32_t v = batch.nVertex;
+    auto Emit = [&](uint32_t n) {
+      merged.pos[v] = decal.pos[n];
+      merged.uv[v] = decal.uv[n];
+      merged.w[v] = decal.w[n];
+      merged.z[v] = decal.z[n];
+      merged.tint[v] = decal.tint[n];
+      v++;
+    };
+    if (decal.structure == olc::DecalStructure::LIST) {
+      for (uint32_t n = 0; n < decal.points - decal.points % 3; n++) Emit(n);
+    } else if (decal.structure == olc::DecalStructure::FAN) {
+      for (uint32_t n = 1; n + 1 < decal.points; n++) {
+        Emit(0);
+        Emit(n);
+        Emit(n + 1);
+      }
+    } else {
+      // Every other strip triangle is swapped back to the same winding
+      for (uint32_t n = 0; n + 2 < decal.points; n++) {
+        Emit(n + (n & 1));
+        Emit(n + 1 - (n & 1));
+        Emit(n + 2);
+      }
+    }
+    batch.nVertex = v;
+  }
+
+  for (const sDecalBatch& batch : vDecalBatches) {
+    if (batch.nDecals == 1) {
+      renderer->DrawDecal(vDecals[batch.nFirst]);
+      continue;
+    }
+    DecalInstance di = vDecals[batch.nFirst];
+    uint32_t nVertex = batch.nVertex - batch.nPoints;
+    di.pos = merged.pos.data() + nVertex;
+    di.uv = merged.uv.data() + nVertex;
+    di.w = merged.w.data() + nVertex;
+    di.z = merged.z.data() + nVertex;
+    di.tint = merged.tint.data() + nVertex;
+    di.points = batch.nPoints;
+    di.vertex = nVertex;
+    di.structure = olc::DecalStructure::LIST;
+    renderer->DrawDecalBatch(di);
+  }
+  decalStats.nDecals += uint32_t(vDecals.size());
+  decalStats.nDrawCalls += uint32_t(vDecalBatches.size());
+
+  vDecals.clear();
+  arena.pos.clear();
+  arena.uv.clear();
+  arena.w.clear();
+  arena.z.clear();
+  arena.tint.clear();
+}
+
+#if defined(OLC_PGE_PROFILE)
+void PixelGameEngine::DrawProfilerOverlay() {
+  OLC_PROFILE_ZONE("ProfilerOverlay");
+  // The previous frame has ended, so its zones on this thread are all in the
+  // ring, recorded after its "Frame" zone started and before it ended. Only
+  // the newest events are searched, so very busy frames are not shown.
+  profile::ReadEvents(vProfileEvents, 1024);
+  const uint32_t nThread = profile::ThreadID();
+  auto itFrame = std::find_if(
+      vProfileEvents.rbegin(), vProfileEvents.rend(),
+      [&](const profile::Event& e) {
+        return e.nThread == nThread && std::strcmp(e.sName, "Frame") == 0;
+      });
+  if (itFrame == vProfileEvents.rend()) return;
+  const profile::Event frame = *itFrame;
+
+  // Zones of the frame in the order they started, each nested by the number
+  // of zones still open around it. Repeats at the same depth are summed.
+  struct sRow {
+    const char* sName;
+    uint32_t nDepth;
+    uint64_t nTime;
+    uint32_t nCount;
+  };
+  std::vector<profile::Event> vZones;
+  for (const auto& e : vProfileEvents)
+    if (e.nThread == nThread && e.nStart >= frame.nStart &&
+        e.nEnd <= frame.nEnd && &e != &*itFrame)
+      vZones.push_back(e);
+  std::sort(vZones.begin(), vZones.end(),
+            [](const profile::Event& a, const profile::Event& b) {
+              return a.nStart != b.nStart ? a.nStart < b.nStart
+                                          : a.nEnd > b.nEnd;
+            });
+  std::vector<uint64_t> vOpen;
+  std::vector<sRow> vRows;
+  for (const auto& e : vZones) {
+    while (!vOpen.empty() && vOpen.back() <= e.nStart) vOpen.pop_back();
+    uint32_t nDepth = uint32_t(vOpen.size());
+    vOpen.push_back(e.nEnd);
+    auto it = std::find_if(vRows.begin(), vRows.end(), [&](const sRow& r) {
+      return r.nDepth == nDepth && std::strcmp(r.sName, e.sName) == 0;
+    });
+    if (it == vRows.end())
+      vRows.push_back({e.sName, nDepth, e.nEnd - e.nStart, 1});
+    else {
+      it->nTime += e.nEnd - e.nStart;
+      it->nCount++;
+    }
+  }
+
+  const uint8_t nLayer = nTargetLayer;
+  const DecalMode mode = nDecalMode;
+  const DecalStructure structure = nDecalStructure;
+  nTargetLayer = 0;
+  SetDecalMode(DecalMode::NORMAL);
+  SetDecalStructure(DecalStructure::FAN);
+
+  // Names are indented by depth and cut to keep the times lined up, with a
+  // bar for each zone's share of the frame after them
+  const float fFrame = float(frame.nEnd - frame.nStart) * 1e-6f;
+  const float fBarX = 240.0f;
+  const float fBarW = 64.0f;
+  char sLine[64];
+  FillRectDecal({2.0f, 2.0f},
+                {fBarX + fBarW, 12.0f + 10.0f * float(vRows.size())},
+                olc::Pixel(0, 0, 0, 176));
+  std::snprintf(sLine, sizeof(sLine), "Frame %.2f ms", fFrame);
+  DrawStringDecal({4.0f, 4.0f}, sLine, olc::WHITE);
+  float y = 14.0f;
+  for (const auto& r : vRows) {
+    int nIndent = int(std::min(r.nDepth, 8u));
+    int nName = 18 - nIndent;
+    float fTime = float(r.nTime) * 1e-6f;
+    int nLen = std::snprintf(sLine, sizeof(sLine), "%*s%-*.*s%6.2f", nIndent,
+                             "", nName, nName, r.sName, fTime);
+    if (r.nCount > 1 && nLen > 0)
+      std::snprintf(sLine + nLen, sizeof(sLine) - size_t(nLen), " x%u",
+                    unsigned(r.nCount));
+    DrawStringDecal({4.0f, y}, sLine, r.nDepth ? olc::GREY : olc::WHITE);
+    float fWidth = fFrame > 0.0f ? fBarW * std::min(1.0f, fTime / fFrame) : 0;
+    FillRectDecal({fBarX, y}, {std::max(1.0f, fWidth), 7.0f},
+                  r.nDepth ? olc::DARK_CYAN : olc::CYAN);
+    y += 10.0f;
+  }
+
+  nTargetLayer = nLayer;
+  SetDecalMode(mode);
+  SetDecalStructure(structure);
+}
+#endif
+
 void PixelGameEngine::adv_FlushLayerDecals(const size_t nLayerID) {
-  // Display Decals in order for this layer
-  auto& layer = vLayers[nLayerID];
-  for (auto& decal : layer.vecDecalInstance) renderer->DrawDecal(decal);
-  layer.vecDecalInstance.clear();
+  DrawLayerDecals(vLayers[nLayerID]);
 }
 
 void PixelGameEngine::olc_CoreUpdate() {
+  OLC_PROFILE_ZONE("Frame");
+
   // Handle Timing
   m_tp2 = std::chrono::system_clock::now();
   std::chrono::duration<float> elapsedTime = m_tp2 - m_tp1;
@@ -4536,52 +6000,62 @@ void PixelGameEngine::olc_CoreUpdate() {
 
   if (bConsoleSuspendTime) fElapsedTime = 0.0f;
 
-  // Some platforms will need to check for events
-  platform->HandleSystemEvent();
-
-  // Compare hardware input states from previous frame
-  auto ScanHardware = [&](HWButton* pKeys, bool* pStateOld, bool* pStateNew,
-                          uint32_t nKeyCount) {
-    for (uint32_t i = 0; i < nKeyCount; i++) {
-      pKeys[i].bPressed = false;
-      pKeys[i].bReleased = false;
-      if (pStateNew[i] != pStateOld[i]) {
-        if (pStateNew[i]) {
-          pKeys[i].bPressed = !pKeys[i].bHeld;
-          pKeys[i].bHeld = true;
-        } else {
-          pKeys[i].bReleased = true;
-          pKeys[i].bHeld = false;
+  {
+    OLC_PROFILE_ZONE("Input");
+    // Some platforms will need to check for events
+    platform->HandleSystemEvent();
+
+    // Compare hardware input states from previous frame
+    auto ScanHardware = [&](HWButton* pKeys, bool* pStateOld, bool* pStateNew,
+                            uint32_t nKeyCount) {
+      for (uint32_t i = 0; i < nKeyCount; i++) {
+        pKeys[i].bPressed = false;
+        pKeys[i].bReleased = false;
+        if (pStateNew[i] != pStateOld[i]) {
+          if (pStateNew[i]) {
+            pKeys[i].bPressed = !pKeys[i].bHeld;
+            pKeys[i].bHeld = true;
+          } else {
+            pKeys[i].bReleased = true;
+            pKeys[i].bHeld = false;
+          }
         }
+        pStateOld[i] = pStateNew[i];
       }
-      pStateOld[i] = pStateNew[i];
-    }
-  };
+    };
 
-  ScanHardware(pKeyboardState, pKeyOldState, pKeyNewState, 256);
-  ScanHardware(pMouseState, pMouseOldState, pMouseNewState, nMouseButtons);
+    ScanHardware(pKeyboardState, pKeyOldState, pKeyNewState, 256);
+    ScanHardware(pMouseState, pMouseOldState, pMouseNewState, nMouseButtons);
 
-  // Cache mouse coordinates so they remain consistent during frame
-  vMousePos = vMousePosCache;
-  nMouseWheelDelta = nMouseWheelDeltaCache;
-  nMouseWheelDeltaCache = 0;
+    // Cache mouse coordinates so they remain consistent during frame
+    vMousePos = vMousePosCache;
+    nMouseWheelDelta = nMouseWheelDeltaCache;
+    nMouseWheelDeltaCache = 0;
 
-  vDroppedFiles = vDroppedFilesCache;
-  vDroppedFilesPoint = vDroppedFilesPointCache;
-  vDroppedFilesCache.clear();
+    vDroppedFiles = vDroppedFilesCache;
+    vDroppedFilesPoint = vDroppedFilesPointCache;
+    vDroppedFilesCache.clear();
 
-  if (bTextEntryEnable) {
-    UpdateTextEntry();
+    if (bTextEntryEnable) {
+      UpdateTextEntry();
+    }
   }
 
   // Handle Frame Update
   bool bExtensionBlockFrame = false;
-  for (auto& ext : vExtensions)
-    bExtensionBlockFrame |= ext->OnBeforeUserUpdate(fElapsedTime);
+  {
+    OLC_PROFILE_ZONE("OnBeforeUserUpdate");
+    for (auto& ext : vExtensions)
+      bExtensionBlockFrame |= ext->OnBeforeUserUpdate(fElapsedTime);
+  }
   if (!bExtensionBlockFrame) {
+    OLC_PROFILE_ZONE("OnUserUpdate");
     if (!OnUserUpdate(fElapsedTime)) bAtomActive = false;
   }
-  for (auto& ext : vExtensions) ext->OnAfterUserUpdate(fElapsedTime);
+  {
+    OLC_PROFILE_ZONE("OnAfterUserUpdate");
+    for (auto& ext : vExtensions) ext->OnAfterUserUpdate(fElapsedTime);
+  }
 
   if (bRealWindowMode) {
     vPixelSize = {1, 1};
@@ -4591,10 +6065,15 @@ void PixelGameEngine::olc_CoreUpdate() {
 
   if (!bManualRenderEnable) {
     if (bConsoleShow) {
+      OLC_PROFILE_ZONE("Console");
       SetDrawTarget((uint8_t)0);
       UpdateConsole();
     }
 
+#if defined(OLC_PGE_PROFILE)
+    if (bProfilerOverlay) DrawProfilerOverlay();
+#endif
+
     // Display Frame
     renderer->UpdateViewport(vViewPos, vViewSize);
     renderer->ClearBuffer(olc::BLACK, true);
@@ -4610,26 +6089,31 @@ void PixelGameEngine::olc_CoreUpdate() {
         if (layer->funcHook == nullptr) {
           renderer->ApplyTexture(layer->pDrawTarget.Decal()->id);
           if (!bSuspendTextureTransfer && layer->bUpdate) {
-            layer->pDrawTarget.Decal()->Update();
+            OLC_PROFILE_ZONE("TextureUpload");
+            layer->pDrawTarget.Decal()->UpdateDirty();
             layer->bUpdate = false;
           }
 
           renderer->DrawLayerQuad(layer->vOffset, layer->vScale, layer->tint);
 
-          // Display Decals in order for this layer
-          for (auto& decal : layer->vecDecalInstance)
-            renderer->DrawDecal(decal);
-          layer->vecDecalInstance.clear();
+          DrawLayerDecals(*layer);
         } else {
           // Mwa ha ha.... Have Fun!!!
+          OLC_PROFILE_ZONE("LayerHook");
           layer->funcHook();
         }
       }
     }
   }
 
+  decalStatsLast = decalStats;
+  decalStats = {};
+
   // Present Graphics to screen
-  renderer->DisplayFrame();
+  {
+    OLC_PROFILE_ZONE("DisplayFrame");
+    renderer->DisplayFrame();
+  }
 
   if (bResizeRequested) {
     bResizeRequested = false;
@@ -4797,6 +6281,11 @@ class Renderer_Headless : public olc::Renderer {
     return 1;
   };
   virtual void UpdateTexture(uint32_t id, olc::Sprite* spr) {}
+  virtual olc::rcode UpdateTextureRegion(uint32_t id, olc::Sprite* spr,
+                                         const olc::vi2d& pos,
+                                         const olc::vi2d& size) {
+    return olc::rcode::OK;
+  }
   virtual void ReadTexture(uint32_t id, olc::Sprite* spr) {}
   virtual uint32_t DeleteTexture(const uint32_t id) { return 1; }
   virtual void ApplyTexture(uint32_t id) {}
@@ -4804,6 +6293,658 @@ class Renderer_Headless : public olc::Renderer {
   virtual void ClearBuffer(olc::Pixel p, bool bDepth) {}
 };
 #endif
+#if defined(OLC_GFX_SOFTWARE)
+// Composites frames on the CPU into an in-memory framebuffer, so headless
+// runs can benchmark and compare real frames without a GPU. Select it with
+// OLC_GFX_SOFTWARE alongside OLC_PGE_HEADLESS and read frames by
+// PixelGameEngine::GetSoftwareFrame().
+//
+// Draws are queued through the frame and composited when it is displayed,
+// or earlier if a texture changes. The framebuffer is cut into bands of rows
+// composited in parallel, each replaying in order every draw that reaches
+// it, so the result does not depend on the thread count. Triangles use the
+// fixed point coverage and top-left rule of FillTexturedTriangles, and like
+// the GL renderers correct texture coordinates and tints for perspective by
+// w. There is no depth test; LW3D geometry is drawn in the order given.
+class Renderer_Software : public olc::Renderer {
+ public:
+  // nThreads counts the caller; 0 means one per core
+  explicit Renderer_Software(uint32_t nThreads = 0) {
+    if (nThreads == 0)
+      nThreads = std::max(1u, std::thread::hardware_concurrency());
+    nWorkers = nThreads - 1;
+    vScratch.resize(nThreads);
+  }
+
+  ~Renderer_Software() override {
+    {
+      std::scoped_lock lock(mux);
+      bStop = true;
+    }
+    cvWork.notify_all();
+    for (auto& thread : vThreads) thread.join();
+  }
+
+  // The framebuffer, complete once DisplayFrame has returned
+  const olc::Sprite& GetFrame() const { return sprFrame; }
+
+  void PrepareDevice() override {}
+  olc::rcode CreateDevice(std::vector<void*> params, bool bFullScreen,
+                          bool bVSYNC) override {
+    return olc::rcode::OK;
+  }
+  olc::rcode DestroyDevice() override { return olc::rcode::OK; }
+  void DisplayFrame() override { Flush(); }
+  void PrepareDrawing() override { nDecalMode = olc::DecalMode::NORMAL; }
+  void SetDecalMode(const olc::DecalMode& mode) override { nDecalMode = mode; }
+
+  void DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale,
+                     const olc::Pixel tint) override {
+    auto it = mapTextures.find(nBoundTexture);
+    sCommand& cmd = AddCommand(it != mapTextures.end() ? &it->second : nullptr);
+    // Corners in strip order, as the GL renderers draw it
+    const float x[4] = {-1.0f, 1.0f, -1.0f, 1.0f};
+    const float y[4] = {-1.0f, -1.0f, 1.0f, 1.0f};
+    const float u[4] = {0.0f, 1.0f, 0.0f, 1.0f};
+    const float v[4] = {1.0f, 1.0f, 0.0f, 0.0f};
+    uint32_t nBase = uint32_t(vVertices.size());
+    for (int i = 0; i < 4; i++)
+      vVertices.push_back(ToVertex({x[i], y[i]},
+                                   {u[i] * scale.x + offset.x,
+                                    v[i] * scale.y + offset.y},
+                                   1.0f, tint));
+    vTriangleVerts.push_back({nBase, nBase + 1, nBase + 2});
+    vTriangleVerts.push_back({nBase + 2, nBase + 1, nBase + 3});
+    cmd.nCount = 2;
+  }
+
+  void DrawDecal(const olc::DecalInstance& decal) override {
+    SetDecalMode(decal.mode);
+    const sTexture* pTex = nullptr;
+    if (decal.decal != nullptr) {
+      auto it = mapTextures.find(decal.decal->id);
+      if (it != mapTextures.end()) pTex = &it->second;
+    }
+    sCommand& cmd = AddCommand(pTex);
+
+    uint32_t nBase = uint32_t(vVertices.size());
+    for (uint32_t i = 0; i < decal.points; i++)
+      vVertices.push_back(
+          ToVertex(decal.pos[i], decal.uv[i], decal.w[i], decal.tint[i]));
+
+    uint32_t n = decal.points;
+    if (nDecalMode == olc::DecalMode::WIREFRAME) {
+      cmd.bLines = true;
+      cmd.nFirst = uint32_t(vLineVerts.size());
+      for (uint32_t i = 0; n > 1 && i < n; i++)
+        vLineVerts.push_back({nBase + i, nBase + (i + 1) % n});
+      cmd.nCount = uint32_t(vLineVerts.size()) - cmd.nFirst;
+      return;
+    }
+    if (decal.structure == olc::DecalStructure::LIST) {
+      for (uint32_t i = 0; i + 2 < n; i += 3)
+        vTriangleVerts.push_back({nBase + i, nBase + i + 1, nBase + i + 2});
+    } else if (decal.structure == olc::DecalStructure::STRIP) {
+      for (uint32_t i = 2; i < n; i++)
+        vTriangleVerts.push_back({nBase + i - 2, nBase + i - 1, nBase + i});
+    } else {
+      for (uint32_t i = 2; i < n; i++)
+        vTriangleVerts.push_back({nBase, nBase + i - 1, nBase + i});
+    }
+    cmd.nCount = uint32_t(vTriangleVerts.size()) - cmd.nFirst;
+  }
+
+  uint32_t CreateTexture(const uint32_t width, const uint32_t height,
+                         const bool filtered, const bool clamp) override {
+    uint32_t id = nNextTexture++;
+    sTexture& tex = mapTextures[id];
+    tex.image.SetSize(int32_t(width), int32_t(height));
+    tex.bFiltered = filtered;
+    tex.bClamp = clamp;
+    return id;
+  }
+
+  // Textures are copies, as on a GPU, so sprites drawn to after their last
+  // upload are still drawn as they were uploaded
+  void UpdateTexture(uint32_t id, olc::Sprite* spr) override {
+    auto it = mapTextures.find(id);
+    if (it == mapTextures.end()) return;
+    Flush();
+    it->second.image.width = spr->width;
+    it->second.image.height = spr->height;
+    it->second.image.pColData = spr->pColData;
+  }
+
+  olc::rcode UpdateTextureRegion(uint32_t id, olc::Sprite* spr,
+                                 const olc::vi2d& pos,
+                                 const olc::vi2d& size) override {
+    auto it = mapTextures.find(id);
+    if (it == mapTextures.end()) return olc::rcode::OK;
+    olc::Sprite& image = it->second.image;
+    olc::vi2d vPos = pos, vSize = size;
+    if (!ClipTextureRegion(spr, {image.width, image.height}, vPos, vSize))
+      return olc::rcode::FAIL;
+    if (vSize.x == 0 || vSize.y == 0) return olc::rcode::OK;
+    Flush();
+    for (int32_t y = vPos.y; y < vPos.y + vSize.y; y++)
+      std::memcpy(image.pColData.data() + y * image.width + vPos.x,
+                  spr->pColData.data() + y * spr->width + vPos.x,
+                  vSize.x * sizeof(olc::Pixel));
+    return olc::rcode::OK;
+  }
+
+  void ReadTexture(uint32_t id, olc::Sprite* spr) override {
+    auto it = mapTextures.find(id);
+    if (it == mapTextures.end()) return;
+    Flush();
+    if (spr->pColData.size() == it->second.image.pColData.size())
+      spr->pColData = it->second.image.pColData;
+  }
+
+  uint32_t DeleteTexture(const uint32_t id) override {
+    Flush();
+    mapTextures.erase(id);
+    return id;
+  }
+
+  void ApplyTexture(uint32_t id) override { nBoundTexture = id; }
+
+  void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override {
+    Flush();
+    vViewPos = pos;
+    vViewSize = size;
+    olc::vi2d vEnd = pos + size;
+    if (vEnd.x > sprFrame.width || vEnd.y > sprFrame.height)
+      sprFrame.SetSize(std::max(vEnd.x, sprFrame.width),
+                       std::max(vEnd.y, sprFrame.height));
+  }
+
+  void ClearBuffer(olc::Pixel p, bool bDepth) override {
+    sCommand& cmd = AddCommand(nullptr);
+    cmd.bClear = true;
+    cmd.pClear = p;
+  }
+
+ private:
+  struct sTexture {
+    olc::Sprite image;
+    bool bFiltered = false;
+    bool bClamp = true;
+  };
+
+  // In framebuffer pixels. Tints are premultiplied by w, so that they
+  // interpolate across the screen the way texture coordinates do.
+  struct sVertex {
+    float x, y;
+    float a[7];  // u, v, w, r, g, b, a
+  };
+
+  struct sCommand {
+    const sTexture* pTex = nullptr;
+    olc::DecalMode mode = olc::DecalMode::NORMAL;
+    // Range of vTriangles, or of vLineVerts when drawing lines
+    uint32_t nFirst = 0;
+    uint32_t nCount = 0;
+    bool bLines = false;
+    bool bClear = false;
+    olc::Pixel pClear;
+  };
+
+  struct sTriangle {
+    // Covered pixels lie within these, inclusive and clipped to the viewport
+    int32_t x0, y0, x1, y1;
+    // Edge functions at the centre of pixel (x0, y0), and their steps
+    int64_t e[3], dex[3], dey[3];
+    // Attributes at the centre of pixel (x0, y0), and their steps
+    float f[7], dfx[7], dfy[7];
+    bool bPerspective;
+    bool bTint;
+  };
+
+  sVertex ToVertex(const olc::vf2d& pos, const olc::vf2d& uv, float w,
+                   olc::Pixel tint) const {
+    sVertex vert;
+    vert.x = vViewPos.x + (pos.x + 1.0f) * 0.5f * vViewSize.x;
+    vert.y = vViewPos.y + (1.0f - pos.y) * 0.5f * vViewSize.y;
+    vert.a[0] = uv.x;
+    vert.a[1] = uv.y;
+    vert.a[2] = w;
+    vert.a[3] = tint.r * w;
+    vert.a[4] = tint.g * w;
+    vert.a[5] = tint.b * w;
+    vert.a[6] = tint.a * w;
+    return vert;
+  }
+
+  sCommand& AddCommand(const sTexture* pTex) {
+    sCommand& cmd = vCommands.emplace_back();
+    cmd.pTex = pTex;
+    cmd.mode = nDecalMode;
+    cmd.nFirst = uint32_t(vTriangleVerts.size());
+    return cmd;
+  }
+
+  static int64_t FloorDiv(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((b - 1 - a) / b);
+  }
+
+  void Setup(const sVertex& v0, const sVertex& v1, const sVertex& v2,
+             sTriangle& tri) const {
+    tri.x0 = 0;
+    tri.x1 = -1;
+    const sVertex* v[3] = {&v0, &v1, &v2};
+    int64_t X[3], Y[3];
+    for (int i = 0; i < 3; i++) {
+      if (!(std::abs(v[i]->x) < 1048576.0f) ||
+          !(std::abs(v[i]->y) < 1048576.0f))
+        return;
+      X[i] = std::llround(v[i]->x * 16.0f);
+      Y[i] = std::llround(v[i]->y * 16.0f);
+    }
+
+    int64_t nArea =
+        (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+    if (nArea == 0) return;
+    if (nArea < 0) {
+      std::swap(v[1], v[2]);
+      std::swap(X[1], X[2]);
+      std::swap(Y[1], Y[2]);
+    }
+
+    // Pixel centres are at 16 * x + 8
+    tri.x0 = int32_t(std::max<int64_t>(
+        vViewPos.x, FloorDiv(std::min({X[0], X[1], X[2]}) + 7, 16)));
+    tri.y0 = int32_t(std::max<int64_t>(
+        vViewPos.y, FloorDiv(std::min({Y[0], Y[1], Y[2]}) + 7, 16)));
+    tri.x1 = int32_t(std::min<int64_t>(
+        std::min(vViewPos.x + vViewSize.x, sprFrame.width) - 1,
+        FloorDiv(std::max({X[0], X[1], X[2]}) - 8, 16)));
+    tri.y1 = int32_t(std::min<int64_t>(
+        std::min(vViewPos.y + vViewSize.y, sprFrame.height) - 1,
+        FloorDiv(std::max({Y[0], Y[1], Y[2]}) - 8, 16)));
+    if (tri.x0 > tri.x1 || tri.y0 > tri.y1) return;
+
+    int64_t nCentreX = int64_t(tri.x0) * 16 + 8;
+    int64_t nCentreY = int64_t(tri.y0) * 16 + 8;
+    for (int i = 0; i < 3; i++) {
+      int j = (i + 1) % 3, k = (i + 2) % 3;
+      int64_t dx = X[k] - X[j], dy = Y[k] - Y[j];
+      bool bTopLeft = dy < 0 || (dy == 0 && dx > 0);
+      tri.e[i] = dx * (nCentreY - Y[j]) - dy * (nCentreX - X[j]) -
+                 (bTopLeft ? 0 : 1);
+      tri.dex[i] = -dy * 16;
+      tri.dey[i] = dx * 16;
+    }
+
+    float x[3], y[3];
+    for (int i = 0; i < 3; i++) {
+      x[i] = float(X[i]) / 16.0f;
+      y[i] = float(Y[i]) / 16.0f;
+    }
+    float fDet = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    float fX = tri.x0 + 0.5f - x[0], fY = tri.y0 + 0.5f - y[0];
+    for (int n = 0; n < 7; n++) {
+      float d1 = v[1]->a[n] - v[0]->a[n], d2 = v[2]->a[n] - v[0]->a[n];
+      tri.dfx[n] = (d1 * (y[2] - y[0]) - d2 * (y[1] - y[0])) / fDet;
+      tri.dfy[n] = (d2 * (x[1] - x[0]) - d1 * (x[2] - x[0])) / fDet;
+      tri.f[n] = v[0]->a[n] + tri.dfx[n] * fX + tri.dfy[n] * fY;
+    }
+    tri.bPerspective = false;
+    tri.bTint = false;
+    for (int i = 0; i < 3; i++) {
+      tri.bPerspective |= v[i]->a[2] != 1.0f;
+      for (int n = 3; n < 7; n++) tri.bTint |= v[i]->a[n] != 255.0f;
+    }
+  }
+
+  // n / 255, rounded, for n up to 255 * 255
+  static uint32_t Div255(uint32_t n) {
+    n += 128;
+    return (n + (n >> 8)) >> 8;
+  }
+
+  static uint8_t Mul8(uint32_t a, uint32_t b) { return uint8_t(Div255(a * b)); }
+
+  static uint8_t ToByte(float f) {
+    return uint8_t(std::min(255.0f, std::max(0.0f, f + 0.5f)));
+  }
+
+  static olc::Pixel SampleNearest(const sTexture& tex, float u, float v) {
+    const olc::Sprite& image = tex.image;
+    int32_t x = int32_t(std::floor(u * image.width));
+    int32_t y = int32_t(std::floor(v * image.height));
+    if (tex.bClamp) {
+      x = std::max(0, std::min(x, image.width - 1));
+      y = std::max(0, std::min(y, image.height - 1));
+    } else {
+      x = ((x % image.width) + image.width) % image.width;
+      y = ((y % image.height) + image.height) % image.height;
+    }
+    return image.pColData[size_t(y) * image.width + x];
+  }
+
+  // Texel times tint at the given attributes, which are already divided
+  // through by w
+  static olc::Pixel Fragment(const sTexture* pTex, const float* a) {
+    olc::Pixel p = olc::WHITE;
+    if (pTex != nullptr && pTex->image.width > 0 && pTex->image.height > 0) {
+      if (pTex->bFiltered)
+        simd::SampleBL(&p, 1, pTex->image.pColData.data(), pTex->image.width,
+                       pTex->image.height, a[0], a[1], 0.0f, 0.0f);
+      else
+        p = SampleNearest(*pTex, a[0], a[1]);
+    }
+    return olc::Pixel(Mul8(p.r, ToByte(a[3])), Mul8(p.g, ToByte(a[4])),
+                      Mul8(p.b, ToByte(a[5])), Mul8(p.a, ToByte(a[6])));
+  }
+
+  // Writes the colours of n pixels of row y from x, before blending
+  static void ShadeSpan(const sTexture* pTex, const sTriangle& tri, int32_t x,
+                        int32_t y, int32_t n, olc::Pixel* pOut) {
+    float a[7];
+    float fX = float(x - tri.x0), fY = float(y - tri.y0);
+    for (int k = 0; k < 7; k++)
+      a[k] = tri.f[k] + tri.dfx[k] * fX + tri.dfy[k] * fY;
+
+    if (tri.bPerspective) {
+      for (int32_t i = 0; i < n; i++) {
+        float fInvW = 1.0f / a[2];
+        float b[7];
+        for (int k = 0; k < 7; k++) b[k] = a[k] * fInvW;
+        pOut[i] = Fragment(pTex, b);
+        for (int k = 0; k < 7; k++) a[k] += tri.dfx[k];
+      }
+      return;
+    }
+
+    bool bTexture =
+        pTex != nullptr && pTex->image.width > 0 && pTex->image.height > 0;
+    if (!bTexture) {
+      std::fill_n(pOut, n, olc::WHITE);
+    } else if (pTex->bFiltered) {
+      simd::SampleBL(pOut, n, pTex->image.pColData.data(), pTex->image.width,
+                     pTex->image.height, a[0], a[1], tri.dfx[0], tri.dfx[1]);
+    } else {
+      // Spans that stay inside the texture step through it in 16.16 fixed
+      // point, with no edges to handle
+      const olc::Sprite& image = pTex->image;
+      int64_t u = int64_t(a[0] * image.width * 65536.0f);
+      int64_t v = int64_t(a[1] * image.height * 65536.0f);
+      int64_t du = int64_t(tri.dfx[0] * image.width * 65536.0f);
+      int64_t dv = int64_t(tri.dfx[1] * image.height * 65536.0f);
+      int64_t uEnd = u + du * (n - 1), vEnd = v + dv * (n - 1);
+      if (std::min(u, uEnd) >= 0 && std::min(v, vEnd) >= 0 &&
+          std::max(u, uEnd) < int64_t(image.width) << 16 &&
+          std::max(v, vEnd) < int64_t(image.height) << 16) {
+        const olc::Pixel* pTexels = image.pColData.data();
+        for (int32_t i = 0; i < n; i++) {
+          pOut[i] = pTexels[(v >> 16) * image.width + (u >> 16)];
+          u += du;
+          v += dv;
+        }
+      } else {
+        float fu = a[0], fv = a[1];
+        for (int32_t i = 0; i < n; i++) {
+          pOut[i] = SampleNearest(*pTex, fu, fv);
+          fu += tri.dfx[0];
+          fv += tri.dfx[1];
+        }
+      }
+    }
+
+    if (tri.bTint)
+      for (int32_t i = 0; i < n; i++) {
+        pOut[i] = olc::Pixel(
+            Mul8(pOut[i].r, ToByte(a[3])), Mul8(pOut[i].g, ToByte(a[4])),
+            Mul8(pOut[i].b, ToByte(a[5])), Mul8(pOut[i].a, ToByte(a[6])));
+        for (int k = 3; k < 7; k++) a[k] += tri.dfx[k];
+      }
+  }
+
+  // Each channel of s over d by f(s, d, alpha of s)
+  template <typename F>
+  static olc::Pixel Combine(olc::Pixel s, olc::Pixel d, F f) {
+    return olc::Pixel(f(s.r, d.r, s.a), f(s.g, d.g, s.a), f(s.b, d.b, s.a),
+                      f(s.a, d.a, s.a));
+  }
+
+  template <typename F>
+  static void BlendEach(olc::Pixel* pDst, const olc::Pixel* pSrc, int32_t n,
+                        F f) {
+    for (int32_t i = 0; i < n; i++) pDst[i] = Combine(pSrc[i], pDst[i], f);
+  }
+
+  // The blend functions the GL renderers set for each mode, in 8 bits
+  static void BlendSpan(olc::DecalMode mode, olc::Pixel* pDst,
+                        const olc::Pixel* pSrc, int32_t n) {
+    switch (mode) {
+      case olc::DecalMode::NORMAL:
+      case olc::DecalMode::WIREFRAME:
+        // Two channels at a time, 16 bits apart
+        for (int32_t i = 0; i < n; i++) {
+          uint32_t a = pSrc[i].a, ia = 255 - a;
+          if (a == 255) {
+            pDst[i] = pSrc[i];
+          } else if (a != 0) {
+            uint32_t s = pSrc[i].n, d = pDst[i].n;
+            uint32_t rb = (s & 0xFF00FF) * a + (d & 0xFF00FF) * ia + 0x800080;
+            uint32_t ga = ((s >> 8) & 0xFF00FF) * a +
+                          ((d >> 8) & 0xFF00FF) * ia + 0x800080;
+            rb = ((rb + ((rb >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+            ga = ((ga + ((ga >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+            pDst[i].n = rb | (ga << 8);
+          }
+        }
+        break;
+      case olc::DecalMode::ADDITIVE:
+        BlendEach(pDst, pSrc, n, [](uint32_t s, uint32_t d, uint32_t a) {
+          return std::min(255u, d + Div255(s * a));
+        });
+        break;
+      case olc::DecalMode::MULTIPLICATIVE:
+        BlendEach(pDst, pSrc, n, [](uint32_t s, uint32_t d, uint32_t a) {
+          return std::min(255u, Div255(s * d) + Div255(d * (255 - a)));
+        });
+        break;
+      case olc::DecalMode::STENCIL:
+        BlendEach(pDst, pSrc, n, [](uint32_t s, uint32_t d, uint32_t a) {
+          return Div255(d * a);
+        });
+        break;
+      case olc::DecalMode::ILLUMINATE:
+        BlendEach(pDst, pSrc, n, [](uint32_t s, uint32_t d, uint32_t a) {
+          return Div255(s * (255 - a) + d * a);
+        });
+        break;
+    }
+  }
+
+  void DrawTriangleRows(const sCommand& cmd, const sTriangle& tri,
+                        int32_t nTop, int32_t nBottom, olc::Pixel* pScratch) {
+    int32_t y0 = std::max(tri.y0, nTop), y1 = std::min(tri.y1, nBottom - 1);
+    for (int32_t y = y0; y <= y1; y++) {
+      // Where the row is inside all three edges
+      int64_t nLo = 0, nHi = tri.x1 - tri.x0;
+      for (int i = 0; i < 3 && nLo <= nHi; i++) {
+        int64_t e = tri.e[i] + tri.dey[i] * (y - tri.y0);
+        if (tri.dex[i] > 0)
+          nLo = std::max(nLo, FloorDiv(-e + tri.dex[i] - 1, tri.dex[i]));
+        else if (tri.dex[i] < 0)
+          nHi = std::min(nHi, FloorDiv(e, -tri.dex[i]));
+        else if (e < 0)
+          nHi = -1;
+      }
+      if (nLo > nHi) continue;
+
+      int32_t x = tri.x0 + int32_t(nLo), n = int32_t(nHi - nLo + 1);
+      ShadeSpan(cmd.pTex, tri, x, y, n, pScratch);
+      olc::Pixel* pRow = sprFrame.pColData.data() + size_t(y) * sprFrame.width;
+      BlendSpan(cmd.mode, pRow + x, pScratch, n);
+    }
+  }
+
+  // Steps a pixel at a time along the longer axis, leaving out the end
+  // pixel so that the segments of a loop meet without overlapping
+  void DrawLineRows(const sCommand& cmd, const sVertex& v0, const sVertex& v1,
+                    int32_t nTop, int32_t nBottom) {
+    float dx = v1.x - v0.x, dy = v1.y - v0.y;
+    if (!(std::abs(dx) < 1048576.0f) || !(std::abs(dy) < 1048576.0f)) return;
+    int32_t nSteps = int32_t(std::ceil(std::max(std::abs(dx), std::abs(dy))));
+    int32_t nLeft = std::max(0, vViewPos.x);
+    int32_t nRight = std::min(vViewPos.x + vViewSize.x, sprFrame.width);
+    nTop = std::max(nTop, vViewPos.y);
+    nBottom = std::min(nBottom, vViewPos.y + vViewSize.y);
+    for (int32_t i = 0; i < nSteps; i++) {
+      float t = float(i) / float(nSteps);
+      int32_t x = int32_t(std::floor(v0.x + dx * t));
+      int32_t y = int32_t(std::floor(v0.y + dy * t));
+      if (x < nLeft || x >= nRight || y < nTop || y >= nBottom) continue;
+      float a[7];
+      for (int k = 0; k < 7; k++) a[k] = v0.a[k] + (v1.a[k] - v0.a[k]) * t;
+      float fInvW = 1.0f / a[2];
+      for (int k = 0; k < 7; k++) a[k] *= fInvW;
+      olc::Pixel p = Fragment(cmd.pTex, a);
+      olc::Pixel* pRow = sprFrame.pColData.data() + size_t(y) * sprFrame.width;
+      BlendSpan(cmd.mode, pRow + x, &p, 1);
+    }
+  }
+
+  void DrawBand(uint32_t nBand, uint32_t nWorker) {
+    int32_t nTop = int32_t(nBand) * nBandHeight;
+    int32_t nBottom = std::min(nTop + nBandHeight, sprFrame.height);
+    std::vector<olc::Pixel>& vRow = vScratch[nWorker];
+    vRow.resize(sprFrame.width);
+    for (const sCommand& cmd : vCommands) {
+      if (cmd.bClear) {
+        std::fill(sprFrame.pColData.begin() + size_t(nTop) * sprFrame.width,
+                  sprFrame.pColData.begin() + size_t(nBottom) * sprFrame.width,
+                  cmd.pClear);
+      } else if (cmd.bLines) {
+        for (uint32_t i = cmd.nFirst; i < cmd.nFirst + cmd.nCount; i++)
+          DrawLineRows(cmd, vVertices[vLineVerts[i][0]],
+                       vVertices[vLineVerts[i][1]], nTop, nBottom);
+      } else {
+        for (uint32_t i = cmd.nFirst; i < cmd.nFirst + cmd.nCount; i++) {
+          const sTriangle& tri = vTriangles[i];
+          if (tri.x0 <= tri.x1 && tri.y0 < nBottom && tri.y1 >= nTop)
+            DrawTriangleRows(cmd, tri, nTop, nBottom, vRow.data());
+        }
+      }
+    }
+  }
+
+  // Composites everything queued so far into the framebuffer
+  void Flush() {
+    if (vCommands.empty()) return;
+    if (sprFrame.width > 0 && sprFrame.height > 0) {
+      constexpr uint32_t nSetupChunk = 1024;
+      vTriangles.resize(vTriangleVerts.size());
+      RunParallel(uint32_t((vTriangles.size() + nSetupChunk - 1) / nSetupChunk),
+                  [this](uint32_t nChunk, uint32_t) {
+                    size_t nEnd = std::min(vTriangles.size(),
+                                           size_t(nChunk + 1) * nSetupChunk);
+                    for (size_t i = size_t(nChunk) * nSetupChunk; i < nEnd; i++)
+                      Setup(vVertices[vTriangleVerts[i][0]],
+                            vVertices[vTriangleVerts[i][1]],
+                            vVertices[vTriangleVerts[i][2]], vTriangles[i]);
+                  });
+
+      // A few bands a thread evens out uneven ones
+      uint32_t nBands = std::min<uint32_t>((nWorkers + 1) * 4,
+                                           uint32_t(sprFrame.height + 7) / 8);
+      nBandHeight = int32_t((uint32_t(sprFrame.height) + nBands - 1) / nBands);
+      nBands = uint32_t((sprFrame.height + nBandHeight - 1) / nBandHeight);
+      RunParallel(nBands, [this](uint32_t nBand, uint32_t nWorker) {
+        DrawBand(nBand, nWorker);
+      });
+    }
+    vCommands.clear();
+    vVertices.clear();
+    vTriangleVerts.clear();
+    vLineVerts.clear();
+    vTriangles.clear();
+  }
+
+  // Calls job(item, worker) for items 0 to nItems - 1 across the threads
+  void RunParallel(uint32_t nItems,
+                   const std::function<void(uint32_t, uint32_t)>& job) {
+    pJob = &job;
+    nJobItems = nItems;
+    nNextItem = 0;
+    if (nWorkers == 0 || nItems < 2) {
+      TakeItems(0);
+      return;
+    }
+    {
+      std::scoped_lock lock(mux);
+      if (vThreads.empty())
+        for (uint32_t i = 0; i < nWorkers; i++)
+          vThreads.emplace_back([this, i]() { WorkerLoop(i + 1); });
+      nGeneration++;
+      nBusy = nWorkers;
+    }
+    cvWork.notify_all();
+    TakeItems(0);
+    std::unique_lock lock(mux);
+    cvDone.wait(lock, [this]() { return nBusy == 0; });
+  }
+
+  void TakeItems(uint32_t nWorker) {
+    for (uint32_t n = nNextItem++; n < nJobItems; n = nNextItem++)
+      (*pJob)(n, nWorker);
+  }
+
+  void WorkerLoop(uint32_t nWorker) {
+    uint64_t nSeen = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mux);
+        cvWork.wait(lock, [&]() { return bStop || nGeneration != nSeen; });
+        if (bStop) return;
+        nSeen = nGeneration;
+      }
+      TakeItems(nWorker);
+      std::scoped_lock lock(mux);
+      if (--nBusy == 0) cvDone.notify_one();
+    }
+  }
+
+  olc::Sprite sprFrame;
+  olc::vi2d vViewPos = {0, 0};
+  olc::vi2d vViewSize = {0, 0};
+  olc::DecalMode nDecalMode = olc::DecalMode::NORMAL;
+
+  std::map<uint32_t, sTexture> mapTextures;
+  uint32_t nNextTexture = 1;
+  uint32_t nBoundTexture = 0;
+
+  // The frame queued so far
+  std::vector<sCommand> vCommands;
+  std::vector<sVertex> vVertices;
+  std::vector<std::array<uint32_t, 3>> vTriangleVerts;
+  std::vector<std::array<uint32_t, 2>> vLineVerts;
+  std::vector<sTriangle> vTriangles;
+  int32_t nBandHeight = 0;
+  // A row of shaded pixels per thread
+  std::vector<std::vector<olc::Pixel>> vScratch;
+
+  uint32_t nWorkers = 0;
+  std::vector<std::thread> vThreads;
+  const std::function<void(uint32_t, uint32_t)>* pJob = nullptr;
+  uint32_t nJobItems = 0;
+  std::atomic<uint32_t> nNextItem{0};
+  std::mutex mux;
+  std::condition_variable cvWork, cvDone;
+  uint64_t nGeneration = 0;
+  uint32_t nBusy = 0;
+  bool bStop = false;
+};
+
+const olc::Sprite& PixelGameEngine::GetSoftwareFrame() const {
+  return static_cast<const olc::Renderer_Software*>(renderer.get())
+      ->GetFrame();
+}
+#endif
 #if defined(OLC_PLATFORM_HEADLESS)
 class Platform_Headless : public olc::Platform {
  public:
@@ -4959,6 +7100,8 @@ class Renderer_OGL10 : public olc::Renderer {
   bool bSync = false;
   olc::DecalMode nDecalMode = olc::DecalMode(-1);  // Thanks Gusgo & Bispoo
   olc::DecalStructure nDecalStructure = olc::DecalStructure(-1);
+  // Size each texture was last given by UpdateTexture
+  std::map<uint32_t, olc::vi2d> mapTextureSize;
 #if defined(OLC_PLATFORM_X11)
   X11::Display* olc_Display = nullptr;
   X11::Window* olc_Window = nullptr;
@@ -5243,13 +7386,31 @@ class Renderer_OGL10 : public olc::Renderer {
 
   uint32_t DeleteTexture(const uint32_t id) override {
     glDeleteTextures(1, &id);
+    mapTextureSize.erase(id);
     return id;
   }
 
   void UpdateTexture(uint32_t id, olc::Sprite* spr) override {
-    UNUSED(id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA,
                  GL_UNSIGNED_BYTE, spr->GetData());
+    mapTextureSize[id] = {spr->width, spr->height};
+  }
+
+  olc::rcode UpdateTextureRegion(uint32_t id, olc::Sprite* spr,
+                                 const olc::vi2d& pos,
+                                 const olc::vi2d& size) override {
+    auto it = mapTextureSize.find(id);
+    olc::vi2d vPos = pos, vSize = size;
+    if (it == mapTextureSize.end() ||
+        !ClipTextureRegion(spr, it->second, vPos, vSize))
+      return olc::rcode::FAIL;
+    if (vSize.x == 0 || vSize.y == 0) return olc::rcode::OK;
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, spr->width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, vPos.x, vPos.y, vSize.x, vSize.y,
+                    GL_RGBA, GL_UNSIGNED_BYTE,
+                    spr->GetData() + size_t(vPos.y) * spr->width + vPos.x);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return olc::rcode::OK;
   }
 
   void ReadTexture(uint32_t id, olc::Sprite* spr) override {
@@ -5391,6 +7552,8 @@ class Renderer_OGL33 : public olc::Renderer {
 #endif
   bool bSync = false;
   olc::DecalMode nDecalMode = olc::DecalMode(-1);  // Thanks Gusgo & Bispoo
+  // Size each texture was last given by UpdateTexture
+  std::map<uint32_t, olc::vi2d> mapTextureSize;
 #if defined(OLC_PLATFORM_X11)
   X11::Display* olc_Display = nullptr;
   X11::Window* olc_Window = nullptr;
@@ -5430,6 +7593,7 @@ class Renderer_OGL33 : public olc::Renderer {
   };
 
   locVertex pVertexMem[OLC_MAX_VERTS];
+  std::vector<locVertex> vBatchVertexMem;
 
   olc::Renderable rendBlankQuad;
 
@@ -5802,6 +7966,27 @@ class Renderer_OGL33 : public olc::Renderer {
     }
   }
 
+  void DrawDecalBatch(const olc::DecalInstance& batch) override {
+    SetDecalMode(batch.mode);
+    if (batch.decal == nullptr)
+      glBindTexture(GL_TEXTURE_2D, rendBlankQuad.Decal()->id);
+    else
+      glBindTexture(GL_TEXTURE_2D, batch.decal->id);
+
+    locBindBuffer(0x8892, m_vbQuad);
+
+    // Too big for pVertexMem, the buffer is grown to fit instead
+    vBatchVertexMem.resize(batch.points);
+    for (uint32_t i = 0; i < batch.points; i++)
+      vBatchVertexMem[i] = {{batch.pos[i].x, batch.pos[i].y, batch.w[i]},
+                            {batch.uv[i].x, batch.uv[i].y},
+                            batch.tint[i]};
+
+    locBufferData(0x8892, sizeof(locVertex) * batch.points,
+                  vBatchVertexMem.data(), 0x88E0);
+    glDrawArrays(GL_TRIANGLES, 0, batch.points);
+  }
+
   uint32_t CreateTexture(const uint32_t width, const uint32_t height,
                          const bool filtered, const bool clamp) override {
     UNUSED(width);
@@ -5833,13 +8018,38 @@ class Renderer_OGL33 : public olc::Renderer {
 
   uint32_t DeleteTexture(const uint32_t id) override {
     glDeleteTextures(1, &id);
+    mapTextureSize.erase(id);
     return id;
   }
 
   void UpdateTexture(uint32_t id, olc::Sprite* spr) override {
-    UNUSED(id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA,
                  GL_UNSIGNED_BYTE, spr->GetData());
+    mapTextureSize[id] = {spr->width, spr->height};
+  }
+
+  olc::rcode UpdateTextureRegion(uint32_t id, olc::Sprite* spr,
+                                 const olc::vi2d& pos,
+                                 const olc::vi2d& size) override {
+    auto it = mapTextureSize.find(id);
+    olc::vi2d vPos = pos, vSize = size;
+    if (it == mapTextureSize.end() ||
+        !ClipTextureRegion(spr, it->second, vPos, vSize))
+      return olc::rcode::FAIL;
+    if (vSize.x == 0 || vSize.y == 0) return olc::rcode::OK;
+#if defined(OLC_PLATFORM_EMSCRIPTEN)
+    // GLES2 cannot skip along a row, so whole rows are sent
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, vPos.y, spr->width, vSize.y, GL_RGBA,
+                    GL_UNSIGNED_BYTE,
+                    spr->GetData() + size_t(vPos.y) * spr->width);
+#else
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, spr->width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, vPos.x, vPos.y, vSize.x, vSize.y,
+                    GL_RGBA, GL_UNSIGNED_BYTE,
+                    spr->GetData() + size_t(vPos.y) * spr->width + vPos.x);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+    return olc::rcode::OK;
   }
 
   void ReadTexture(uint32_t id, olc::Sprite* spr) override {
@@ -7756,6 +9966,10 @@ void PixelGameEngine::olc_ConfigureSystem() {
   renderer = std::make_unique<olc::Renderer_Headless>();
 #endif
 
+#if defined(OLC_GFX_SOFTWARE)
+  renderer = std::make_unique<olc::Renderer_Software>();
+#endif
+
 #if defined(OLC_GFX_OPENGL10)
   renderer = std::make_unique<olc::Renderer_OGL10>();
 #endif